@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "generators.hpp"
+#include "geometry/matrix.hpp"
+#include "geometry/morton.hpp"
+#include "geometry/narrow_phase.hpp"
+#include "geometry/predicates.hpp"
+#include "geometry/prepared_triangle.hpp"
+#include "geometry/sweep_and_prune.hpp"
+#include "utils/benchmark.hpp"
+
+namespace {
+
+using namespace cpp_contests;
+
+struct Options {
+  std::size_t max_size = 100'000;
+  std::size_t repeats = 20;
+  std::string filter;
+  std::optional<std::string> json;
+  bool counters = false;
+};
+
+// Runs benchmarks, which names contain the filter, by the utils harness and
+// prints a table of them. Every benchmark is warmed up and timed in repeats
+// samples of calibrated iterations. Samples stop early, when they take
+// longer than the budget, and a first run longer than the budget is not
+// repeated at all, so the largest scenes take a few runs rather than
+// minutes.
+class Runner final {
+  Options options_;
+  Benchmarker benchmarker_;
+
+public:
+  explicit Runner(Options options)
+      : options_(std::move(options)),
+        benchmarker_(BenchmarkOptions{.samples = options_.repeats,
+                                      .counters = options_.counters}) {}
+
+  [[nodiscard]] bool enabled(std::string_view name) const noexcept {
+    return name.find(options_.filter) != std::string_view::npos;
+  }
+  [[nodiscard]] Options const &options() const noexcept { return options_; }
+
+  // Scenes of different sizes are told apart by the size suffix of names,
+  // zero size stands for fixed-size kernels
+  template <typename F>
+  void run(std::string name, std::size_t size, std::size_t items,
+           std::string_view unit, F const &f) {
+    if (!enabled(name) || items == 0)
+      return;
+    if (size != 0)
+      name = fmt::format("{}/{}", name, size);
+    auto const &result = benchmarker_.run(std::move(name), items, f);
+    auto scale = 1.0 / static_cast<double>(items);
+    fmt::print("{:<44} {:>12.2f} ns/{:<9} -+{:>5.1f}% {:>14.0f} {}/s\n",
+               result.name, result.median * scale, unit,
+               100 * (result.median_high - result.median_low) / 2 /
+                   result.median,
+               1e9 / (result.median * scale), unit);
+    std::fflush(stdout);
+  }
+
+  void write_json(std::ostream &out) const { benchmarker_.write_json(out); }
+};
+
+// The HW3D pipeline as in the command line tool: Morton reordering, sweep and
+// prune over boxes, then the exact narrow phase over candidate pairs on the
+// default pool. Phases are timed separately, the whole pipeline takes their
+// sum.
+template <GeometryScalar T>
+void pipeline_benchmarks(Runner &runner, std::string_view precision) {
+  for (auto const &generator : scene_generators<T>) {
+    auto prefix = fmt::format("pipeline{}/{}", precision, generator.name);
+    if (!runner.enabled(prefix))
+      continue;
+    for (std::size_t size = 1000; size <= runner.options().max_size;
+         size *= 10) {
+      auto input = generator.generate(size, 0);
+      auto input_span = std::span<BasicTriangle<T> const>{input};
+      runner.run(prefix + "/morton", input.size(), input.size(), "triangle",
+                 [&] { return morton_sorted(input_span).original.front(); });
+      auto triangles = morton_sorted(input_span).triangles;
+      auto span = std::span<BasicTriangle<T> const>{triangles};
+      auto boxes = std::vector<BasicBox<T>>{};
+      for (auto const &t : triangles)
+        boxes.push_back(bounding_box(t));
+      auto box_span = std::span<BasicBox<T> const>{boxes};
+      auto candidates = std::vector<IndexPair>{};
+      auto broad = [&] {
+        candidates.clear();
+        sweep(box_span, [&](std::size_t i, std::size_t j) {
+          candidates.emplace_back(i, j);
+        });
+        return candidates.size();
+      };
+      auto narrow = [&] {
+        return intersected_triangles(candidates, span).size();
+      };
+      broad();
+      runner.run(prefix + "/broad", triangles.size(), triangles.size(),
+                 "triangle", broad);
+      runner.run(prefix + "/narrow", triangles.size(), candidates.size(),
+                 "pair", narrow);
+    }
+  }
+}
+
+void predicate_benchmarks(Runner &runner) {
+  constexpr std::size_t count = 1 << 14;
+  auto gen = std::mt19937_64{0};
+  auto points = std::vector<Point>{};
+  for (std::size_t i = 0; i < count + 3; ++i)
+    points.push_back(details_::uniform_point(gen, -1.0, 1.0));
+  runner.run("predicates/orient3d", 0, count, "call", [&] {
+    auto sum = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      sum += orient3d(points[i], points[i + 1], points[i + 2], points[i + 3]);
+    return sum;
+  });
+  // Points on a plane, which rounding of the fast filter can not decide
+  auto planar = std::vector<Point>{};
+  for (auto const &p : points)
+    planar.push_back(Point{p[0], p[1], 0.1 * p[0] + 0.3 * p[1]});
+  runner.run("predicates/orient3d_degenerate", 0, count, "call", [&] {
+    auto sum = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      sum += orient3d(planar[i], planar[i + 1], planar[i + 2], planar[i + 3]);
+    return sum;
+  });
+
+  // Candidate pairs of typical scenes, including the near-complanar one
+  auto size = std::min<std::size_t>(10'000, runner.options().max_size);
+  for (auto name : {"soup", "sheets", "slivers"}) {
+    auto const &generator = *std::ranges::find(
+        scene_generators<double>, std::string_view{name},
+        &SceneGenerator<double>::name);
+    auto triangles = generator.generate(size, 0);
+    auto boxes = std::vector<Box>{};
+    for (auto const &t : triangles)
+      boxes.push_back(bounding_box(t));
+    auto pairs = std::vector<IndexPair>{};
+    sweep(std::span<Box const>{boxes},
+          [&](std::size_t i, std::size_t j) { pairs.emplace_back(i, j); });
+    runner.run(fmt::format("predicates/intersects/{}", name), 0, pairs.size(),
+               "pair", [&] {
+                 auto hits = std::size_t{0};
+                 for (auto [i, j] : pairs)
+                   hits += intersects(triangles[i], triangles[j]);
+                 return hits;
+               });
+    auto prepared = std::vector<PreparedTriangle>{};
+    for (auto const &t : triangles)
+      prepared.emplace_back(t);
+    runner.run(fmt::format("predicates/intersects_prepared/{}", name), 0,
+               pairs.size(), "pair", [&] {
+                 auto hits = std::size_t{0};
+                 for (auto [i, j] : pairs)
+                   hits += intersects(prepared[i], prepared[j]);
+                 return hits;
+               });
+  }
+}
+
+void matrix_benchmarks(Runner &runner) {
+  constexpr std::size_t count = 1 << 12;
+  auto gen = std::mt19937_64{1};
+  auto points = std::vector<Point>{};
+  auto matrices = std::vector<Matrix<3, 3, double>>{};
+  auto big = std::vector<Matrix<4, 4, double>>{};
+  for (std::size_t i = 0; i < count + 1; ++i) {
+    auto m = Matrix<3, 3, double>{};
+    auto b = Matrix<4, 4, double>{};
+    for (auto &x : m)
+      x = details_::uniform(gen, -1.0, 1.0);
+    for (auto &x : b)
+      x = details_::uniform(gen, -1.0, 1.0);
+    points.push_back(details_::uniform_point(gen, -1.0, 1.0));
+    matrices.push_back(m);
+    big.push_back(b);
+  }
+  auto kernel = [&](std::string_view name, auto const &f) {
+    runner.run(fmt::format("matrix/{}", name), 0, count, "call", [&] {
+      auto sum = 0.0;
+      for (std::size_t i = 0; i < count; ++i)
+        sum += f(i);
+      return sum;
+    });
+  };
+  kernel("dot3", [&](std::size_t i) { return dot(points[i], points[i + 1]); });
+  kernel("cross3", [&](std::size_t i) {
+    return cross(points[i], points[i + 1])[0];
+  });
+  kernel("norm3", [&](std::size_t i) { return n(points[i]); });
+  // Generic loops, which dot and norm of small vectors are unrolled from,
+  // for comparison
+  auto loop_dot = [](Point const &a, Point const &b) {
+    auto sum = 0.0;
+    for (std::size_t c = 0; c < 3; ++c)
+      sum += a[c] * b[c];
+    return sum;
+  };
+  kernel("dot3_loop",
+         [&](std::size_t i) { return loop_dot(points[i], points[i + 1]); });
+  kernel("norm3_loop", [&](std::size_t i) {
+    return std::sqrt(loop_dot(points[i], points[i]));
+  });
+  kernel("transpose3", [&](std::size_t i) { return t(points[i])[i % 3]; });
+  kernel("mul3x3", [&](std::size_t i) {
+    return Matrix<3, 3, double>{matrices[i] * matrices[i + 1]}[1, 1];
+  });
+  kernel("transpose4x4",
+         [&](std::size_t i) { return transpose(big[i])[0, 1]; });
+  kernel("det3x3", [&](std::size_t i) { return det(matrices[i]); });
+  kernel("det4x4", [&](std::size_t i) { return det(big[i]); });
+  kernel("solve3x3", [&](std::size_t i) {
+    return solve(matrices[i], points[i])[0];
+  });
+}
+
+std::optional<std::size_t> parse_size(std::string_view text) {
+  auto value = std::size_t{0};
+  auto [end, ec] = std::from_chars(text.begin(), text.end(), value);
+  if (ec != std::errc{} || end != text.end())
+    return std::nullopt;
+  return value;
+}
+
+} // namespace
+
+// Usage: geometry_benchmarks [--max-size N] [--repeats R] [--filter text]
+//                            [--json file] [--counters]
+// Times the triangle intersection pipeline on synthetic scenes of 1e3 to
+// max-size triangles (1e5 by default, pass 1000000 for the largest scenes),
+// the primitive predicates and the matrix kernels. Prints a table of median
+// ns per item with the half width of its confidence interval and items per
+// second, and writes all results as JSON, if the file is given, to compare
+// them between commits. Hardware counters are added to JSON with
+// --counters, where perf events are available.
+int main(int argc, char **argv) {
+  auto args = std::vector<std::string_view>(argv + 1, argv + argc);
+  auto options = Options{};
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    auto value = i + 1 < args.size() ? args[i + 1] : std::string_view{};
+    auto size = parse_size(value);
+    if (args[i] == "--max-size" && size) {
+      options.max_size = *size;
+    } else if (args[i] == "--repeats" && size && *size > 0) {
+      options.repeats = *size;
+    } else if (args[i] == "--filter" && i + 1 < args.size()) {
+      options.filter = value;
+    } else if (args[i] == "--json" && i + 1 < args.size()) {
+      options.json = std::string{value};
+    } else if (args[i] == "--counters") {
+      options.counters = true;
+      continue;
+    } else {
+      std::cerr << "Unknown or invalid option '" << args[i] << "'\n";
+      return 1;
+    }
+    ++i;
+  }
+
+  try {
+    auto runner = Runner{options};
+    pipeline_benchmarks<double>(runner, "");
+    pipeline_benchmarks<float>(runner, "_f32");
+    predicate_benchmarks(runner);
+    matrix_benchmarks(runner);
+    if (options.json) {
+      auto out = std::ofstream{*options.json};
+      runner.write_json(out);
+      if (!out) {
+        std::cerr << "Can not write '" << *options.json << "'\n";
+        return 1;
+      }
+    }
+  } catch (std::exception const &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+
+namespace cpp_contests {
+
+// Synthetic scenes for benchmarks. Every generator is reproducible: the same
+// count and seed give the same scene on the same platform. Engine outputs
+// are converted to coordinates here rather than by distributions, which
+// standard libraries implement differently. Generators still call std::cbrt,
+// std::log, std::sin and std::cos, which are not correctly rounded, so with
+// another math library scenes may differ in the last bits of coordinates.
+// Scenes scale with the count, so that the number of candidate pairs per
+// triangle stays about the same at every size.
+
+namespace details_ {
+
+// Uniform double in [lo, hi) from one 64-bit engine output
+inline double uniform(std::mt19937_64 &gen, double lo, double hi) noexcept {
+  constexpr auto scale = 0x1.0p-53;
+  return lo + (hi - lo) * static_cast<double>(gen() >> 11U) * scale;
+}
+
+inline Point uniform_point(std::mt19937_64 &gen, double lo,
+                           double hi) noexcept {
+  return Point{uniform(gen, lo, hi), uniform(gen, lo, hi),
+               uniform(gen, lo, hi)};
+}
+
+// Triangles with vertices too close to a line are rejected by generators, so
+// float ones pass the triangle inequality check after rounding too
+template <GeometryScalar T>
+bool push_triangle(std::vector<BasicTriangle<T>> &triangles, Point const &p1,
+                   Point const &p2, Point const &p3, double min_area) {
+  auto q1 = BasicPoint<T>(p1);
+  auto q2 = BasicPoint<T>(p2);
+  auto q3 = BasicPoint<T>(p3);
+  auto doubled = n(cross(Point(q2) - Point(q1), Point(q3) - Point(q1)));
+  if (!(doubled > 2 * min_area))
+    return false;
+  triangles.emplace_back(q1, q2, q3);
+  return true;
+}
+
+} // namespace details_
+
+// Triangles of unit size uniformly in a cube, about one per unit volume
+template <GeometryScalar T>
+std::vector<BasicTriangle<T>> random_soup(std::size_t count,
+                                          std::uint64_t seed = 0) {
+  auto gen = std::mt19937_64{seed};
+  auto side = std::cbrt(static_cast<double>(count));
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(count);
+  while (triangles.size() < count) {
+    auto c = details_::uniform_point(gen, 0.0, side);
+    details_::push_triangle(triangles,
+                            c + details_::uniform_point(gen, -0.5, 0.5),
+                            c + details_::uniform_point(gen, -0.5, 0.5),
+                            c + details_::uniform_point(gen, -0.5, 0.5), 1e-3);
+  }
+  return triangles;
+}
+
+// Clusters of a thousand small triangles with normally distributed centers.
+// Boxes overlap much more often than in the uniform soup.
+template <GeometryScalar T>
+std::vector<BasicTriangle<T>> clustered_soup(std::size_t count,
+                                             std::uint64_t seed = 0) {
+  constexpr std::size_t cluster_size = 1000;
+  constexpr double spread = 2.0;
+  auto gen = std::mt19937_64{seed};
+  auto clusters = std::max<std::size_t>(1, count / cluster_size);
+  auto side = 8 * spread * std::cbrt(static_cast<double>(clusters));
+  auto centers = std::vector<Point>{};
+  for (std::size_t k = 0; k < clusters; ++k)
+    centers.push_back(details_::uniform_point(gen, 0.0, side));
+  // Box-Muller transform instead of std::normal_distribution
+  auto normal = [&] {
+    auto u = details_::uniform(gen, 0x1.0p-53, 1.0);
+    auto v = details_::uniform(gen, 0.0, 1.0);
+    return std::sqrt(-2 * std::log(u)) * std::cos(2 * std::numbers::pi * v);
+  };
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(count);
+  while (triangles.size() < count) {
+    auto const &center = centers[triangles.size() % clusters];
+    auto c = center + spread * Point{normal(), normal(), normal()};
+    details_::push_triangle(triangles,
+                            c + details_::uniform_point(gen, -0.2, 0.2),
+                            c + details_::uniform_point(gen, -0.2, 0.2),
+                            c + details_::uniform_point(gen, -0.2, 0.2), 1e-4);
+  }
+  return triangles;
+}
+
+// Two triangulated grids on planes 1e-7 apart, vertices jittered by 1e-6 off
+// the planes. Neighbours share edges and boxes of both sheets overlap, so
+// nearly all candidate pairs go through the near-complanar paths of tests.
+template <GeometryScalar T>
+std::vector<BasicTriangle<T>> coplanar_sheets(std::size_t count,
+                                              std::uint64_t seed = 0) {
+  constexpr std::size_t sheets = 2;
+  auto gen = std::mt19937_64{seed};
+  auto cells = std::max<std::size_t>(
+      1, static_cast<std::size_t>(
+             std::ceil(std::sqrt(static_cast<double>(count) / (2 * sheets)))));
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(count);
+  for (std::size_t s = 0; s < sheets; ++s) {
+    auto z = static_cast<double>(s) * 1e-7;
+    auto vertex = [&](std::size_t i, std::size_t j) {
+      // Jitter is a function of the vertex, so shared vertices stay shared
+      auto index = (s * (cells + 1) + i) * (cells + 1) + j;
+      auto local = std::mt19937_64{seed ^ index};
+      return Point{static_cast<double>(i), static_cast<double>(j),
+                   z + details_::uniform(local, -1e-6, 1e-6)};
+    };
+    for (std::size_t i = 0; i < cells; ++i) {
+      for (std::size_t j = 0; j < cells; ++j) {
+        if (triangles.size() + 2 > count)
+          break;
+        auto p00 = vertex(i, j);
+        auto p10 = vertex(i + 1, j);
+        auto p01 = vertex(i, j + 1);
+        auto p11 = vertex(i + 1, j + 1);
+        details_::push_triangle(triangles, p00, p10, p11, 0.0);
+        details_::push_triangle(triangles, p00, p11, p01, 0.0);
+      }
+    }
+  }
+  // Odd counts and grid remainders are filled with a random soup layer
+  while (triangles.size() < count) {
+    auto side = static_cast<double>(cells);
+    auto c = details_::uniform_point(gen, 0.0, side);
+    c[2] = 0.0;
+    details_::push_triangle(triangles,
+                            c + details_::uniform_point(gen, -0.5, 0.5),
+                            c + details_::uniform_point(gen, -0.5, 0.5),
+                            c + details_::uniform_point(gen, -0.5, 0.5), 1e-3);
+  }
+  return triangles;
+}
+
+// Long thin triangles: boxes are large compared to the triangles, so the
+// broad phase passes many pairs, which narrow phase rejects
+template <GeometryScalar T>
+std::vector<BasicTriangle<T>> slivers(std::size_t count,
+                                      std::uint64_t seed = 0) {
+  constexpr double length = 4.0;
+  constexpr double width = 1e-2;
+  auto gen = std::mt19937_64{seed};
+  auto side = 2 * std::cbrt(static_cast<double>(count));
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(count);
+  while (triangles.size() < count) {
+    auto c = details_::uniform_point(gen, 0.0, side);
+    auto d = details_::uniform_point(gen, -1.0, 1.0);
+    auto w = details_::uniform_point(gen, -1.0, 1.0);
+    if (n(d) == 0.0 || n(cross(d, w)) == 0.0)
+      continue;
+    d = Point{d * (length / 2 / n(d))};
+    auto across = cross(d, w);
+    auto e = Point{across * (width / n(across))};
+    details_::push_triangle(triangles, c - d, c + d, c + e, 1e-3);
+  }
+  return triangles;
+}
+
+// Closed sphere of radius one of about count triangles: a manifold mesh,
+// where every triangle touches its neighbours and no other triangles
+template <GeometryScalar T>
+std::vector<BasicTriangle<T>> sphere_mesh(std::size_t count,
+                                          std::uint64_t /*seed*/ = 0) {
+  auto rings = std::max<std::size_t>(
+      3, static_cast<std::size_t>(std::sqrt(static_cast<double>(count) / 4)));
+  auto segments = std::max<std::size_t>(3, count / (2 * (rings - 1)));
+  auto vertex = [&](std::size_t ring, std::size_t segment) {
+    auto theta = std::numbers::pi * static_cast<double>(ring) /
+                 static_cast<double>(rings);
+    auto phi = 2 * std::numbers::pi * static_cast<double>(segment % segments) /
+               static_cast<double>(segments);
+    if (ring == 0)
+      return Point{0.0, 0.0, 1.0};
+    if (ring == rings)
+      return Point{0.0, 0.0, -1.0};
+    return Point{std::sin(theta) * std::cos(phi),
+                 std::sin(theta) * std::sin(phi), std::cos(theta)};
+  };
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(2 * rings * segments);
+  for (std::size_t r = 0; r < rings; ++r) {
+    for (std::size_t s = 0; s < segments; ++s) {
+      if (r != rings - 1)
+        details_::push_triangle(triangles, vertex(r, s), vertex(r + 1, s),
+                                vertex(r + 1, s + 1), 0.0);
+      if (r != 0)
+        details_::push_triangle(triangles, vertex(r, s), vertex(r + 1, s + 1),
+                                vertex(r, s + 1), 0.0);
+    }
+  }
+  return triangles;
+}
+
+// Generator by its name in benchmark reports
+template <GeometryScalar T> struct SceneGenerator {
+  std::string_view name;
+  std::vector<BasicTriangle<T>> (*generate)(std::size_t, std::uint64_t);
+};
+
+template <GeometryScalar T>
+constexpr std::array<SceneGenerator<T>, 5> scene_generators = {{
+    {"soup", &random_soup<T>},
+    {"clusters", &clustered_soup<T>},
+    {"sheets", &coplanar_sheets<T>},
+    {"slivers", &slivers<T>},
+    {"sphere", &sphere_mesh<T>},
+}};
+
+} // namespace cpp_contests
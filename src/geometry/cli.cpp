@@ -1,25 +1,169 @@
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <exception>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
-#include "lru_cache/solution.hpp"
-
-#include <algorithm>
-#include <iterator>
-
-int main() {
-  std::size_t cache_length = 0;
-  std::size_t n_elements = 0;
-  std::cin >> cache_length;
-  std::cin >> n_elements;
-  std::vector<int> elements{};
-  elements.reserve(n_elements);
-  for (std::size_t i = 0; i < n_elements; ++i) {
-    int n = 0;
-    std::cin >> n;
-    elements.push_back(n);
+#include "geometry/io.hpp"
+#include "geometry/morton.hpp"
+#include "geometry/narrow_phase.hpp"
+#include "geometry/self_intersection.hpp"
+#include "geometry/sweep_and_prune.hpp"
+
+namespace {
+
+std::string read_stdin() {
+  auto text = std::string{};
+  constexpr std::size_t chunk = 1 << 20;
+  auto size = std::size_t{0};
+  while (true) {
+    text.resize(size + chunk);
+    auto read = std::fread(text.data() + size, 1, chunk, stdin);
+    size += read;
+    if (read < chunk)
+      break;
   }
+  text.resize(size);
+  return text;
+}
+
+std::optional<cpp_contests::MeshFormat> parse_format(std::string_view name) {
+  using cpp_contests::MeshFormat;
+  if (name == "text")
+    return MeshFormat::text;
+  if (name == "f64")
+    return MeshFormat::float64;
+  if (name == "f32")
+    return MeshFormat::float32;
+  if (name == "stl")
+    return MeshFormat::stl;
+  return std::nullopt;
+}
 
-  auto lru = cpp_contests::lru_hits(elements, cache_length * sizeof(int), 0);
-  std::cout << lru << "\n";
+// Prints indices of all intersected triangles of the batch. Triangles are
+// tested in Morton order, which keeps spatial neighbours close in memory, and
+// indices are mapped back to the input ones.
+template <typename T>
+void print_intersected(cpp_contests::TriangleBatch<T> const &batch) {
+  using namespace cpp_contests;
+  auto sorted = MortonSorted<T>{};
+  {
+    auto input = std::vector<BasicTriangle<T>>{};
+    input.reserve(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i)
+      input.push_back(batch.triangle(i));
+    sorted = morton_sorted(std::span<BasicTriangle<T> const>{input});
+  }
+  auto const &triangles = sorted.triangles;
+  auto boxes = std::vector<BasicBox<T>>{};
+  boxes.reserve(triangles.size());
+  for (auto const &t : triangles)
+    boxes.push_back(bounding_box(t));
+  auto candidates = std::vector<IndexPair>{};
+  sweep(std::span<BasicBox<T> const>{boxes},
+        [&](std::size_t i, std::size_t j) { candidates.emplace_back(i, j); });
+
+  auto output = std::string{};
+  auto buffer = std::array<char, 24>{};
+  auto intersected = sorted.to_original(intersected_triangles(
+      candidates, std::span<BasicTriangle<T> const>{triangles}));
+  for (auto i : intersected) {
+    auto [end, ec] = std::to_chars(buffer.begin(), buffer.end(), i);
+    output.append(buffer.begin(), end);
+    output.push_back('\n');
+  }
+  std::fwrite(output.data(), 1, output.size(), stdout);
+}
+
+// Prints "i j" and the segment ends of every pair of intersecting triangles,
+// which share no vertex, as soon as they are found. Complanar pairs share an
+// area and get no segment.
+template <typename T>
+void print_self_intersections(cpp_contests::TriangleBatch<T> const &batch) {
+  using namespace cpp_contests;
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(batch.size());
+  for (std::size_t i = 0; i < batch.size(); ++i)
+    triangles.push_back(batch.triangle(i));
+  auto span = std::span<BasicTriangle<T> const>{triangles};
+
+  auto output = std::string{};
+  auto buffer = std::array<char, 32>{};
+  auto append = [&](auto value, char separator) {
+    auto [end, ec] = std::to_chars(buffer.begin(), buffer.end(), value);
+    output.append(buffer.begin(), end);
+    output.push_back(separator);
+  };
+  constexpr std::size_t flush_size = 1 << 20;
+  auto sink = [&](SelfIntersection const &found) {
+    append(found.first, ' ');
+    append(found.second, found.segment ? ' ' : '\n');
+    if (found.segment) {
+      for (auto const &p : {found.segment->s, found.segment->e}) {
+        for (std::size_t c = 0; c < 3; ++c)
+          append(p[c], ' ');
+      }
+      output.back() = '\n';
+    }
+    if (output.size() >= flush_size) {
+      std::fwrite(output.data(), 1, output.size(), stdout);
+      output.clear();
+    }
+  };
+  self_intersections(span, MeshAdjacency(span), sink);
+  std::fwrite(output.data(), 1, output.size(), stdout);
+}
+
+} // namespace
+
+// Usage: geometry [--self-intersections] [file [format]]
+// Reads triangles in text format from stdin or from the file, which format is
+// deduced from its extension unless given explicitly (text, f64, f32, stl).
+// Prints indices of all intersected triangles in ascending order, or every
+// pair of intersecting non-adjacent triangles with their intersection segment
+// in --self-intersections mode.
+int main(int argc, char **argv) {
+  using namespace cpp_contests;
+  auto args = std::vector<std::string_view>(argv + 1, argv + argc);
+  auto self = !args.empty() && args.front() == "--self-intersections";
+  if (self)
+    args.erase(args.begin());
+  auto print = [self](auto const &batch) {
+    if (self)
+      print_self_intersections(batch);
+    else
+      print_intersected(batch);
+  };
+  auto format = std::optional<MeshFormat>{};
+  if (args.size() > 1) {
+    format = parse_format(args[1]);
+    if (!format) {
+      std::cerr << "Unknown format '" << args[1] << "'\n";
+      return 1;
+    }
+  }
+
+  try {
+    if (args.empty()) {
+      print(parse_text_mesh(read_stdin()));
+      return 0;
+    }
+    auto path = std::string{args[0]};
+    auto actual = format.value_or(mesh_format(path));
+    // Float meshes are processed in float: it halves memory traffic, while
+    // intersection tests stay exact
+    if (actual == MeshFormat::float32 || actual == MeshFormat::stl)
+      print(load_mesh<float>(path, actual));
+    else
+      print(load_mesh(path, actual));
+  } catch (std::exception const &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
   return 0;
 }
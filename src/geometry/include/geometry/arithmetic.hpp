@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+// Floating point arithmetic with certified signs: error-free transformations,
+// expansions, which represent sums and products of doubles exactly, and
+// intervals with outward rounding.
+// Signs of determinants are filtered: they are evaluated in floating point
+// with a static error bound first, then in interval arithmetic and exactly
+// only if the result is still ambiguous. See J. R. Shewchuk, "Adaptive
+// Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates".
+// As there, products are assumed not to underflow or overflow.
+
+namespace cpp_contests {
+
+namespace details_ {
+
+// Half of the machine epsilon: relative error of a single rounding
+constexpr double unit_roundoff = std::numeric_limits<double>::epsilon() / 2;
+// 2^ceil(53 / 2) + 1, splits double into two non-overlapping halves
+constexpr double splitter = 134217729.0;
+// Relative error bounds of a * d - b * c and of 3x3 determinant, evaluated
+// in floating point. Both hold when entries are differences too.
+constexpr double det2_bound = (3.0 + 16.0 * unit_roundoff) * unit_roundoff;
+constexpr double det3_bound = (7.0 + 56.0 * unit_roundoff) * unit_roundoff;
+
+// Error-free transformations: first is the rounded result, second is its
+// exact rounding error
+constexpr std::pair<double, double> two_sum(double a, double b) noexcept {
+  auto x = a + b;
+  auto bv = x - a;
+  auto av = x - bv;
+  return {x, (a - av) + (b - bv)};
+}
+constexpr std::pair<double, double> fast_two_sum(double a, double b) noexcept {
+  // |a| >= |b| is required
+  auto x = a + b;
+  return {x, b - (x - a)};
+}
+constexpr std::pair<double, double> two_diff(double a, double b) noexcept {
+  auto x = a - b;
+  auto bv = a - x;
+  auto av = x + bv;
+  return {x, (a - av) + (bv - b)};
+}
+constexpr std::pair<double, double> split(double a) noexcept {
+  auto c = splitter * a;
+  auto hi = c - (c - a);
+  return {hi, a - hi};
+}
+constexpr std::pair<double, double> two_product(double a, double b) noexcept {
+  auto x = a * b;
+  auto [ahi, alo] = split(a);
+  auto [bhi, blo] = split(b);
+  auto err = x - ahi * bhi - alo * bhi - ahi * blo;
+  return {x, alo * blo - err};
+}
+
+// Exact sum of up to N non-overlapping doubles in increasing magnitude.
+// Zero components are never stored.
+template <std::size_t N> class Expansion final {
+private:
+  std::array<double, N> c_{};
+  std::size_t size_ = 0;
+
+public:
+  constexpr Expansion() noexcept = default;
+  // Exact copy of an expansion, known to have at most N components
+  template <std::size_t M>
+  constexpr explicit Expansion(Expansion<M> const &other) noexcept {
+    for (std::size_t i = 0; i < other.size(); ++i)
+      push_back(other[i]);
+  }
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] constexpr double operator[](std::size_t i) const noexcept {
+    assert(i < size_);
+    return c_[i];
+  }
+  constexpr void push_back(double x) noexcept {
+    assert(size_ < N);
+    if (x != 0.0)
+      c_[size_++] = x;
+  }
+  // Adds b exactly in place, the result grows by one component at most
+  constexpr void add(double b) noexcept {
+    assert(size_ < N);
+    auto q = b;
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+      auto [sum, err] = two_sum(q, c_[i]);
+      if (err != 0.0)
+        c_[size++] = err;
+      q = sum;
+    }
+    size_ = size;
+    push_back(q);
+  }
+  template <std::size_t M> constexpr void add(Expansion<M> const &f) noexcept {
+    for (std::size_t i = 0; i < f.size(); ++i)
+      add(f[i]);
+  }
+  constexpr Expansion operator-() const noexcept {
+    auto result = *this;
+    for (std::size_t i = 0; i < size_; ++i)
+      result.c_[i] = -c_[i];
+    return result;
+  }
+  // Sign of the sum is the sign of its largest component
+  [[nodiscard]] constexpr int sign() const noexcept {
+    if (size_ == 0)
+      return 0;
+    return c_[size_ - 1] > 0.0 ? 1 : -1;
+  }
+};
+
+constexpr Expansion<1> expansion(double a) noexcept {
+  auto result = Expansion<1>{};
+  result.push_back(a);
+  return result;
+}
+
+constexpr Expansion<2> difference(double a, double b) noexcept {
+  auto [x, y] = two_diff(a, b);
+  auto result = Expansion<2>{};
+  result.push_back(y);
+  result.push_back(x);
+  return result;
+}
+
+constexpr Expansion<2> product(double a, double b) noexcept {
+  auto [x, y] = two_product(a, b);
+  auto result = Expansion<2>{};
+  result.push_back(y);
+  result.push_back(x);
+  return result;
+}
+
+template <std::size_t N, std::size_t M>
+constexpr Expansion<N + M> operator+(Expansion<N> const &e,
+                                     Expansion<M> const &f) noexcept {
+  auto result = Expansion<N + M>{e};
+  result.add(f);
+  return result;
+}
+
+template <std::size_t N, std::size_t M>
+constexpr Expansion<N + M> operator-(Expansion<N> const &e,
+                                     Expansion<M> const &f) noexcept {
+  return e + -f;
+}
+
+template <std::size_t N>
+constexpr Expansion<2 * N> scale(Expansion<N> const &e, double b) noexcept {
+  auto result = Expansion<2 * N>{};
+  if (e.size() == 0)
+    return result;
+  auto [q, err] = two_product(e[0], b);
+  result.push_back(err);
+  for (std::size_t i = 1; i < e.size(); ++i) {
+    auto [product, product_err] = two_product(e[i], b);
+    auto [sum, sum_err] = two_sum(q, product_err);
+    result.push_back(sum_err);
+    std::tie(q, err) = fast_two_sum(product, sum);
+    result.push_back(err);
+  }
+  result.push_back(q);
+  return result;
+}
+
+template <std::size_t N, std::size_t M>
+constexpr Expansion<2 * N * M> operator*(Expansion<N> const &e,
+                                         Expansion<M> const &f) noexcept {
+  auto result = Expansion<2 * N * M>{};
+  for (std::size_t i = 0; i < f.size(); ++i)
+    result.add(scale(e, f[i]));
+  return result;
+}
+
+// Closed interval, which contains the exact result of a computation.
+// Every operation rounds its bounds outwards, so the interval stays valid
+// without switching the rounding mode.
+class Interval final {
+private:
+  double lo_, hi_;
+
+  // Round to nearest is within an ulp of the exact result and denorm_min
+  // covers underflow
+  static constexpr double down_(double x) noexcept {
+    return x - (std::abs(x) * std::numeric_limits<double>::epsilon() +
+                std::numeric_limits<double>::denorm_min());
+  }
+  static constexpr double up_(double x) noexcept {
+    return x + (std::abs(x) * std::numeric_limits<double>::epsilon() +
+                std::numeric_limits<double>::denorm_min());
+  }
+
+public:
+  constexpr explicit Interval(double x) noexcept : lo_(x), hi_(x) {}
+  // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+  constexpr Interval(double lo, double hi) noexcept : lo_(lo), hi_(hi) {
+    assert(lo <= hi);
+  }
+
+  [[nodiscard]] constexpr double lo() const noexcept { return lo_; }
+  [[nodiscard]] constexpr double hi() const noexcept { return hi_; }
+
+  friend constexpr Interval operator+(Interval const &a,
+                                      Interval const &b) noexcept {
+    return {down_(a.lo_ + b.lo_), up_(a.hi_ + b.hi_)};
+  }
+  friend constexpr Interval operator-(Interval const &a,
+                                      Interval const &b) noexcept {
+    return {down_(a.lo_ - b.hi_), up_(a.hi_ - b.lo_)};
+  }
+  friend constexpr Interval operator*(Interval const &a,
+                                      Interval const &b) noexcept {
+    auto [lo, hi] = std::minmax({a.lo_ * b.lo_, a.lo_ * b.hi_, a.hi_ * b.lo_,
+                                 a.hi_ * b.hi_});
+    return {down_(lo), up_(hi)};
+  }
+
+  // Sign shared by all values of the interval, nullopt if there is none
+  [[nodiscard]] constexpr std::optional<int> sign() const noexcept {
+    if (lo_ > 0.0)
+      return 1;
+    if (hi_ < 0.0)
+      return -1;
+    if (lo_ == 0.0 && hi_ == 0.0)
+      return 0;
+    return std::nullopt;
+  }
+};
+
+// Sign of a * d - b * c. Products are exact with two components each, so
+// the ambiguous case goes straight to expansions.
+constexpr int det2_sign(double a, double b, double c, double d) noexcept {
+  auto ad = a * d;
+  auto bc = b * c;
+  auto det = ad - bc;
+  auto bound = det2_bound * (std::abs(ad) + std::abs(bc));
+  if (det > bound)
+    return 1;
+  if (-det > bound)
+    return -1;
+  return (product(a, d) - product(b, c)).sign();
+}
+
+using Coords = std::array<double, 3>;
+using Columns = std::array<Coords, 3>;
+
+// det[u, v, w] in any arithmetic, given column(i) returning column i
+template <typename F> constexpr auto det3(F const &column) noexcept {
+  auto u = column(0);
+  auto v = column(1);
+  auto w = column(2);
+  auto term = [&](std::size_t i) {
+    auto j = (i + 1) % 3;
+    auto k = (i + 2) % 3;
+    return w[i] * (u[j] * v[k] - u[k] * v[j]);
+  };
+  return term(0) + term(1) + term(2);
+}
+
+// Interval and exact stages of det3_sign below, for callers, which have
+// already run a floating point filter of their own
+constexpr int certified_det3_sign(Columns const &from,
+                                  Columns const &to) noexcept {
+  auto interval = det3([&](std::size_t c) {
+    auto column = std::array{Interval{0.0}, Interval{0.0}, Interval{0.0}};
+    for (std::size_t i = 0; i < 3; ++i)
+      column[i] = Interval{to[c][i]} - Interval{from[c][i]};
+    return column;
+  });
+  if (auto sign = interval.sign())
+    return *sign;
+  // Differences of close coordinates are usually exact, e.g. for complanar
+  // triangles of a mesh, and then products of them need far shorter
+  // expansions
+  auto exact_differences = true;
+  for (std::size_t c = 0; c < 3; ++c) {
+    for (std::size_t i = 0; i < 3; ++i)
+      exact_differences &= two_diff(to[c][i], from[c][i]).second == 0.0;
+  }
+  if (exact_differences) {
+    return det3([&](std::size_t c) {
+             return std::array{expansion(to[c][0] - from[c][0]),
+                               expansion(to[c][1] - from[c][1]),
+                               expansion(to[c][2] - from[c][2])};
+           })
+        .sign();
+  }
+  return det3([&](std::size_t c) {
+           return std::array{difference(to[c][0], from[c][0]),
+                             difference(to[c][1], from[c][1]),
+                             difference(to[c][2], from[c][2])};
+         })
+      .sign();
+}
+
+// Sign of det[to[0] - from[0], to[1] - from[1], to[2] - from[2]]
+constexpr int det3_sign(Columns const &from, Columns const &to) noexcept {
+  auto columns = Columns{};
+  for (std::size_t c = 0; c < 3; ++c) {
+    for (std::size_t i = 0; i < 3; ++i)
+      columns[c][i] = to[c][i] - from[c][i];
+  }
+  auto const &[u, v, w] = columns;
+  auto det = det3([&](std::size_t c) { return columns[c]; });
+  auto bound = 0.0;
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto j = (i + 1) % 3;
+    auto k = (i + 2) % 3;
+    bound += std::abs(w[i]) * (std::abs(u[j] * v[k]) + std::abs(u[k] * v[j]));
+  }
+  bound *= det3_bound;
+  if (det > bound)
+    return 1;
+  if (-det > bound)
+    return -1;
+  return certified_det3_sign(from, to);
+}
+
+} // namespace details_
+
+} // namespace cpp_contests
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+#include "geometry/matrix.hpp"
+#include "geometry/simd.hpp"
+#include "utils/thread_pool.hpp"
+
+// Operations over arrays of small matrices.
+// Matrices stay in their usual layout, one after another. Kernels gather W
+// consecutive matrices into SoA packs, so lane i of every pack holds an
+// element of matrix first + i, compute with whole registers exactly the same
+// formulas as the scalar functions of matrix.hpp, and scatter results back.
+// Large batches are split between workers of the pool.
+
+namespace cpp_contests {
+
+namespace details_ {
+
+// Batches smaller than this number of matrices run on the caller thread
+constexpr std::size_t batch_parallel_size = std::size_t{1} << 16U;
+
+template <typename T> constexpr std::size_t batch_width = simd::native_width<T>;
+
+template <typename T, std::size_t N>
+using PackArray = std::array<simd::Pack<T, batch_width<T>>, N>;
+
+// Calls f(begin, end) for blocks of [0, n), which are split over the pool in
+// multiples of W once the batch is large enough
+template <std::size_t W, typename F>
+void batch_for(std::size_t n, ThreadPool &pool, F const &f) {
+  if (n < batch_parallel_size || pool.size() == 1) {
+    f(std::size_t{0}, n);
+    return;
+  }
+  auto grain = (n + pool.size() - 1) / pool.size();
+  grain = (grain + W - 1) / W * W;
+  pool.parallel_for(n, grain,
+                    [&](std::size_t begin, std::size_t end, std::size_t) {
+                      f(begin, end);
+                    });
+}
+
+// Elements of the SoA buffer per item of a span: matrices are transposed
+// element by element, scalars take one element
+template <typename M> constexpr std::size_t soa_size = 1;
+template <std::size_t X, std::size_t Y, typename T>
+constexpr std::size_t soa_size<Matrix<X, Y, T>> = X * Y;
+
+template <typename M>
+constexpr decltype(auto) soa_element(M &m, std::size_t i) noexcept {
+  if constexpr (is_matrix<std::remove_cv_t<M>>::value)
+    return (m[i]);
+  else
+    return (m);
+}
+
+// Size of SoA buffers of a block in bytes, so that they stay in L1
+constexpr std::size_t soa_budget = std::size_t{32} << 10U;
+
+// Transposes count items starting from first into a block of B items:
+// element i of item j goes to soa[i * B + j]. Items up to padded are zeros.
+// Whole groups of W items have constant trip counts, so compiler turns them
+// into shuffles.
+template <std::size_t B, std::size_t W, typename M, typename T>
+void to_soa(std::span<M const> m, std::size_t first, std::size_t count,
+            std::size_t padded, T *soa) noexcept {
+  constexpr auto N = soa_size<M>;
+  auto const *src = m.data() + first;
+  std::size_t j = 0;
+  for (; j + W <= count; j += W) {
+    for (std::size_t i = 0; i < N; ++i) {
+      for (std::size_t l = 0; l < W; ++l)
+        soa[i * B + j + l] = soa_element(src[j + l], i);
+    }
+  }
+  for (std::size_t i = 0; i < N; ++i) {
+    for (auto k = j; k < padded; ++k)
+      soa[i * B + k] = k < count ? soa_element(src[k], i) : T{0};
+  }
+}
+
+template <std::size_t B, std::size_t W, typename M, typename T>
+void from_soa(T const *soa, std::span<M> m, std::size_t first,
+              std::size_t count) noexcept {
+  constexpr auto N = soa_size<M>;
+  auto *dst = m.data() + first;
+  std::size_t j = 0;
+  for (; j + W <= count; j += W) {
+    for (std::size_t l = 0; l < W; ++l) {
+      for (std::size_t i = 0; i < N; ++i)
+        soa_element(dst[j + l], i) = soa[i * B + j + l];
+    }
+  }
+  for (; j < count; ++j) {
+    for (std::size_t i = 0; i < N; ++i)
+      soa_element(dst[j], i) = soa[i * B + j];
+  }
+}
+
+template <std::size_t N, std::size_t B, typename T>
+PackArray<T, N> load_packs(T const *soa) noexcept {
+  auto packs = PackArray<T, N>{};
+  for (std::size_t i = 0; i < N; ++i)
+    packs[i] = simd::Pack<T, batch_width<T>>::load(soa + i * B);
+  return packs;
+}
+
+template <std::size_t B, typename T, std::size_t N>
+void store_packs(PackArray<T, N> const &packs, T *soa) noexcept {
+  for (std::size_t i = 0; i < N; ++i)
+    packs[i].store(soa + i * B);
+}
+
+// out[i] = kernel(in[i]...) for packs of W items. Blocks of items are
+// transposed to SoA buffers and back, so packs are loaded from memory, which
+// was written long before, rather than from just stored scalars.
+template <typename T, typename Kernel, typename Out, typename... In>
+void batch_map(ThreadPool &pool, Kernel const &kernel, std::span<Out> out,
+               std::span<In const>... in) {
+  constexpr auto W = batch_width<T>;
+  constexpr auto elements = (soa_size<Out> + ... + soa_size<In>);
+  constexpr auto B = std::max(W, soa_budget / sizeof(T) / elements / W * W);
+  assert(((in.size() == out.size()) && ...));
+  batch_for<W>(out.size(), pool, [&](std::size_t begin, std::size_t end) {
+    auto in_soa = std::tuple<std::array<T, soa_size<In> * B>...>{};
+    auto out_soa = std::array<T, soa_size<Out> * B>{};
+    for (auto block = begin; block < end; block += B) {
+      auto count = std::min(B, end - block);
+      auto padded = (count + W - 1) / W * W;
+      std::apply(
+          [&](auto &...soa) {
+            (to_soa<B, W>(in, block, count, padded, soa.data()), ...);
+          },
+          in_soa);
+      for (std::size_t j = 0; j < padded; j += W) {
+        auto result = std::apply(
+            [&](auto const &...soa) {
+              return kernel(load_packs<soa_size<In>, B>(soa.data() + j)...);
+            },
+            in_soa);
+        store_packs<B>(result, out_soa.data() + j);
+      }
+      from_soa<B, W>(out_soa.data(), out, block, count);
+    }
+  });
+}
+
+template <std::size_t X, std::size_t Y, typename T>
+PackArray<T, X * Y> broadcast(Matrix<X, Y, T> const &m) noexcept {
+  auto packs = PackArray<T, X * Y>{};
+  for (std::size_t i = 0; i < X * Y; ++i)
+    packs[i] = m[i];
+  return packs;
+}
+
+// Kernels below take elements in row-major order, element (x, y) of an
+// X-column matrix is a[y * X + x]. P is a scalar or a pack.
+
+template <std::size_t X, std::size_t Y, std::size_t Z, typename P>
+std::array<P, Z * Y> multiply_soa(std::array<P, X * Y> const &a,
+                                  std::array<P, Z * X> const &b) noexcept {
+  auto c = std::array<P, Z * Y>{};
+  for (std::size_t y = 0; y < Y; ++y) {
+    for (std::size_t z = 0; z < Z; ++z) {
+      auto sum = a[y * X] * b[z];
+      for (std::size_t k = 1; k < X; ++k)
+        sum = sum + a[y * X + k] * b[k * Z + z];
+      c[y * Z + z] = sum;
+    }
+  }
+  return c;
+}
+
+template <typename P>
+P det_soa(std::array<P, 1> const &a) noexcept {
+  return a[0];
+}
+template <typename P>
+P det_soa(std::array<P, 4> const &a) noexcept {
+  return a[0] * a[3] - a[2] * a[1];
+}
+template <typename P>
+P det_soa(std::array<P, 9> const &a) noexcept {
+  return a[0] * a[4] * a[8] + a[3] * a[7] * a[2] + a[6] * a[1] * a[5] -
+         a[6] * a[4] * a[2] - a[3] * a[1] * a[8] - a[0] * a[7] * a[5];
+}
+
+template <typename P>
+std::array<P, 1> inv_soa(std::array<P, 1> const &a) noexcept {
+  return {P{1} / a[0]};
+}
+template <typename P>
+std::array<P, 4> inv_soa(std::array<P, 4> const &a) noexcept {
+  auto r = P{1} / det_soa(a);
+  return {a[3] * r, -a[1] * r, -a[2] * r, a[0] * r};
+}
+template <typename P>
+std::array<P, 9> inv_soa(std::array<P, 9> const &a) noexcept {
+  auto r = P{1} / det_soa(a);
+  // Transposed cofactors
+  return {(a[4] * a[8] - a[5] * a[7]) * r, (a[2] * a[7] - a[1] * a[8]) * r,
+          (a[1] * a[5] - a[2] * a[4]) * r, (a[5] * a[6] - a[3] * a[8]) * r,
+          (a[0] * a[8] - a[2] * a[6]) * r, (a[2] * a[3] - a[0] * a[5]) * r,
+          (a[3] * a[7] - a[4] * a[6]) * r, (a[1] * a[6] - a[0] * a[7]) * r,
+          (a[0] * a[4] - a[1] * a[3]) * r};
+}
+
+} // namespace details_
+
+// c[i] = a[i] * b[i]
+template <std::size_t X, std::size_t Y, std::size_t Z, typename T>
+void multiply(std::span<Matrix<X, Y, T> const> a,
+              std::span<Matrix<Z, X, T> const> b, std::span<Matrix<Z, Y, T>> c,
+              ThreadPool &pool = default_thread_pool()) {
+  details_::batch_map<T>(
+      pool,
+      [](auto const &pa, auto const &pb) {
+        return details_::multiply_soa<X, Y, Z>(pa, pb);
+      },
+      c, a, b);
+}
+
+// c[i] = a * b[i], e.g. a transformation of every vertex
+template <std::size_t X, std::size_t Y, std::size_t Z, typename T>
+void multiply(Matrix<X, Y, T> const &a, std::span<Matrix<Z, X, T> const> b,
+              std::span<Matrix<Z, Y, T>> c,
+              ThreadPool &pool = default_thread_pool()) {
+  details_::batch_map<T>(
+      pool,
+      [pa = details_::broadcast(a)](auto const &pb) {
+        return details_::multiply_soa<X, Y, Z>(pa, pb);
+      },
+      c, b);
+}
+
+// c[i] = cross(a[i], b[i])
+template <typename T>
+void cross(std::span<Vector<3, T> const> a, std::span<Vector<3, T> const> b,
+           std::span<Vector<3, T>> c,
+           ThreadPool &pool = default_thread_pool()) {
+  details_::batch_map<T>(
+      pool,
+      [](auto const &u, auto const &v) {
+        return details_::PackArray<T, 3>{u[1] * v[2] - u[2] * v[1],
+                                         u[2] * v[0] - u[0] * v[2],
+                                         u[0] * v[1] - u[1] * v[0]};
+      },
+      c, a, b);
+}
+
+// out[i] = dot(a[i], b[i])
+template <std::size_t X, std::size_t Y, typename T>
+void dot(std::span<Matrix<X, Y, T> const> a,
+         std::span<Matrix<X, Y, T> const> b, std::span<T> out,
+         ThreadPool &pool = default_thread_pool()) {
+  details_::batch_map<T>(
+      pool,
+      [](auto const &u, auto const &v) {
+        auto sum = u[0] * v[0];
+        for (std::size_t k = 1; k < X * Y; ++k)
+          sum = sum + u[k] * v[k];
+        return details_::PackArray<T, 1>{sum};
+      },
+      out, a, b);
+}
+
+// out[i] = det(a[i]). Closed forms are vectorized for N up to 3, larger
+// matrices are decomposed one by one.
+template <std::size_t N, typename T>
+void det(std::span<Matrix<N, N, T> const> a, std::span<T> out,
+         ThreadPool &pool = default_thread_pool()) {
+  assert(a.size() == out.size());
+  if constexpr (N <= 3) {
+    details_::batch_map<T>(
+        pool,
+        [](auto const &m) {
+          return details_::PackArray<T, 1>{details_::det_soa(m)};
+        },
+        out, a);
+  } else {
+    details_::batch_for<1>(a.size(), pool,
+                           [&](std::size_t begin, std::size_t end) {
+                             for (auto i = begin; i < end; ++i)
+                               out[i] = det(a[i]);
+                           });
+  }
+}
+
+// out[i] = inv(a[i]). Closed forms are vectorized for N up to 3, and give
+// non-finite inverses of singular matrices. Larger matrices are inverted one
+// by one and must be invertible.
+template <std::size_t N, std::floating_point T>
+void inv(std::span<Matrix<N, N, T> const> a, std::span<Matrix<N, N, T>> out,
+         ThreadPool &pool = default_thread_pool()) {
+  assert(a.size() == out.size());
+  if constexpr (N <= 3) {
+    details_::batch_map<T>(
+        pool, [](auto const &m) { return details_::inv_soa(m); }, out, a);
+  } else {
+    details_::batch_for<1>(a.size(), pool,
+                           [&](std::size_t begin, std::size_t end) {
+                             for (auto i = begin; i < end; ++i)
+                               out[i] = inv(a[i]);
+                           });
+  }
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "geometry/morton.hpp"
+#include "geometry/primitives.hpp"
+
+namespace cpp_contests {
+
+// Bounding volume hierarchy over boxes.
+// Nodes are stored in depth-first order: the left child of an inner node
+// directly follows it, so only the right one is referenced. Leaves hold up to
+// leaf_size consecutive entries of indices(), which are the box indices
+// reordered, so primitives of a leaf may be stored contiguously too.
+// Splits are chosen with the binned surface area heuristic. Boxes are built
+// over in the Morton order of their centers, so that partitions of every
+// node read neighbouring boxes from neighbouring memory.
+template <GeometryScalar T> class BasicBvh final {
+public:
+  struct Node {
+    BasicBox<T> box;
+    // Right child of an inner node or the first entry of a leaf
+    std::uint32_t first = 0;
+    // Number of entries of a leaf, zero for inner nodes
+    std::uint32_t count = 0;
+
+    [[nodiscard]] constexpr bool leaf() const noexcept { return count != 0; }
+  };
+
+  // Depth never exceeds this, so traversals may use fixed-size stacks
+  static constexpr std::size_t max_depth = 64;
+
+private:
+  std::vector<Node> nodes_;
+  std::vector<std::uint32_t> indices_;
+
+  static constexpr std::size_t bins_ = 16;
+  // Deeper splits fall back to the median, which bounds the depth
+  static constexpr std::size_t sah_depth_ = 32;
+
+public:
+  BasicBvh() = default;
+  explicit BasicBvh(std::span<BasicBox<T> const> boxes,
+                    std::size_t leaf_size = 4)
+      : indices_(boxes.size()) {
+    assert(leaf_size > 0);
+    assert(boxes.size() < (std::size_t{1} << sah_depth_));
+    std::iota(indices_.begin(), indices_.end(), std::uint32_t{0});
+    if (boxes.empty())
+      return;
+    nodes_.reserve(2 * (boxes.size() + leaf_size - 1) / leaf_size);
+    auto order = morton_order(boxes);
+    auto sorted = std::vector<BasicBox<T>>{};
+    sorted.reserve(boxes.size());
+    for (auto i : order)
+      sorted.push_back(boxes[i]);
+    build_(sorted, leaf_size, 0, indices_.size(), 0);
+    for (auto &i : indices_)
+      i = order[i];
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return nodes_.empty(); }
+  [[nodiscard]] std::span<Node const> nodes() const noexcept {
+    return nodes_;
+  }
+  [[nodiscard]] std::span<std::uint32_t const> indices() const noexcept {
+    return indices_;
+  }
+  // Bounds of all boxes
+  [[nodiscard]] BasicBox<T> const &box() const noexcept {
+    assert(!empty());
+    return nodes_.front().box;
+  }
+
+private:
+  static T area_(BasicBox<T> const &box) noexcept {
+    auto d = BasicPoint<T>{box.max - box.min};
+    return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+  }
+  static void grow_(BasicBox<T> &box, BasicBox<T> const &other) noexcept {
+    for (std::size_t i = 0; i < 3; ++i) {
+      box.min[i] = std::min(box.min[i], other.min[i]);
+      box.max[i] = std::max(box.max[i], other.max[i]);
+    }
+  }
+  static constexpr BasicBox<T> empty_box_() noexcept {
+    constexpr auto inf = std::numeric_limits<T>::infinity();
+    return BasicBox<T>{BasicPoint<T>{inf, inf, inf},
+                       BasicPoint<T>{-inf, -inf, -inf}};
+  }
+  static T centroid_(BasicBox<T> const &box, std::size_t axis) noexcept {
+    return (box.min[axis] + box.max[axis]) / 2;
+  }
+
+  // Builds the subtree of indices_[begin, end) and returns its root
+  std::uint32_t build_(std::span<BasicBox<T> const> boxes,
+                       std::size_t leaf_size, std::size_t begin,
+                       std::size_t end, std::size_t depth) {
+    assert(depth < max_depth);
+    auto node = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    auto box = empty_box_();
+    auto centroids = empty_box_();
+    for (auto k = begin; k < end; ++k) {
+      auto const &b = boxes[indices_[k]];
+      grow_(box, b);
+      for (std::size_t i = 0; i < 3; ++i) {
+        centroids.min[i] = std::min(centroids.min[i], centroid_(b, i));
+        centroids.max[i] = std::max(centroids.max[i], centroid_(b, i));
+      }
+    }
+    nodes_[node].box = box;
+    if (end - begin <= leaf_size) {
+      nodes_[node].first = static_cast<std::uint32_t>(begin);
+      nodes_[node].count = static_cast<std::uint32_t>(end - begin);
+      return node;
+    }
+
+    auto extent = BasicPoint<T>{centroids.max - centroids.min};
+    auto axis = static_cast<std::size_t>(
+        std::max_element(extent.begin(), extent.end()) - extent.begin());
+    auto first = indices_.begin() + static_cast<std::ptrdiff_t>(begin);
+    auto last = indices_.begin() + static_cast<std::ptrdiff_t>(end);
+    auto mid = first;
+    if (depth < sah_depth_ && extent[axis] > T{0})
+      mid = sah_split_(boxes, first, last, axis, centroids);
+    if (mid == first || mid == last) {
+      mid = first + (last - first) / 2;
+      std::nth_element(first, mid, last, [&](auto i, auto j) {
+        return centroid_(boxes[i], axis) < centroid_(boxes[j], axis);
+      });
+    }
+
+    auto split = static_cast<std::size_t>(mid - indices_.begin());
+    build_(boxes, leaf_size, begin, split, depth + 1);
+    auto right = build_(boxes, leaf_size, split, end, depth + 1);
+    nodes_[node].first = right;
+    return node;
+  }
+
+  // Partitions entries at the bin boundary of the least estimated cost
+  template <typename It>
+  static It sah_split_(std::span<BasicBox<T> const> boxes, It first, It last,
+                       std::size_t axis, BasicBox<T> const &centroids) {
+    auto scale = static_cast<T>(bins_) /
+                 (centroids.max[axis] - centroids.min[axis]);
+    auto bin = [&](std::uint32_t i) {
+      auto b = static_cast<std::size_t>(
+          (centroid_(boxes[i], axis) - centroids.min[axis]) * scale);
+      return std::min(b, bins_ - 1);
+    };
+    auto counts = std::array<std::size_t, bins_>{};
+    auto bounds = std::array<BasicBox<T>, bins_>{};
+    bounds.fill(empty_box_());
+    for (auto it = first; it != last; ++it) {
+      auto b = bin(*it);
+      ++counts[b];
+      grow_(bounds[b], boxes[*it]);
+    }
+
+    // Cost of the split before bin b is left[b] plus the cost of the rest.
+    // Splits with an empty side are not considered.
+    auto left = std::array<T, bins_>{};
+    auto box = empty_box_();
+    auto count = std::size_t{0};
+    for (std::size_t b = 1; b < bins_; ++b) {
+      grow_(box, bounds[b - 1]);
+      count += counts[b - 1];
+      left[b] = count == 0 ? std::numeric_limits<T>::infinity()
+                           : area_(box) * static_cast<T>(count);
+    }
+    auto best = std::numeric_limits<T>::infinity();
+    auto best_bin = bins_;
+    box = empty_box_();
+    count = 0;
+    for (std::size_t b = bins_ - 1; b > 0; --b) {
+      grow_(box, bounds[b]);
+      count += counts[b];
+      if (count == 0)
+        continue;
+      auto cost = left[b] + area_(box) * static_cast<T>(count);
+      if (cost < best) {
+        best = cost;
+        best_bin = b;
+      }
+    }
+    return std::partition(first, last,
+                          [&](std::uint32_t i) { return bin(i) < best_bin; });
+  }
+};
+
+using Bvh = BasicBvh<double>;
+
+} // namespace cpp_contests
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "geometry/predicates.hpp"
+#include "geometry/primitives.hpp"
+
+// Overlap test of complanar triangles.
+// Triangles are projected to the coordinate plane orthogonal to the dominant
+// axis of their normal, which keeps relative positions of points of their
+// plane, and tested there with exact orient2d. Non-degenerate projections go
+// through the separating axis test with normals of edges of both triangles as
+// candidate axes: triangles are disjoint iff all vertices of one of them lie
+// strictly outside of an edge of the other. Containment needs no separate
+// check, a triangle inside another has no separating edge. Degenerate
+// projections, i.e. segments and points, are tested edge by edge.
+
+namespace cpp_contests {
+
+namespace details_ {
+
+using Triangle2d = std::array<Point2d, 3>;
+
+constexpr std::size_t dominant_axis(Point const &v) noexcept {
+  auto axis = std::size_t{0};
+  for (std::size_t i = 1; i < 3; ++i) {
+    if (std::abs(v[i]) > std::abs(v[axis]))
+      axis = i;
+  }
+  return axis;
+}
+
+// Dominant axis of the normal of t1, or of t2 if t1 is degenerate. The
+// plane of complanar triangles is not parallel to it.
+template <typename Tri>
+constexpr std::size_t complanar_axis(Tri const &t1, Tri const &t2) noexcept {
+  auto normal = Point{cross(t1[1] - t1[0], t1[2] - t1[0])};
+  if (normal[0] == 0.0 && normal[1] == 0.0 && normal[2] == 0.0)
+    normal = cross(t2[1] - t2[0], t2[2] - t2[0]);
+  return dominant_axis(normal);
+}
+
+// Coordinates (axis + 1) % 3 and (axis + 2) % 3 of p
+constexpr Point2d project(Point const &p, std::size_t axis) noexcept {
+  return Point2d{p[(axis + 1) % 3], p[(axis + 2) % 3]};
+}
+
+// Whether all vertices of other lie strictly outside of an edge of t, which
+// vertices go in direction sign
+constexpr bool has_separating_edge(Triangle2d const &t, int sign,
+                                   Triangle2d const &other) noexcept {
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto j = (i + 1) % 3;
+    auto outside = true;
+    for (std::size_t k = 0; k < 3 && outside; ++k)
+      outside = orient2d(t[i], t[j], other[k]) == -sign;
+    if (outside)
+      return true;
+  }
+  return false;
+}
+
+// Whether p, known to lie on the line through a and b, lies on [a, b]
+constexpr bool on_segment(Point2d const &a, Point2d const &b,
+                          Point2d const &p) noexcept {
+  return std::min(a[0], b[0]) <= p[0] && p[0] <= std::max(a[0], b[0]) &&
+         std::min(a[1], b[1]) <= p[1] && p[1] <= std::max(a[1], b[1]);
+}
+
+// Exact test of closed segments [p1, q1] and [p2, q2], which may be points
+constexpr bool segments_intersect(Point2d const &p1, Point2d const &q1,
+                                  Point2d const &p2,
+                                  Point2d const &q2) noexcept {
+  auto o1 = orient2d(p1, q1, p2);
+  auto o2 = orient2d(p1, q1, q2);
+  auto o3 = orient2d(p2, q2, p1);
+  auto o4 = orient2d(p2, q2, q1);
+  if (o1 * o2 < 0 && o3 * o4 < 0)
+    return true;
+  return (o1 == 0 && on_segment(p1, q1, p2)) ||
+         (o2 == 0 && on_segment(p1, q1, q2)) ||
+         (o3 == 0 && on_segment(p2, q2, p1)) ||
+         (o4 == 0 && on_segment(p2, q2, q1));
+}
+
+// Whether p lies inside or on the boundary of t, which vertices go in
+// direction sign
+constexpr bool contains(Triangle2d const &t, int sign,
+                        Point2d const &p) noexcept {
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (orient2d(t[i], t[(i + 1) % 3], p) == -sign)
+      return false;
+  }
+  return true;
+}
+
+// Whether closed triangles of a plane have common points
+constexpr bool triangles_overlap(Triangle2d const &t1,
+                                 Triangle2d const &t2) noexcept {
+  auto s1 = orient2d(t1[0], t1[1], t1[2]);
+  auto s2 = orient2d(t2[0], t2[1], t2[2]);
+  if (s1 != 0 && s2 != 0)
+    return !has_separating_edge(t1, s1, t2) &&
+           !has_separating_edge(t2, s2, t1);
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    for (std::size_t j = 0; j < 3; ++j) {
+      if (segments_intersect(t1[i], t1[(i + 1) % 3], t2[j], t2[(j + 1) % 3]))
+        return true;
+    }
+  }
+  // Without common points of edges a triangle may only lie inside the other
+  return (s1 != 0 && contains(t1, s1, t2[0])) ||
+         (s2 != 0 && contains(t2, s2, t1[0]));
+}
+
+// Exact test of complanar triangles, anything with three Points, projected
+// along the axis, to which their plane is not parallel
+template <typename Tri>
+constexpr bool complanar_overlap(Tri const &t1, Tri const &t2,
+                                 std::size_t axis) noexcept {
+  auto projected = [axis](Tri const &t) {
+    return Triangle2d{project(t[0], axis), project(t[1], axis),
+                      project(t[2], axis)};
+  };
+  return triangles_overlap(projected(t1), projected(t2));
+}
+
+} // namespace details_
+
+} // namespace cpp_contests
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+
+namespace cpp_contests {
+
+// Closest points and distances between primitives. Unlike intersection tests,
+// these are computed in floating point: points are accurate to a few
+// roundings, which is enough for clearance checks.
+
+// Point of the segment closest to p
+template <GeometryScalar T>
+constexpr BasicPoint<T> closest_point(BasicPoint<T> const &p,
+                                      BasicSegment<T> const &s) noexcept {
+  auto d = BasicPoint<T>{s.e - s.s};
+  auto len = dot(d, d);
+  if (len == T{0})
+    return s.s;
+  auto t = std::clamp(dot(p - s.s, d) / len, T{0}, T{1});
+  return s.s + t * d;
+}
+
+// Points of both segments, which are closest to each other. Of parallel
+// segments, the points nearest to the start of the first one are taken.
+template <GeometryScalar T>
+constexpr std::pair<BasicPoint<T>, BasicPoint<T>>
+closest_points(BasicSegment<T> const &s1, BasicSegment<T> const &s2) noexcept {
+  auto d1 = BasicPoint<T>{s1.e - s1.s};
+  auto d2 = BasicPoint<T>{s2.e - s2.s};
+  auto r = BasicPoint<T>{s1.s - s2.s};
+  auto a = dot(d1, d1);
+  auto e = dot(d2, d2);
+  auto f = dot(d2, r);
+  if (a == T{0})
+    return {s1.s, closest_point(s1.s, s2)};
+  if (e == T{0})
+    return {closest_point(s2.s, s1), s2.s};
+
+  // Params minimizing the distance between lines, clamped to segments
+  auto b = dot(d1, d2);
+  auto c = dot(d1, r);
+  auto denom = a * e - b * b;
+  auto s = denom > T{0} ? std::clamp((b * f - c * e) / denom, T{0}, T{1})
+                        : T{0};
+  auto t = (b * s + f) / e;
+  if (t < T{0}) {
+    t = T{0};
+    s = std::clamp(-c / a, T{0}, T{1});
+  } else if (t > T{1}) {
+    t = T{1};
+    s = std::clamp((b - c) / a, T{0}, T{1});
+  }
+  return {s1.s + s * d1, s2.s + t * d2};
+}
+
+namespace details_ {
+
+// Point of the triangle abc closest to p. Voronoi regions of vertices and
+// edges are tested first, so only points projecting inside the triangle take
+// the division by its squared double area.
+template <GeometryScalar T>
+constexpr BasicPoint<T>
+closest_point(BasicPoint<T> const &p, BasicPoint<T> const &a,
+              BasicPoint<T> const &b, BasicPoint<T> const &c) noexcept {
+  auto ab = BasicPoint<T>{b - a};
+  auto ac = BasicPoint<T>{c - a};
+  auto ap = BasicPoint<T>{p - a};
+  auto d1 = dot(ab, ap);
+  auto d2 = dot(ac, ap);
+  if (d1 <= T{0} && d2 <= T{0})
+    return a;
+
+  auto bp = BasicPoint<T>{p - b};
+  auto d3 = dot(ab, bp);
+  auto d4 = dot(ac, bp);
+  if (d3 >= T{0} && d4 <= d3)
+    return b;
+  auto vc = d1 * d4 - d3 * d2;
+  if (vc <= T{0} && d1 >= T{0} && d3 <= T{0})
+    return a + d1 / (d1 - d3) * ab;
+
+  auto cp = BasicPoint<T>{p - c};
+  auto d5 = dot(ab, cp);
+  auto d6 = dot(ac, cp);
+  if (d6 >= T{0} && d5 <= d6)
+    return c;
+  auto vb = d5 * d2 - d1 * d6;
+  if (vb <= T{0} && d2 >= T{0} && d6 <= T{0})
+    return a + d2 / (d2 - d6) * ac;
+  auto va = d3 * d6 - d5 * d4;
+  if (va <= T{0} && d4 - d3 >= T{0} && d5 - d6 >= T{0})
+    return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * BasicPoint<T>{c - b};
+
+  auto inv = T{1} / (va + vb + vc);
+  return a + (vb * inv) * ab + (vc * inv) * ac;
+}
+
+} // namespace details_
+
+// Point of the triangle closest to p
+template <GeometryScalar T>
+constexpr BasicPoint<T> closest_point(BasicPoint<T> const &p,
+                                      BasicTriangle<T> const &t) noexcept {
+  return details_::closest_point(p, t[0], t[1], t[2]);
+}
+
+// Points of both triangles closest to each other. Of disjoint triangles,
+// one of the points is a vertex or both are on edges, so 9 edge pairs and
+// 6 vertices are checked. Intersecting triangles get some close points
+// only, test them with intersects() first or use dist().
+template <GeometryScalar T>
+constexpr std::pair<BasicPoint<T>, BasicPoint<T>>
+closest_points(BasicTriangle<T> const &t1,
+               BasicTriangle<T> const &t2) noexcept {
+  auto best = std::pair{t1[0], closest_point(t1[0], t2)};
+  auto best_dist = dot(best.first - best.second, best.first - best.second);
+  auto update = [&](BasicPoint<T> const &p1, BasicPoint<T> const &p2) {
+    auto d = BasicPoint<T>{p1 - p2};
+    auto dist = dot(d, d);
+    if (dist < best_dist) {
+      best_dist = dist;
+      best = {p1, p2};
+    }
+  };
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (i != 0)
+      update(t1[i], closest_point(t1[i], t2));
+    update(closest_point(t2[i], t1), t2[i]);
+  }
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto e1 = BasicSegment<T>{t1[i], t1[(i + 1) % 3]};
+    for (std::size_t j = 0; j < 3; ++j) {
+      auto [p1, p2] =
+          closest_points(e1, BasicSegment<T>{t2[j], t2[(j + 1) % 3]});
+      update(p1, p2);
+    }
+  }
+  return best;
+}
+
+template <GeometryScalar T>
+constexpr T dist(BasicPoint<T> const &p, BasicSegment<T> const &s) noexcept {
+  return dist(p, closest_point(p, s));
+}
+template <GeometryScalar T>
+constexpr T dist(BasicSegment<T> const &s1,
+                 BasicSegment<T> const &s2) noexcept {
+  auto [p1, p2] = closest_points(s1, s2);
+  return dist(p1, p2);
+}
+template <GeometryScalar T>
+constexpr T dist(BasicPoint<T> const &p, BasicTriangle<T> const &t) noexcept {
+  return dist(p, closest_point(p, t));
+}
+// Zero for intersecting triangles, which is decided exactly
+template <GeometryScalar T>
+constexpr T dist(BasicTriangle<T> const &t1,
+                 BasicTriangle<T> const &t2) noexcept {
+  if (intersects(t1, t2))
+    return T{0};
+  auto [p1, p2] = closest_points(t1, t2);
+  return dist(p1, p2);
+}
+
+// Point of a mesh closest to the query one
+template <GeometryScalar T> struct BasicNearestPoint {
+  BasicPoint<T> point;
+  T distance;
+  // Index of the triangle, which the point is on
+  std::size_t triangle = 0;
+};
+
+using NearestPoint = BasicNearestPoint<double>;
+
+} // namespace cpp_contests
@@ -0,0 +1,512 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "geometry/matrix.hpp"
+#include "geometry/simd.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+// Matrix with dimensions known at runtime.
+// Layout follows Matrix: x is a column, y is a row, rows are contiguous.
+// Every row starts at a 64-byte boundary, so rows are padded up to the leading
+// dimension ld(). Padding elements are unspecified and never affect results,
+// which lets kernels process whole SIMD registers without tails.
+template <typename T>
+  requires std::is_arithmetic_v<T>
+class DynamicMatrix final {
+public:
+  using value_type = T;
+  static constexpr std::size_t alignment = 64;
+
+private:
+  struct Deleter {
+    void operator()(T *p) const noexcept {
+      ::operator delete(p, std::align_val_t{alignment});
+    }
+  };
+
+  std::size_t x_ = 0;
+  std::size_t y_ = 0;
+  std::size_t ld_ = 0;
+  std::unique_ptr<T[], Deleter> data_; // NOLINT(*-avoid-c-arrays)
+
+public:
+  DynamicMatrix() noexcept = default;
+  DynamicMatrix(std::size_t x, std::size_t y, T value = T{})
+      : x_(x), y_(y), ld_(padded_(x)), data_(allocate_(ld_ * y)) {
+    std::fill_n(data_.get(), ld_ * y_, value);
+  }
+  // Copies a fixed-size matrix or evaluates an expression over them
+  template <MatrixExpression E>
+    requires std::same_as<expression_value_t<E>, T>
+  explicit DynamicMatrix(E const &e)
+      : DynamicMatrix(std::remove_cvref_t<E>::size_x(),
+                      std::remove_cvref_t<E>::size_y()) {
+    for (std::size_t y = 0; y < y_; ++y) {
+      for (std::size_t x = 0; x < x_; ++x)
+        (*this)[x, y] = e[x, y];
+    }
+  }
+  DynamicMatrix(DynamicMatrix const &other)
+      : x_(other.x_), y_(other.y_), ld_(other.ld_),
+        data_(allocate_(ld_ * y_)) {
+    std::copy_n(other.data_.get(), ld_ * y_, data_.get());
+  }
+  DynamicMatrix(DynamicMatrix &&other) noexcept
+      : x_(std::exchange(other.x_, 0)), y_(std::exchange(other.y_, 0)),
+        ld_(std::exchange(other.ld_, 0)), data_(std::move(other.data_)) {}
+  DynamicMatrix &operator=(DynamicMatrix const &other) {
+    if (this != &other)
+      *this = DynamicMatrix(other);
+    return *this;
+  }
+  DynamicMatrix &operator=(DynamicMatrix &&other) noexcept {
+    x_ = std::exchange(other.x_, 0);
+    y_ = std::exchange(other.y_, 0);
+    ld_ = std::exchange(other.ld_, 0);
+    data_ = std::move(other.data_);
+    return *this;
+  }
+  ~DynamicMatrix() = default;
+
+  [[nodiscard]] std::size_t size_x() const noexcept { return x_; }
+  [[nodiscard]] std::size_t size_y() const noexcept { return y_; }
+  [[nodiscard]] std::size_t size() const noexcept { return x_ * y_; }
+  // Distance between starts of consecutive rows in elements
+  [[nodiscard]] std::size_t ld() const noexcept { return ld_; }
+
+  [[nodiscard]] T *data() noexcept { return data_.get(); }
+  [[nodiscard]] T const *data() const noexcept { return data_.get(); }
+  [[nodiscard]] std::span<T> row(std::size_t y) noexcept {
+    assert(y < y_);
+    return {data_.get() + y * ld_, x_};
+  }
+  [[nodiscard]] std::span<T const> row(std::size_t y) const noexcept {
+    assert(y < y_);
+    return {data_.get() + y * ld_, x_};
+  }
+
+  T &operator[](std::size_t x, std::size_t y) noexcept {
+    assert(x < x_ && y < y_);
+    return data_[y * ld_ + x];
+  }
+  T operator[](std::size_t x, std::size_t y) const noexcept {
+    assert(x < x_ && y < y_);
+    return data_[y * ld_ + x];
+  }
+
+  // Copy into a fixed-size matrix of the same dimensions
+  template <std::size_t X, std::size_t Y>
+  [[nodiscard]] Matrix<X, Y, T> fixed() const noexcept {
+    assert(X == x_ && Y == y_);
+    Matrix<X, Y, T> m{};
+    for (std::size_t y = 0; y < Y; ++y) {
+      for (std::size_t x = 0; x < X; ++x)
+        m[x, y] = (*this)[x, y];
+    }
+    return m;
+  }
+
+  template <std::invocable<T> F> DynamicMatrix &elementwise(F f) {
+    for (std::size_t y = 0; y < y_; ++y) {
+      auto *r = data_.get() + y * ld_;
+      for (std::size_t x = 0; x < x_; ++x)
+        r[x] = f(r[x]);
+    }
+    return *this;
+  }
+  template <std::invocable<T, T> F>
+  DynamicMatrix &elementwise(DynamicMatrix const &m, F f) {
+    assert(m.x_ == x_ && m.y_ == y_);
+    for (std::size_t y = 0; y < y_; ++y) {
+      auto *r = data_.get() + y * ld_;
+      auto const *mr = m.data_.get() + y * m.ld_;
+      for (std::size_t x = 0; x < x_; ++x)
+        r[x] = f(r[x], mr[x]);
+    }
+    return *this;
+  }
+
+  DynamicMatrix operator+() const { return *this; }
+  DynamicMatrix operator-() const {
+    auto m = *this;
+    return m.elementwise([](T x) noexcept { return -x; });
+  }
+  DynamicMatrix &operator+=(DynamicMatrix const &m) {
+    return elementwise(m, [](T a, T b) noexcept { return a + b; });
+  }
+  DynamicMatrix &operator-=(DynamicMatrix const &m) {
+    return elementwise(m, [](T a, T b) noexcept { return a - b; });
+  }
+  DynamicMatrix &operator+=(T v) {
+    return elementwise([v](T a) noexcept { return a + v; });
+  }
+  DynamicMatrix &operator-=(T v) { return operator+=(-v); }
+  DynamicMatrix &operator*=(T v) {
+    return elementwise([v](T a) noexcept { return a * v; });
+  }
+  DynamicMatrix &operator/=(T v) {
+    if constexpr (std::floating_point<T>)
+      return operator*=(T{1} / v);
+    else
+      return elementwise([v](T a) noexcept { return a / v; });
+  }
+
+private:
+  static std::size_t padded_(std::size_t x) noexcept {
+    constexpr std::size_t per_line = alignment / sizeof(T);
+    return (x + per_line - 1) / per_line * per_line;
+  }
+  static T *allocate_(std::size_t n) {
+    if (n == 0)
+      return nullptr;
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{alignment}));
+  }
+};
+
+template <typename T>
+DynamicMatrix<T> operator+(DynamicMatrix<T> a, DynamicMatrix<T> const &b) {
+  return a += b;
+}
+template <typename T>
+DynamicMatrix<T> operator-(DynamicMatrix<T> a, DynamicMatrix<T> const &b) {
+  return a -= b;
+}
+template <typename T>
+DynamicMatrix<T> operator+(DynamicMatrix<T> a, std::type_identity_t<T> v) {
+  return a += v;
+}
+template <typename T>
+DynamicMatrix<T> operator-(DynamicMatrix<T> a, std::type_identity_t<T> v) {
+  return a -= v;
+}
+template <typename T>
+DynamicMatrix<T> operator*(DynamicMatrix<T> a, std::type_identity_t<T> v) {
+  return a *= v;
+}
+template <typename T>
+DynamicMatrix<T> operator*(std::type_identity_t<T> v, DynamicMatrix<T> a) {
+  return a *= v;
+}
+template <typename T>
+DynamicMatrix<T> operator/(DynamicMatrix<T> a, std::type_identity_t<T> v) {
+  return a /= v;
+}
+
+template <typename T>
+bool operator==(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b) noexcept {
+  if (a.size_x() != b.size_x() || a.size_y() != b.size_y())
+    return false;
+  for (std::size_t y = 0; y < a.size_y(); ++y) {
+    if (!std::ranges::equal(a.row(y), b.row(y)))
+      return false;
+  }
+  return true;
+}
+
+template <typename T>
+T dot(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b) noexcept {
+  assert(a.size_x() == b.size_x() && a.size_y() == b.size_y());
+  T sum{};
+  for (std::size_t y = 0; y < a.size_y(); ++y) {
+    auto ra = a.row(y);
+    sum = std::transform_reduce(ra.begin(), ra.end(), b.row(y).begin(), sum);
+  }
+  return sum;
+}
+template <typename T> T norm(DynamicMatrix<T> const &a) noexcept {
+  return std::sqrt(dot(a, a));
+}
+template <typename T> T n(DynamicMatrix<T> const &a) noexcept {
+  return norm(a);
+}
+
+// Transposes square tiles, so both reads and writes stay within a few cache
+// lines per tile
+template <typename T> DynamicMatrix<T> transpose(DynamicMatrix<T> const &a) {
+  constexpr std::size_t tile = 32;
+  auto m = DynamicMatrix<T>(a.size_y(), a.size_x());
+  for (std::size_t y0 = 0; y0 < a.size_y(); y0 += tile) {
+    auto y1 = std::min(y0 + tile, a.size_y());
+    for (std::size_t x0 = 0; x0 < a.size_x(); x0 += tile) {
+      auto x1 = std::min(x0 + tile, a.size_x());
+      for (std::size_t y = y0; y < y1; ++y) {
+        for (std::size_t x = x0; x < x1; ++x)
+          m[y, x] = a[x, y];
+      }
+    }
+  }
+  return m;
+}
+template <typename T> DynamicMatrix<T> t(DynamicMatrix<T> const &a) {
+  return transpose(a);
+}
+
+namespace details_ {
+
+// Blocking of the dynamic product: a panel of kc rows of b and a block of nc
+// columns is reused by all rows of c, which a worker computes
+constexpr std::size_t dynamic_kc = 256;
+constexpr std::size_t dynamic_nc = 512;
+// Products smaller than this number of multiply-adds run on the caller thread
+constexpr std::size_t dynamic_parallel_work = std::size_t{1} << 18U;
+
+// Accumulates R rows and C packs of W columns of c, starting from (z0, y0),
+// over k in [k0, k1). Packs may extend into the padding of rows.
+template <std::size_t R, std::size_t C, typename T>
+void dynamic_tile(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b,
+                  DynamicMatrix<T> &c, std::size_t z0, std::size_t y0,
+                  std::size_t k0, std::size_t k1) noexcept {
+  constexpr std::size_t W = simd::native_width<T>;
+  using P = simd::Pack<T, W>;
+  auto acc = std::array<P, R * C>{};
+  for (std::size_t i = 0; i < R; ++i) {
+    for (std::size_t j = 0; j < C; ++j)
+      acc[i * C + j] = P::load(c.data() + (y0 + i) * c.ld() + z0 + j * W);
+  }
+  for (std::size_t k = k0; k < k1; ++k) {
+    auto row = std::array<P, C>{};
+    for (std::size_t j = 0; j < C; ++j)
+      row[j] = P::load(b.data() + k * b.ld() + z0 + j * W);
+    for (std::size_t i = 0; i < R; ++i) {
+      auto scale = P{a[k, y0 + i]};
+      for (std::size_t j = 0; j < C; ++j)
+        acc[i * C + j] = fma(scale, row[j], acc[i * C + j]);
+    }
+  }
+  for (std::size_t i = 0; i < R; ++i) {
+    for (std::size_t j = 0; j < C; ++j)
+      acc[i * C + j].store(c.data() + (y0 + i) * c.ld() + z0 + j * W);
+  }
+}
+
+// Adds the product of rows [y_begin, y_end) of a and b to the same rows of c
+template <typename T>
+void dynamic_multiply_rows(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b,
+                           DynamicMatrix<T> &c, std::size_t y_begin,
+                           std::size_t y_end) noexcept {
+  constexpr std::size_t W = simd::native_width<T>;
+  constexpr std::size_t R = 4;
+  constexpr std::size_t C = 2;
+  // Multiple of the pack width, since ld is a multiple of 64 bytes
+  auto width = c.ld();
+  for (std::size_t k0 = 0; k0 < a.size_x(); k0 += dynamic_kc) {
+    auto k1 = std::min(k0 + dynamic_kc, a.size_x());
+    for (std::size_t n0 = 0; n0 < width; n0 += dynamic_nc) {
+      auto n1 = std::min(n0 + dynamic_nc, width);
+      if constexpr (simd::is_native<T, W>) {
+        auto y = y_begin;
+        for (; y + R <= y_end; y += R) {
+          auto z = n0;
+          for (; z + C * W <= n1; z += C * W)
+            dynamic_tile<R, C>(a, b, c, z, y, k0, k1);
+          for (; z < n1; z += W)
+            dynamic_tile<R, 1>(a, b, c, z, y, k0, k1);
+        }
+        for (; y < y_end; ++y) {
+          for (auto z = n0; z < n1; z += W)
+            dynamic_tile<1, 1>(a, b, c, z, y, k0, k1);
+        }
+      } else {
+        for (auto y = y_begin; y < y_end; ++y) {
+          auto *rc = c.data() + y * c.ld();
+          for (auto k = k0; k < k1; ++k) {
+            auto scale = a[k, y];
+            auto const *rb = b.data() + k * b.ld();
+            for (auto z = n0; z < n1; ++z)
+              rc[z] += scale * rb[z];
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace details_
+
+// Blocked product. Row blocks of the result are distributed over the pool
+// once the product is large enough to pay for synchronization.
+template <typename T>
+DynamicMatrix<T> multiply(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b,
+                          ThreadPool &pool = default_thread_pool()) {
+  assert(a.size_x() == b.size_y());
+  auto c = DynamicMatrix<T>(b.size_x(), a.size_y());
+  // Padding of b is unspecified, so padding of c may get anything
+  auto work = a.size_y() * a.size_x() * b.size_x();
+  if (work < details_::dynamic_parallel_work || pool.size() == 1) {
+    details_::dynamic_multiply_rows(a, b, c, 0, a.size_y());
+    return c;
+  }
+  constexpr std::size_t rows_multiple = 4;
+  auto grain = (a.size_y() + pool.size() - 1) / pool.size();
+  grain = (grain + rows_multiple - 1) / rows_multiple * rows_multiple;
+  pool.parallel_for(a.size_y(), grain,
+                    [&](std::size_t begin, std::size_t end, std::size_t) {
+                      details_::dynamic_multiply_rows(a, b, c, begin, end);
+                    });
+  return c;
+}
+
+template <typename T>
+DynamicMatrix<T> operator*(DynamicMatrix<T> const &a,
+                           DynamicMatrix<T> const &b) {
+  return multiply(a, b);
+}
+template <typename T, MatrixExpression E>
+  requires std::same_as<expression_value_t<E>, T>
+DynamicMatrix<T> operator*(DynamicMatrix<T> const &a, E const &b) {
+  return multiply(a, DynamicMatrix<T>{b});
+}
+template <typename T, MatrixExpression E>
+  requires std::same_as<expression_value_t<E>, T>
+DynamicMatrix<T> operator*(E const &a, DynamicMatrix<T> const &b) {
+  return multiply(DynamicMatrix<T>{a}, b);
+}
+
+// LU decomposition with partial pivoting, see LUDecomposition
+template <typename T> struct DynamicLUDecomposition {
+  DynamicMatrix<T> lu;
+  std::vector<std::size_t> perm;
+  // Determinant of the permutation
+  T sign;
+  // Exactly zero pivot was met
+  bool singular;
+};
+
+// Elimination updates contiguous rows below the pivot, which are split between
+// workers for large matrices
+template <std::floating_point T>
+DynamicLUDecomposition<T> lu(DynamicMatrix<T> const &a,
+                             ThreadPool &pool = default_thread_pool()) {
+  assert(a.size_x() == a.size_y());
+  auto N = a.size_x();
+  auto result = DynamicLUDecomposition<T>{a, std::vector<std::size_t>(N), T{1},
+                                          false};
+  std::iota(result.perm.begin(), result.perm.end(), std::size_t{0});
+  auto &m = result.lu;
+  for (std::size_t k = 0; k < N; ++k) {
+    auto pivot = k;
+    for (std::size_t y = k + 1; y < N; ++y) {
+      if (std::abs(m[k, y]) > std::abs(m[k, pivot]))
+        pivot = y;
+    }
+    if (m[k, pivot] == T{0}) {
+      result.singular = true;
+      continue;
+    }
+    if (pivot != k) {
+      std::swap_ranges(m.row(k).begin(), m.row(k).end(), m.row(pivot).begin());
+      std::swap(result.perm[k], result.perm[pivot]);
+      result.sign = -result.sign;
+    }
+    auto eliminate = [&m, k, N](std::size_t begin, std::size_t end,
+                                std::size_t) {
+      auto const *rk = m.data() + k * m.ld();
+      for (auto y = k + 1 + begin; y < k + 1 + end; ++y) {
+        auto *ry = m.data() + y * m.ld();
+        auto l = ry[k] / rk[k];
+        ry[k] = l;
+        for (std::size_t x = k + 1; x < N; ++x)
+          ry[x] -= l * rk[x];
+      }
+    };
+    auto rows = N - k - 1;
+    if (rows * (N - k) < details_::dynamic_parallel_work || pool.size() == 1)
+      eliminate(0, rows, 0);
+    else
+      pool.parallel_for(rows, (rows + pool.size() - 1) / pool.size(),
+                        eliminate);
+  }
+  return result;
+}
+
+// Solves A * X = B for every column of B, given decomposition of A.
+// Substitution runs over whole rows of X at once.
+template <std::floating_point T>
+DynamicMatrix<T> solve(DynamicLUDecomposition<T> const &d,
+                       DynamicMatrix<T> const &b) {
+  assert(!d.singular);
+  auto const &m = d.lu;
+  auto N = m.size_y();
+  assert(b.size_y() == N);
+  auto x = DynamicMatrix<T>(b.size_x(), N);
+  for (std::size_t y = 0; y < N; ++y) {
+    auto row = x.row(y);
+    std::ranges::copy(b.row(d.perm[y]), row.begin());
+    for (std::size_t k = 0; k < y; ++k) {
+      auto l = m[k, y];
+      auto rk = x.row(k);
+      for (std::size_t c = 0; c < row.size(); ++c)
+        row[c] -= l * rk[c];
+    }
+  }
+  for (std::size_t y = N; y-- > 0;) {
+    auto row = x.row(y);
+    for (std::size_t k = y + 1; k < N; ++k) {
+      auto u = m[k, y];
+      auto rk = x.row(k);
+      for (std::size_t c = 0; c < row.size(); ++c)
+        row[c] -= u * rk[c];
+    }
+    auto pivot = m[y, y];
+    for (auto &v : row)
+      v /= pivot;
+  }
+  return x;
+}
+
+template <std::floating_point T>
+DynamicMatrix<T> solve(DynamicMatrix<T> const &a, DynamicMatrix<T> const &b) {
+  return solve(lu(a), b);
+}
+
+template <std::floating_point T> T det(DynamicMatrix<T> const &a) {
+  auto d = lu(a);
+  if (d.singular)
+    return T{0};
+  auto res = d.sign;
+  for (std::size_t i = 0; i < a.size_x(); ++i)
+    res *= d.lu[i, i];
+  return res;
+}
+
+template <typename T> DynamicMatrix<T> dynamic_eye(std::size_t n) {
+  auto m = DynamicMatrix<T>(n, n);
+  for (std::size_t i = 0; i < n; ++i)
+    m[i, i] = T{1};
+  return m;
+}
+
+template <std::floating_point T>
+DynamicMatrix<T> inv(DynamicMatrix<T> const &a) {
+  return solve(a, dynamic_eye<T>(a.size_x()));
+}
+
+template <typename T>
+std::ostream &operator<<(std::ostream &os, DynamicMatrix<T> const &m) {
+  for (std::size_t y = 0; y < m.size_y(); ++y) {
+    for (std::size_t x = 0; x < m.size_x(); ++x) {
+      os << m[x, y] << " ";
+    }
+    os << "\n";
+  }
+  return os;
+}
+
+} // namespace cpp_contests
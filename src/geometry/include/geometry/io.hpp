@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CPP_CONTESTS_HAS_MMAP 1
+#endif
+
+#include <fmt/core.h>
+
+#include "geometry/triangle.hpp"
+#include "geometry/triangle_batch.hpp"
+
+// Triangle mesh input.
+// Supported formats:
+//  * text: number of triangles N followed by 9N coordinates,
+//  * float64 / float32: raw little-endian arrays of 9 coordinates per
+//    triangle without any header, e.g. produced by save_raw_mesh,
+//  * stl: binary STL.
+// Files are memory-mapped, so coordinates go straight from the page cache
+// into the structure of arrays store.
+
+namespace cpp_contests {
+
+static_assert(std::endian::native == std::endian::little,
+              "Binary mesh formats are read without byte swapping");
+
+enum class MeshFormat { text, float64, float32, stl };
+
+// Read-only view of a whole file. Uses mmap where available and reads the file
+// into memory otherwise.
+class MappedFile final {
+private:
+  std::byte const *data_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<std::byte> buffer_;
+  bool mapped_ = false;
+
+public:
+  explicit MappedFile(std::filesystem::path const &path) {
+#ifdef CPP_CONTESTS_HAS_MMAP
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(),
+                              fmt::format("Error opening '{}'", path.string()));
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      auto err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(),
+                              fmt::format("Error reading '{}'", path.string()));
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ != 0) {
+      auto *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<std::byte const *>(addr);
+        mapped_ = true;
+      }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0)
+      return;
+#endif
+    read_(path);
+  }
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  MappedFile(MappedFile &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        buffer_(std::move(other.buffer_)),
+        mapped_(std::exchange(other.mapped_, false)) {}
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      unmap_();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      buffer_ = std::move(other.buffer_);
+      mapped_ = std::exchange(other.mapped_, false);
+    }
+    return *this;
+  }
+  ~MappedFile() { unmap_(); }
+
+  [[nodiscard]] std::span<std::byte const> bytes() const noexcept {
+    return {data_, size_};
+  }
+  [[nodiscard]] std::string_view text() const noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<char const *>(data_), size_};
+  }
+
+private:
+  void read_(std::filesystem::path const &path) {
+    auto input = std::ifstream{path, std::ios::binary};
+    if (!input.good())
+      throw std::runtime_error(
+          fmt::format("Error opening '{}'", path.string()));
+    buffer_.resize(std::filesystem::file_size(path));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    input.read(reinterpret_cast<char *>(buffer_.data()),
+               static_cast<std::streamsize>(buffer_.size()));
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+  void unmap_() noexcept {
+#ifdef CPP_CONTESTS_HAS_MMAP
+    if (mapped_)
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      ::munmap(const_cast<std::byte *>(data_), size_);
+#endif
+    mapped_ = false;
+  }
+};
+
+namespace details_ {
+
+constexpr bool is_space(char c) noexcept {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+class TextReader final {
+private:
+  char const *begin_;
+  char const *cur_;
+  char const *end_;
+
+public:
+  explicit TextReader(std::string_view text) noexcept
+      : begin_(text.data()), cur_(text.data()),
+        end_(text.data() + text.size()) {}
+
+  template <typename T> T next() {
+    while (cur_ != end_ && is_space(*cur_))
+      ++cur_;
+    auto value = T{};
+    auto [ptr, ec] = std::from_chars(cur_, end_, value);
+    if (ec != std::errc{})
+      throw std::runtime_error(
+          fmt::format("Expected a number at offset {}", cur_ - begin_));
+    cur_ = ptr;
+    return value;
+  }
+};
+
+template <typename Raw> Raw load_raw(std::byte const *p) noexcept {
+  auto value = Raw{};
+  std::memcpy(&value, p, sizeof(Raw));
+  return value;
+}
+
+// Transposes n triangles of 9 coordinates each, stored with the given stride
+// in bytes, into the batch
+template <typename T, typename Raw>
+void load_triangles(std::byte const *data, std::size_t n, std::size_t stride,
+                    TriangleBatch<T> &batch) {
+  batch.resize(n);
+  auto coords = std::array<T *, 9>{};
+  for (std::size_t v = 0; v < 3; ++v) {
+    for (std::size_t c = 0; c < 3; ++c)
+      coords[3 * v + c] = batch.coord(v, c);
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    auto const *triangle = data + i * stride;
+    for (std::size_t k = 0; k < 9; ++k)
+      coords[k][i] = static_cast<T>(load_raw<Raw>(triangle + k * sizeof(Raw)));
+  }
+}
+
+} // namespace details_
+
+template <typename T = double>
+TriangleBatch<T> parse_text_mesh(std::string_view text) {
+  auto reader = details_::TextReader{text};
+  auto n = reader.next<std::size_t>();
+  // Every coordinate takes at least two characters
+  if (n > text.size() / 18 + 1)
+    throw std::runtime_error(
+        fmt::format("Too many triangles {} for input of {} bytes", n,
+                    text.size()));
+  auto batch = TriangleBatch<T>{};
+  batch.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t v = 0; v < 3; ++v) {
+      for (std::size_t c = 0; c < 3; ++c)
+        batch.coord(v, c)[i] = static_cast<T>(reader.next<double>());
+    }
+  }
+  return batch;
+}
+
+template <typename Raw, typename T = double>
+TriangleBatch<T> parse_raw_mesh(std::span<std::byte const> bytes) {
+  static_assert(std::is_floating_point_v<Raw>);
+  constexpr auto stride = 9 * sizeof(Raw);
+  if (bytes.size() % stride != 0)
+    throw std::runtime_error(fmt::format(
+        "Size of raw mesh {} is not a multiple of {}", bytes.size(), stride));
+  auto batch = TriangleBatch<T>{};
+  details_::load_triangles<T, Raw>(bytes.data(), bytes.size() / stride, stride,
+                                   batch);
+  return batch;
+}
+
+template <typename T = double>
+TriangleBatch<T> parse_stl_mesh(std::span<std::byte const> bytes) {
+  constexpr std::size_t header = 80;
+  constexpr std::size_t stride = 50;
+  // Normal precedes vertices in every record
+  constexpr std::size_t normal = 3 * sizeof(float);
+  if (bytes.size() < header + sizeof(std::uint32_t))
+    throw std::runtime_error("STL file is too short");
+  auto n = details_::load_raw<std::uint32_t>(bytes.data() + header);
+  auto const *records = bytes.data() + header + sizeof(std::uint32_t);
+  if (bytes.size() != header + sizeof(std::uint32_t) + n * stride)
+    throw std::runtime_error(fmt::format(
+        "STL file size {} does not match {} triangles", bytes.size(), n));
+  auto batch = TriangleBatch<T>{};
+  details_::load_triangles<T, float>(records + normal, n, stride, batch);
+  return batch;
+}
+
+inline MeshFormat mesh_format(std::filesystem::path const &path) {
+  auto ext = path.extension().string();
+  if (ext == ".f64")
+    return MeshFormat::float64;
+  if (ext == ".f32")
+    return MeshFormat::float32;
+  if (ext == ".stl" || ext == ".STL")
+    return MeshFormat::stl;
+  return MeshFormat::text;
+}
+
+template <typename T = double>
+TriangleBatch<T> load_mesh(std::filesystem::path const &path,
+                           std::optional<MeshFormat> format = std::nullopt) {
+  auto file = MappedFile{path};
+  switch (format.value_or(mesh_format(path))) {
+  case MeshFormat::text:
+    return parse_text_mesh<T>(file.text());
+  case MeshFormat::float64:
+    return parse_raw_mesh<double, T>(file.bytes());
+  case MeshFormat::float32:
+    return parse_raw_mesh<float, T>(file.bytes());
+  case MeshFormat::stl:
+    return parse_stl_mesh<T>(file.bytes());
+  }
+  return {};
+}
+
+// Writes triangles as a raw array of 9 coordinates per triangle
+template <typename Raw>
+void save_raw_mesh(std::filesystem::path const &path,
+                   std::span<Triangle const> triangles) {
+  static_assert(std::is_floating_point_v<Raw>);
+  auto data = std::vector<Raw>{};
+  data.reserve(9 * triangles.size());
+  for (auto const &t : triangles) {
+    for (std::size_t v = 0; v < 3; ++v) {
+      for (std::size_t c = 0; c < 3; ++c)
+        data.push_back(static_cast<Raw>(t[v][c]));
+    }
+  }
+  auto output = std::ofstream{path, std::ios::binary};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  output.write(reinterpret_cast<char const *>(data.data()),
+               static_cast<std::streamsize>(data.size() * sizeof(Raw)));
+  if (!output.good())
+    throw std::runtime_error(
+        fmt::format("Error writing '{}'", path.string()));
+}
+
+} // namespace cpp_contests
@@ -4,12 +4,18 @@
 #include <array>
 #include <cassert>
 #include <compare>
+#include <concepts>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <type_traits>
+#include <utility>
 
+#include "geometry/arithmetic.hpp"
+#include "geometry/simd.hpp"
 #include "utils/math.hpp"
 
 namespace cpp_contests {
@@ -113,6 +119,9 @@ private:
             difference_type i_tr) noexcept(noexcept(begin + i_tr)) {
     assert(i_tr >= 0);
     assert(static_cast<size_t>(i_tr) <= X * Y);
+    // Rows and columns are laid out the same way transposed
+    if constexpr (X == 1 || Y == 1)
+      return begin + i_tr;
     if (i_tr == X * Y)
       return begin + i_tr;
     auto x_tr = i_tr / Y;
@@ -146,6 +155,27 @@ operator-(TransposeIterator<Iterator, X, Y> const &it,
   return tmp;
 }
 
+// Anything of matrix shape with element access in row-major order: Matrix
+// itself or lazy arithmetic expression over matrices
+template <typename E>
+concept MatrixExpression = requires(E const &e, std::size_t i) {
+  typename std::remove_cvref_t<E>::value_type;
+  { std::remove_cvref_t<E>::size_x() } -> std::convertible_to<std::size_t>;
+  { std::remove_cvref_t<E>::size_y() } -> std::convertible_to<std::size_t>;
+  { e[i] } -> std::convertible_to<typename std::remove_cvref_t<E>::value_type>;
+};
+
+template <MatrixExpression E>
+using expression_value_t = typename std::remove_cvref_t<E>::value_type;
+
+template <typename A, typename B>
+concept SameShape = MatrixExpression<A> && MatrixExpression<B> &&
+                    std::remove_cvref_t<A>::size_x() ==
+                        std::remove_cvref_t<B>::size_x() &&
+                    std::remove_cvref_t<A>::size_y() ==
+                        std::remove_cvref_t<B>::size_y() &&
+                    std::same_as<expression_value_t<A>, expression_value_t<B>>;
+
 //    Memory, X axis
 //    ───────────────►
 //  Y│
@@ -192,6 +222,25 @@ public:
   constexpr Matrix(Iterator first, Iterator last) noexcept {
     std::copy(first, last, data_.begin());
   }
+  // Evaluates expression in a single pass
+  template <MatrixExpression E>
+    requires(!std::is_same_v<std::remove_cvref_t<E>, Matrix> &&
+             SameShape<E, Matrix>)
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr Matrix(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      data_[i] = e[i];
+  }
+  template <MatrixExpression E>
+    requires(!std::is_same_v<std::remove_cvref_t<E>, Matrix> &&
+             SameShape<E, Matrix>)
+  constexpr Matrix &operator=(E const &e) noexcept {
+    // Every element of an expression depends only on the elements with the
+    // same index, so it is safe to assign an expression over *this
+    for (std::size_t i = 0; i < X * Y; ++i)
+      data_[i] = e[i];
+    return *this;
+  }
 
   // clang-format off
   template <typename... Matrices>
@@ -361,15 +410,19 @@ public:
     Matrix m = *this;
     return m.elementwise([](value_type x) noexcept { return -x; });
   }
-  template <std::convertible_to<value_type> MT>
-  constexpr Matrix &operator+=(Matrix<X, Y, MT> const &m) noexcept {
-    return elementwise(
-        m, [](value_type a, value_type b) noexcept { return a + b; });
+  template <MatrixExpression E>
+    requires SameShape<E, Matrix>
+  constexpr Matrix &operator+=(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      data_[i] += e[i];
+    return *this;
   }
-  template <std::convertible_to<value_type> MT>
-  constexpr Matrix &operator-=(Matrix<X, Y, MT> const &m) noexcept {
-    return elementwise(
-        m, [](value_type a, value_type b) noexcept { return a - b; });
+  template <MatrixExpression E>
+    requires SameShape<E, Matrix>
+  constexpr Matrix &operator-=(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      data_[i] -= e[i];
+    return *this;
   }
   constexpr Matrix &operator+=(value_type x) noexcept {
     return elementwise([x](value_type a) noexcept { return a + x; });
@@ -413,121 +466,492 @@ constexpr Matrix<1, Y, T> iota(T value = T{0}) noexcept {
   return m;
 }
 
-template <std::size_t X, std::size_t Y, std::integral T>
-constexpr bool operator==(Matrix<X, Y, T> const &a,
-                          Matrix<X, Y, T> const &b) noexcept {
-  auto &&it = std::mismatch(a.begin(), a.end(), b.begin());
-  return it.first == a.end();
-}
+namespace details_ {
+
+template <typename T> struct is_matrix : std::false_type {};
 template <std::size_t X, std::size_t Y, typename T>
-constexpr Matrix<X, Y, T> operator+(Matrix<X, Y, T> const &a,
-                                    Matrix<X, Y, T> const &b) noexcept {
-  Matrix<X, Y, T> m = a;
-  m += b;
-  return m;
+struct is_matrix<Matrix<X, Y, T>> : std::true_type {};
+
+// Operands of expressions: lvalues are referenced, temporaries are moved in,
+// so expressions built from temporaries can outlive the full expression
+template <typename E>
+using operand_t = std::conditional_t<std::is_lvalue_reference_v<E>, E,
+                                     std::remove_cvref_t<E>>;
+
+// Expressions, which elements are read from memory rather than computed, so
+// reading them many times is cheap, e.g. Matrix and views over it
+template <typename E> constexpr bool is_stored = is_matrix<E>::value;
+
+} // namespace details_
+
+template <typename E>
+concept PlainMatrix = details_::is_matrix<std::remove_cvref_t<E>>::value;
+
+// Lazy elementwise operation over two expressions of the same shape
+template <typename Op, typename L, typename R> class BinaryExpression final {
+public:
+  using value_type = expression_value_t<L>;
+
+private:
+  details_::operand_t<L> l_;
+  details_::operand_t<R> r_;
+  [[no_unique_address]] Op op_;
+
+public:
+  constexpr BinaryExpression(L &&l, R &&r, Op op = Op{}) noexcept
+      : l_(std::forward<L>(l)), r_(std::forward<R>(r)), op_(op) {}
+
+  [[nodiscard]] static constexpr std::size_t size_x() noexcept {
+    return std::remove_cvref_t<L>::size_x();
+  }
+  [[nodiscard]] static constexpr std::size_t size_y() noexcept {
+    return std::remove_cvref_t<L>::size_y();
+  }
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return size_x() * size_y();
+  }
+  constexpr value_type operator[](std::size_t i) const noexcept {
+    return op_(l_[i], r_[i]);
+  }
+  constexpr value_type operator[](std::size_t x, std::size_t y) const noexcept {
+    return operator[](y * size_x() + x);
+  }
+};
+
+// Lazy elementwise function of a single expression
+template <typename Op, typename E> class UnaryExpression final {
+public:
+  using value_type = expression_value_t<E>;
+
+private:
+  details_::operand_t<E> e_;
+  Op op_;
+
+public:
+  constexpr UnaryExpression(E &&e, Op op) noexcept
+      : e_(std::forward<E>(e)), op_(op) {}
+
+  [[nodiscard]] static constexpr std::size_t size_x() noexcept {
+    return std::remove_cvref_t<E>::size_x();
+  }
+  [[nodiscard]] static constexpr std::size_t size_y() noexcept {
+    return std::remove_cvref_t<E>::size_y();
+  }
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return size_x() * size_y();
+  }
+  constexpr value_type operator[](std::size_t i) const noexcept {
+    return op_(e_[i]);
+  }
+  constexpr value_type operator[](std::size_t x, std::size_t y) const noexcept {
+    return operator[](y * size_x() + x);
+  }
+};
+
+template <typename Op, typename L, typename R>
+BinaryExpression(L &&, R &&, Op) -> BinaryExpression<Op, L, R>;
+template <typename Op, typename E>
+UnaryExpression(E &&, Op) -> UnaryExpression<Op, E>;
+
+// Materializes an expression, e.g. to pass it to a function, which deduces
+// Matrix template parameters
+template <MatrixExpression E>
+constexpr Matrix<std::remove_cvref_t<E>::size_x(),
+                 std::remove_cvref_t<E>::size_y(), expression_value_t<E>>
+eval(E const &e) noexcept {
+  return e;
 }
-template <std::size_t X, std::size_t Y, typename T>
-constexpr Matrix<X, Y, T> operator-(Matrix<X, Y, T> const &a,
-                                    Matrix<X, Y, T> const &b) noexcept {
-  Matrix<X, Y, T> m = a;
-  m -= b;
-  return m;
+
+// Scalar operand of an expression, which must not be a matrix itself. Note
+// that Matrix<1, 1, T> is convertible to T.
+template <typename S, typename E>
+concept ScalarFor = MatrixExpression<E> && !MatrixExpression<S> &&
+                    std::convertible_to<S, expression_value_t<E>>;
+
+template <MatrixExpression A, MatrixExpression B>
+  requires SameShape<A, B> && std::integral<expression_value_t<A>>
+constexpr bool operator==(A const &a, B const &b) noexcept {
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (a[i] != b[i])
+      return false;
+  }
+  return true;
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator+(Matrix<X, Y, T1> const &a, T2 v) noexcept {
-  Matrix<X, Y, T1> m = a;
-  m += v;
-  return m;
+template <MatrixExpression A, MatrixExpression B>
+  requires SameShape<A, B>
+constexpr auto operator+(A &&a, B &&b) noexcept {
+  return BinaryExpression(std::forward<A>(a), std::forward<B>(b),
+                          std::plus<>{});
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator+(T2 v, Matrix<X, Y, T1> const &a) noexcept {
-  return a + v;
+template <MatrixExpression A, MatrixExpression B>
+  requires SameShape<A, B>
+constexpr auto operator-(A &&a, B &&b) noexcept {
+  return BinaryExpression(std::forward<A>(a), std::forward<B>(b),
+                          std::minus<>{});
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator-(Matrix<X, Y, T1> const &a, T2 v) noexcept {
-  return a + (-v);
+template <MatrixExpression E>
+  requires(!PlainMatrix<E>)
+constexpr auto operator-(E &&e) noexcept {
+  return UnaryExpression(std::forward<E>(e), std::negate<>{});
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator-(T2 v, Matrix<X, Y, T1> const &a) noexcept {
-  return (-a) + v;
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator+(E &&e, S v) noexcept {
+  return UnaryExpression(std::forward<E>(e),
+                         [v = static_cast<expression_value_t<E>>(v)](
+                             auto x) noexcept { return x + v; });
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator*(Matrix<X, Y, T1> const &a, T2 v) noexcept {
-  Matrix<X, Y, T1> m = a;
-  m *= v;
-  return m;
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator+(S v, E &&e) noexcept {
+  return std::forward<E>(e) + v;
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator*(T2 v, Matrix<X, Y, T1> const &a) noexcept {
-  return a * v;
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator-(E &&e, S v) noexcept {
+  return UnaryExpression(std::forward<E>(e),
+                         [v = static_cast<expression_value_t<E>>(v)](
+                             auto x) noexcept { return x - v; });
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator/(Matrix<X, Y, T1> const &a, T2 v) {
-  return a * (T1{1} / v);
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator-(S v, E &&e) noexcept {
+  return UnaryExpression(std::forward<E>(e),
+                         [v = static_cast<expression_value_t<E>>(v)](
+                             auto x) noexcept { return v - x; });
 }
-template <std::size_t X, std::size_t Y, typename T1, std::convertible_to<T1> T2>
-constexpr Matrix<X, Y, T1> operator%(Matrix<X, Y, T1> const &a, T2 v) {
-  Matrix<X, Y, T1> m = a;
-  m %= v;
-  return m;
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator*(E &&e, S v) noexcept {
+  return UnaryExpression(std::forward<E>(e),
+                         [v = static_cast<expression_value_t<E>>(v)](
+                             auto x) noexcept { return x * v; });
+}
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator*(S v, E &&e) noexcept {
+  return std::forward<E>(e) * v;
+}
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator/(E &&e, S v) {
+  using T = expression_value_t<E>;
+  if constexpr (std::floating_point<T>) {
+    return std::forward<E>(e) * (T{1} / static_cast<T>(v));
+  } else {
+    return UnaryExpression(std::forward<E>(e), [v = static_cast<T>(v)](
+                                                   auto x) { return x / v; });
+  }
+}
+template <MatrixExpression E, ScalarFor<E> S>
+constexpr auto operator%(E &&e, S v) {
+  return UnaryExpression(std::forward<E>(e),
+                         [v = static_cast<expression_value_t<E>>(v)](
+                             auto x) noexcept { return x % v; });
 }
 
-template <std::size_t X, std::size_t Y, typename T>
-constexpr T norm(Matrix<X, Y, T> const &a) noexcept {
-  return sqrt(std::transform_reduce(a.begin(), a.end(), a.begin(), T{}));
+namespace details_ {
+
+template <MatrixExpression E>
+constexpr std::size_t expression_size =
+    std::remove_cvref_t<E>::size_x() * std::remove_cvref_t<E>::size_y();
+
+// f(0) + f(1) + ... + f(N - 1), summed left to right as a loop would do.
+// Sizes up to 4 are unrolled into straight-line code, so vector operations
+// have no loop counter and no branches even before the optimizer runs.
+template <std::size_t N, typename T, typename F>
+constexpr T sum_of(F const &f) noexcept {
+  if constexpr (N >= 1 && N <= 4) {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return (... + f(I));
+    }(std::make_index_sequence<N>{});
+  } else {
+    T sum{};
+    for (std::size_t i = 0; i < N; ++i)
+      sum += f(i);
+    return sum;
+  }
 }
-template <std::size_t X, std::size_t Y, typename T>
-constexpr T n(Matrix<X, Y, T> const &a) noexcept {
+
+} // namespace details_
+
+template <MatrixExpression E>
+constexpr expression_value_t<E> norm(E const &a) noexcept {
+  using T = expression_value_t<E>;
+  return sqrt(details_::sum_of<details_::expression_size<E>, T>(
+      [&](std::size_t i) { return a[i] * a[i]; }));
+}
+template <MatrixExpression E>
+constexpr expression_value_t<E> n(E const &a) noexcept {
   return norm(a);
 }
 template <std::size_t X, std::size_t Y, typename T>
 constexpr Matrix<Y, X, T> transpose(Matrix<X, Y, T> const &a) noexcept {
-  return Matrix<Y, X, T>(a.tbegin(), a.tend());
+  if constexpr (X == 1 || Y == 1)
+    return Matrix<Y, X, T>(a.begin(), a.end());
+  else
+    return Matrix<Y, X, T>(a.tbegin(), a.tend());
 }
-template <std::size_t X, std::size_t Y, typename T>
-constexpr Matrix<Y, X, T> t(Matrix<X, Y, T> const &a) noexcept {
+template <MatrixExpression E>
+  requires(!PlainMatrix<E>)
+constexpr auto transpose(E const &e) noexcept {
+  return transpose(eval(e));
+}
+template <MatrixExpression E> constexpr auto t(E const &a) noexcept {
   return transpose(a);
 }
 
+namespace details_ {
+
+// Row form of the product: row y of c is the sum of rows k of b scaled by
+// a[k, y]. Rows of b and c are contiguous, so no transposition is needed and
+// the innermost loop is vectorizable.
+// Row is accumulated locally, since c may not be proven not to alias b.
+// Operands may be any stored expressions, e.g. strided views.
+template <typename A, typename B, std::size_t Z, std::size_t Y, typename T>
+constexpr void multiply_rows(A const &a, B const &b, Matrix<Z, Y, T> &c,
+                             std::size_t z_begin = 0) {
+  for (std::size_t y = 0; y < Y; ++y) {
+    auto row = std::array<T, Z>{};
+    for (std::size_t k = 0; k < A::size_x(); ++k) {
+      auto scale = a[k, y];
+      for (std::size_t z = z_begin; z < Z; ++z)
+        row[z] += scale * b[z, k];
+    }
+    for (std::size_t z = z_begin; z < Z; ++z)
+      c[z, y] = row[z];
+  }
+}
+
+// Computes R rows and C packs of W columns of c starting from (z0, y0).
+// The whole tile is accumulated in registers while k runs over X.
+template <std::size_t R, std::size_t C, std::size_t W, std::size_t X,
+          std::size_t Y, std::size_t Z, typename T>
+void multiply_tile(Matrix<X, Y, T> const &a, Matrix<Z, X, T> const &b,
+                   Matrix<Z, Y, T> &c, std::size_t z0,
+                   std::size_t y0) noexcept {
+  using P = simd::Pack<T, W>;
+  auto const *pb = std::to_address(b.begin());
+  auto acc = std::array<P, R * C>{};
+  for (std::size_t k = 0; k < X; ++k) {
+    auto row = std::array<P, C>{};
+    for (std::size_t j = 0; j < C; ++j)
+      row[j] = P::load(pb + k * Z + z0 + j * W);
+    for (std::size_t i = 0; i < R; ++i) {
+      auto scale = P{a[k, y0 + i]};
+      for (std::size_t j = 0; j < C; ++j)
+        acc[i * C + j] = fma(scale, row[j], acc[i * C + j]);
+    }
+  }
+  auto *pc = std::to_address(c.begin());
+  for (std::size_t i = 0; i < R; ++i) {
+    for (std::size_t j = 0; j < C; ++j)
+      acc[i * C + j].store(pc + (y0 + i) * Z + z0 + j * W);
+  }
+}
+
+// Widest SIMD pack, which fits into a row of Z elements
+template <typename T, std::size_t Z> constexpr std::size_t tile_width() {
+  auto w = simd::native_width<T>;
+  while (w > Z)
+    w /= 2;
+  return w;
+}
+
+// Register-tiled product for matrices, which rows hold at least one SIMD
+// register. Tile sizes are chosen at compile time from X, Y and Z.
+template <std::size_t X, std::size_t Y, std::size_t Z, typename T>
+void multiply_tiled(Matrix<X, Y, T> const &a, Matrix<Z, X, T> const &b,
+                    Matrix<Z, Y, T> &c) noexcept {
+  constexpr std::size_t W = tile_width<T, Z>();
+  constexpr std::size_t C = std::min<std::size_t>(Z / W, 2);
+  constexpr std::size_t R = std::min<std::size_t>(Y, 4);
+  constexpr std::size_t full_z = Z / (C * W) * (C * W);
+  constexpr std::size_t full_y = Y / R * R;
+  // Remaining columns, which still fill whole packs
+  constexpr std::size_t tail_c = (Z - full_z) / W;
+
+  for (std::size_t z0 = 0; z0 < full_z; z0 += C * W) {
+    for (std::size_t y0 = 0; y0 < full_y; y0 += R)
+      multiply_tile<R, C, W>(a, b, c, z0, y0);
+    if constexpr (Y % R != 0)
+      multiply_tile<Y % R, C, W>(a, b, c, z0, full_y);
+  }
+  if constexpr (tail_c != 0) {
+    for (std::size_t y0 = 0; y0 < full_y; y0 += R)
+      multiply_tile<R, tail_c, W>(a, b, c, full_z, y0);
+    if constexpr (Y % R != 0)
+      multiply_tile<Y % R, tail_c, W>(a, b, c, full_z, full_y);
+  }
+  if constexpr (full_z + tail_c * W < Z)
+    multiply_rows(a, b, c, full_z + tail_c * W);
+}
+
+} // namespace details_
+
 template <std::size_t X, std::size_t Y, std::size_t Z, typename T>
 constexpr Matrix<Z, Y, T> operator*(Matrix<X, Y, T> const &a,
                                     Matrix<Z, X, T> const &b) noexcept {
   Matrix<Z, Y, T> m{};
-  for (std::size_t i = 0; i < Z * Y; ++i) {
-    auto z = i % Z;
-    auto y = i / Z;
-    m[z, y] = std::transform_reduce(a.begin() + y * X, a.begin() + (y + 1) * X,
-                                    b.tbegin() + z * X, T{});
+  if consteval {
+    details_::multiply_rows(a, b, m);
+  } else {
+    if constexpr (simd::is_native<T, details_::tile_width<T, Z>()>)
+      details_::multiply_tiled(a, b, m);
+    else
+      details_::multiply_rows(a, b, m);
   }
   return m;
 }
-template <std::size_t X, std::size_t Y, typename T>
-constexpr T dot(Matrix<X, Y, T> const &a, Matrix<X, Y, T> const &b) noexcept {
-  return std::transform_reduce(a.begin(), a.end(), b.begin(), T{});
+namespace details_ {
+
+// Product reads every element of its operands many times, so computed
+// expressions are materialized first, while stored ones are used in place
+template <MatrixExpression E>
+constexpr decltype(auto) product_operand(E const &e) noexcept {
+  if constexpr (is_stored<E>)
+    return e;
+  else
+    return eval(e);
 }
 
-template <typename T>
-constexpr Vector<3, T> cross(Vector<3, T> const &a,
-                             Vector<3, T> const &b) noexcept {
+} // namespace details_
+
+template <MatrixExpression A, MatrixExpression B>
+  requires(!(PlainMatrix<A> && PlainMatrix<B>) && A::size_x() == B::size_y() &&
+           std::same_as<expression_value_t<A>, expression_value_t<B>>)
+constexpr auto operator*(A const &a, B const &b) noexcept {
+  Matrix<B::size_x(), A::size_y(), expression_value_t<A>> m{};
+  auto const &pa = details_::product_operand(a);
+  auto const &pb = details_::product_operand(b);
+  if constexpr (PlainMatrix<decltype(pa)> && PlainMatrix<decltype(pb)>)
+    m = pa * pb;
+  else
+    details_::multiply_rows(pa, pb, m);
+  return m;
+}
+
+template <MatrixExpression A, MatrixExpression B>
+  requires SameShape<A, B>
+constexpr expression_value_t<A> dot(A const &a, B const &b) noexcept {
+  return details_::sum_of<details_::expression_size<A>,
+                          expression_value_t<A>>(
+      [&](std::size_t i) { return a[i] * b[i]; });
+}
+
+template <MatrixExpression A, MatrixExpression B>
+  requires SameShape<A, B> && (std::remove_cvref_t<A>::size_x() == 1) &&
+           (std::remove_cvref_t<A>::size_y() == 3)
+constexpr Vector<3, expression_value_t<A>> cross(A const &a,
+                                                 B const &b) noexcept {
   // clang-format off
-  return Vector<3, T>{a[1] * b[2] - a[2] * b[1],
-                      a[2] * b[0] - a[0] * b[2],
-                      a[0] * b[1] - a[1] * b[0]};
+  return Vector<3, expression_value_t<A>>{a[1] * b[2] - a[2] * b[1],
+                                          a[2] * b[0] - a[0] * b[2],
+                                          a[0] * b[1] - a[1] * b[0]};
   // clang-format on
 }
 
+// LU decomposition with partial pivoting.
+// Rows of the matrix, taken in order perm, are equal to L * U. U is stored on
+// and above the diagonal of lu, L without its unit diagonal below it.
+template <std::size_t N, typename T> struct LUDecomposition {
+  Matrix<N, N, T> lu;
+  MInds<N> perm;
+  // Determinant of the permutation
+  T sign;
+  // Exactly zero pivot was met
+  bool singular;
+};
+
+template <std::size_t N, std::floating_point T>
+constexpr LUDecomposition<N, T> lu(Matrix<N, N, T> const &a) noexcept {
+  auto result = LUDecomposition<N, T>{a, iota<N>(), T{1}, false};
+  auto &m = result.lu;
+  for (std::size_t k = 0; k < N; ++k) {
+    auto pivot = k;
+    for (std::size_t y = k + 1; y < N; ++y) {
+      if (std::abs(m[k, y]) > std::abs(m[k, pivot]))
+        pivot = y;
+    }
+    if (m[k, pivot] == T{0}) {
+      result.singular = true;
+      continue;
+    }
+    if (pivot != k) {
+      for (std::size_t x = 0; x < N; ++x)
+        std::swap(m[x, k], m[x, pivot]);
+      std::swap(result.perm[k], result.perm[pivot]);
+      result.sign = -result.sign;
+    }
+    for (std::size_t y = k + 1; y < N; ++y) {
+      auto l = m[k, y] / m[k, k];
+      m[k, y] = l;
+      for (std::size_t x = k + 1; x < N; ++x)
+        m[x, y] -= l * m[x, k];
+    }
+  }
+  return result;
+}
+
+// Solves A * X = B for every column of B, given decomposition of A
+template <std::size_t N, std::size_t M, typename T>
+constexpr Matrix<M, N, T> solve(LUDecomposition<N, T> const &d,
+                                Matrix<M, N, T> const &b) noexcept {
+  assert(!d.singular);
+  auto const &m = d.lu;
+  Matrix<M, N, T> x{};
+  for (std::size_t c = 0; c < M; ++c) {
+    for (std::size_t y = 0; y < N; ++y) {
+      auto sum = b[c, d.perm[y]];
+      for (std::size_t k = 0; k < y; ++k)
+        sum -= m[k, y] * x[c, k];
+      x[c, y] = sum;
+    }
+    for (std::size_t y = N; y-- > 0;) {
+      auto sum = x[c, y];
+      for (std::size_t k = y + 1; k < N; ++k)
+        sum -= m[k, y] * x[c, k];
+      x[c, y] = sum / m[y, y];
+    }
+  }
+  return x;
+}
+
+// Solves A * X = B without forming the inverse of A
+template <std::size_t N, std::size_t M, std::floating_point T>
+constexpr Matrix<M, N, T> solve(Matrix<N, N, T> const &a,
+                                Matrix<M, N, T> const &b) noexcept {
+  return solve(lu(a), b);
+}
+
+// O(N^3): product of LU pivots for floating point matrices and fraction-free
+// Bareiss elimination for integral ones, which keeps the result exact
 template <std::size_t N, typename T>
 constexpr T det(Matrix<N, N, T> const &a) noexcept {
-  T res{};
-  MInds<N - 1> rows = iota<N - 1>() + 1;
-  MInds<N - 1> cols = iota<N - 1>() + 1;
-  for (std::size_t i = 0; i < N; ++i) {
-    T sign = T{1} - 2 * (i % 2);
-    res += sign * a[i, 0] * det(a[cols, rows]);
-    if (i < N - 1)
-      cols[i] -= 1;
+  if constexpr (std::floating_point<T>) {
+    auto d = lu(a);
+    if (d.singular)
+      return T{0};
+    auto res = d.sign;
+    for (std::size_t i = 0; i < N; ++i)
+      res *= d.lu[i, i];
+    return res;
+  } else {
+    auto m = a;
+    T sign{1};
+    T prev{1};
+    for (std::size_t k = 0; k + 1 < N; ++k) {
+      if (m[k, k] == T{0}) {
+        auto pivot = k + 1;
+        while (pivot < N && m[k, pivot] == T{0})
+          ++pivot;
+        if (pivot == N)
+          return T{0};
+        for (std::size_t x = 0; x < N; ++x)
+          std::swap(m[x, k], m[x, pivot]);
+        sign = -sign;
+      }
+      for (std::size_t y = k + 1; y < N; ++y) {
+        for (std::size_t x = k + 1; x < N; ++x)
+          m[x, y] = (m[x, y] * m[k, k] - m[k, y] * m[x, k]) / prev;
+      }
+      prev = m[k, k];
+    }
+    return sign * m[N - 1, N - 1];
   }
-  return res;
 }
 
 template <typename T> constexpr T det(Matrix<3, 3, T> const &a) noexcept {
@@ -552,35 +976,50 @@ template <typename T, std::size_t N> constexpr T staticpow(T val) {
   else
     return val * staticpow<T, N - 1>(val);
 }
+
+// Exact sign of the determinant of a small float or double matrix
+template <std::size_t N, typename T>
+  requires(N <= 3 && (std::same_as<T, float> || std::same_as<T, double>))
+constexpr int det_sign(Matrix<N, N, T> const &a) noexcept {
+  auto at = [&](std::size_t x, std::size_t y) {
+    return static_cast<double>(a[x, y]);
+  };
+  if constexpr (N == 1) {
+    return (at(0, 0) > 0.0) - (at(0, 0) < 0.0);
+  } else if constexpr (N == 2) {
+    return det2_sign(at(0, 0), at(1, 0), at(0, 1), at(1, 1));
+  } else {
+    auto columns = Columns{};
+    for (std::size_t x = 0; x < 3; ++x)
+      columns[x] = Coords{at(x, 0), at(x, 1), at(x, 2)};
+    return det3_sign(Columns{}, columns);
+  }
+}
+
 } // namespace details_
+
+// Whether det(a) is larger than eps relative to the volume of a
 template <std::size_t N, typename T>
-constexpr bool invertible(Matrix<N, N, T> const &a,
-                          T eps = T{EPSMIN}) noexcept {
+constexpr bool invertible(Matrix<N, N, T> const &a, T eps) noexcept {
   auto det_ = det(a);
   auto volume = details_::staticpow<T, N>(n(a));
   return std::abs(det_) > eps * volume;
 }
 
+// Exact for float and double matrices up to 3x3, the rest are compared
+// with the EPSMIN relative threshold
+template <std::size_t N, typename T>
+constexpr bool invertible(Matrix<N, N, T> const &a) noexcept {
+  if constexpr (requires { details_::det_sign(a); })
+    return details_::det_sign(a) != 0;
+  else
+    return invertible(a, T{EPSMIN});
+}
+
 template <std::size_t N, typename T>
 constexpr Matrix<N, N, T> inv(Matrix<N, N, T> const &a) noexcept {
   assert(invertible(a));
-  Matrix<N, N, T> m{};
-  MInds<N - 1> cols = iota<N - 1>() + 1;
-  for (std::size_t x = 0; x < N; ++x) {
-    MInds<N - 1> rows = iota<N - 1>() + 1;
-    for (std::size_t y = 0; y < N; ++y) {
-      Matrix<N - 1, N - 1, T> minor = a[cols, rows];
-      auto d = det(minor);
-      auto sign = T{1} - 2 * ((x + y) % 2);
-      auto adj = sign * d;
-      m[y, x] = adj;
-      if (y < N - 1)
-        rows[y] -= 1;
-    }
-    if (x < N - 1)
-      cols[x] -= 1;
-  }
-  return m / det(a);
+  return solve(a, eye<N, N, T>());
 }
 
 template <typename T>
@@ -609,10 +1048,10 @@ constexpr Matrix<1, 1, T> inv(Matrix<1, 1, T> const &a) noexcept {
   return Matrix<1, 1, T>{T{1} / a[0, 0]};
 }
 
-template <std::size_t X, std::size_t Y, typename T>
-std::ostream &operator<<(std::ostream &os, Matrix<X, Y, T> const &m) {
-  for (std::size_t y = 0; y < Y; ++y) {
-    for (std::size_t x = 0; x < X; ++x) {
+template <MatrixExpression E>
+std::ostream &operator<<(std::ostream &os, E const &m) {
+  for (std::size_t y = 0; y < std::remove_cvref_t<E>::size_y(); ++y) {
+    for (std::size_t x = 0; x < std::remove_cvref_t<E>::size_x(); ++x) {
       os << m[x, y] << " ";
     }
     os << "\n";
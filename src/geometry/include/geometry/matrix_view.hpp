@@ -1,380 +1,243 @@
 #pragma once
 
-// An alternative draft implementation of a matrix.
-// The core idea is to use Matrix View to perform operations on the matrix.
-// This allows to get arbitrary views on the matrix including transpose, slices,
-// permutes and make operations on them, affects the original matrix. The
-// downside is that we need to actually store two arrays of permuted indices in
-// the iterator, which is quite expensive and makes the whole point of static
-// matrices irrelevant.
-
-#include <algorithm>
-#include <array>
 #include <cassert>
-#include <compare>
-#include <initializer_list>
-#include <iterator>
+#include <cstddef>
+#include <limits>
+#include <memory>
 #include <type_traits>
 
-#include "utils/utils.hpp"
-
-namespace cpp_contests {
-
-template <std::size_t N> using MatrixIndices = std::array<std::size_t, N>;
-
-template <std::random_access_iterator Iterator, size_t X, size_t Y>
-class MatrixIterator final {
-public:
-  using iterator_type = Iterator;
-  using iterator_concept = std::random_access_iterator_tag;
-  using iterator_category = std::random_access_iterator_tag;
-  using difference_type = typename std::iter_difference_t<Iterator>;
-  using value_type = typename std::iter_value_t<Iterator>;
-  using pointer = typename std::iterator_traits<Iterator>::pointer;
-  using reference = typename std::iter_reference_t<Iterator>;
-  static_assert(std::is_signed_v<difference_type>);
-
-  static constexpr std::size_t size_x = X;
-  static constexpr std::size_t size_y = Y;
-
-private:
-  Iterator begin_;
-  difference_type i_ = 0;
-  Iterator it_;
-  bool transposed_ = false;
-  std::size_t real_x_ = X;
-  std::size_t real_y_ = Y;
-  MatrixIndices<X> cols_ = get_indices<X>();
-  MatrixIndices<Y> rows_ = get_indices<Y>();
-
-public:
-  // clang-format off
-  constexpr explicit MatrixIterator(
-      Iterator begin,
-      difference_type i = 0,
-      bool transposed = false,
-      std::size_t real_x = X,
-      std::size_t real_y = Y,
-      MatrixIndices<X> cols = get_indices<X>(),
-      MatrixIndices<Y> rows = get_indices<Y>()
-    ) noexcept(std::is_nothrow_move_constructible_v<Iterator>)
-      : begin_(std::move(begin)),
-        i_(i),
-        it_(transform(begin, i, transposed, real_x, real_y, cols, rows)),
-        transposed_(transposed),
-        real_x_(real_x),
-        real_y_(real_y),
-        cols_(std::move(cols)),
-        rows_(std::move(rows)) {
-    #ifndef NDEBUG
-      // rows and cols must be unique
-      auto debug_cols = cols_;
-      auto debug_rows = rows_;
-      std::sort(debug_cols.begin(), debug_cols.end());
-      std::sort(debug_rows.begin(), debug_rows.end());
-      assert(std::unique(debug_cols.begin(), debug_cols.end()) == debug_cols.end());
-      assert(std::unique(debug_rows.begin(), debug_rows.end()) == debug_rows.end());
-    #endif
-  }
-  // clang-format on
-  constexpr explicit MatrixIterator() noexcept(
-      std::is_nothrow_constructible_v<Iterator>) = default;
-
-  constexpr iterator_type base() const
-      noexcept(std::is_nothrow_copy_constructible_v<Iterator>) {
-    return it_;
-  }
-  constexpr reference operator*() const {
-    assert(i_ >= 0 && i_ < X * Y);
-    return *it_;
-  }
-  constexpr pointer operator->() const
-    requires(std::is_pointer_v<Iterator> ||
-             requires(Iterator const i) { i.operator->(); })
-  {
-    assert(i_ >= 0 && i_ < X * Y);
-    return it_.operator->();
-  }
-  constexpr value_type const &operator[](difference_type n) const {
-    assert(i_ + n >= 0 && i_ + n < X * Y);
-    return *transform(i_ + n);
-  }
+#include "geometry/matrix.hpp"
 
-  constexpr MatrixIterator &operator+=(difference_type n) {
-    it_ = transform(i_ + n);
-    i_ += n;
-    return *this;
-  }
-  constexpr MatrixIterator &operator-=(difference_type n) {
-    return operator+=(-n);
-  }
-  constexpr MatrixIterator &operator++() { return operator+=(1); }
-  constexpr MatrixIterator &operator--() { return operator-=(1); }
-  constexpr MatrixIterator operator++(int) {
-    auto tmp = *this;
-    operator++();
-    return tmp;
-  }
-  constexpr MatrixIterator operator--(int) {
-    auto tmp = *this;
-    operator--();
-    return tmp;
-  }
+// Non-owning views of matrices.
+// Element (x, y) of a view is data[x * stride_x + y * stride_y], so slices,
+// strided rows and columns and transposes are all the same type and cost a
+// pointer and at most two integers. Strides known at compile time are not
+// stored at all. Views are matrix expressions, so they are accepted by
+// arithmetic and operator* without copying, and writes through a view of a
+// non-const matrix modify the matrix.
 
-  constexpr MatrixIterator
-  operator-(typename MatrixIterator::difference_type n) const {
-    auto tmp = it_;
-    tmp -= n;
-    return tmp;
-  }
-  friend constexpr difference_type operator-(MatrixIterator const &lhs,
-                                             MatrixIterator const &rhs) {
-    return lhs.i_ - rhs.i_;
-  }
-  friend constexpr bool operator==(MatrixIterator const &lhs,
-                                   MatrixIterator const &rhs) {
-    return lhs.begin_ == rhs.begin_ && lhs.it_ == rhs.it_ &&
-           lhs.transposed_ == rhs.transposed_ && lhs.rows_ == rhs.rows_ &&
-           lhs.cols_ == rhs.cols_;
-  }
-  friend constexpr std::partial_ordering
-  operator<=>(MatrixIterator const &lhs, MatrixIterator const &rhs) {
-    auto ordered = lhs.begin_ == rhs.begin_ &&
-                   lhs.transposed_ == rhs.transposed_ &&
-                   lhs.rows_ == rhs.rows_ && lhs.cols_ == rhs.cols_;
-    if (!ordered)
-      return std::partial_ordering::unordered;
-    return lhs.i_ <=> rhs.i_;
-  }
-
-  [[nodiscard]] constexpr MatrixIndices<Y> const &rows() const noexcept {
-    return rows_;
-  }
-  [[nodiscard]] constexpr MatrixIndices<X> const &cols() const noexcept {
-    return cols_;
-  }
-  constexpr Iterator begin() const noexcept { return begin_; }
-  [[nodiscard]] constexpr std::size_t real_x() const noexcept {
-    return real_x_;
-  }
-  [[nodiscard]] constexpr std::size_t real_y() const noexcept {
-    return real_y_;
-  }
-  [[nodiscard]] constexpr bool transposed() const noexcept {
-    return transposed_;
-  }
-
-private:
-  constexpr Iterator transform(difference_type i) const noexcept {
-    return transform(begin_, i, transposed_, real_x_, real_y_, cols_, rows_);
-  }
-
-  static constexpr Iterator transform(Iterator begin, difference_type i,
-                                      bool transposed, std::size_t real_x,
-                                      std::size_t real_y,
-                                      MatrixIndices<X> const &cols,
-                                      MatrixIndices<Y> const &rows) noexcept {
-    assert(i >= 0 && i <= X * Y);
+namespace cpp_contests {
 
-    if (i == X * Y)
-      return begin + real_x * real_y;
+inline constexpr std::size_t dynamic_stride =
+    std::numeric_limits<std::size_t>::max();
 
-    auto virt_row = i / X;
-    auto virt_col = i % X;
-    auto row = rows[virt_row];
-    auto col = cols[virt_col];
+namespace details_ {
 
-    if (!transposed)
-      return begin + (col + row * real_x);
-    else
-      return begin + (row + col * real_y);
+template <std::size_t S> struct Stride {
+  constexpr Stride() noexcept = default;
+  constexpr explicit Stride([[maybe_unused]] std::size_t s) noexcept {
+    assert(s == S);
   }
+  [[nodiscard]] static constexpr std::size_t value() noexcept { return S; }
 };
-template <std::random_access_iterator Iterator, size_t X, size_t Y>
-constexpr MatrixIterator<Iterator, X, Y>
-operator+(MatrixIterator<Iterator, X, Y> const &it,
-          typename MatrixIterator<Iterator, X, Y>::difference_type n) {
-  auto tmp = it;
-  tmp += n;
-  return tmp;
-}
-template <std::random_access_iterator Iterator, size_t X, size_t Y>
-constexpr MatrixIterator<Iterator, X, Y>
-operator+(typename MatrixIterator<Iterator, X, Y>::difference_type n,
-          MatrixIterator<Iterator, X, Y> const &it) {
-  return it + n;
-}
+template <> struct Stride<dynamic_stride> {
+  std::size_t s = 0;
 
-//    Memory, X axis
-//    ───────────────►
-//  Y│
-//   │
-//  a│
-//  x│
-//  i│
-//  s│
-//   ▼
-template <std::size_t X, std::size_t Y, typename T>
-  requires(X > 0 && Y > 0)
-class Matrix final {
-public:
-  using value_type = T;
-  using Container = std::array<value_type, X * Y>;
-  using iterator = typename Container::iterator;
-  using const_iterator = typename Container::const_iterator;
-
-  static constexpr std::size_t size_x = X;
-  static constexpr std::size_t size_y = Y;
-  static constexpr std::size_t size = X * Y;
-
-private:
-  Container data_;
+  constexpr Stride() noexcept = default;
+  constexpr explicit Stride(std::size_t stride) noexcept : s(stride) {}
+  [[nodiscard]] constexpr std::size_t value() const noexcept { return s; }
+};
 
-public:
-  constexpr Matrix() noexcept { data_.fill(value_type{}); }
-  constexpr explicit Matrix(
-      std::array<std::array<value_type, X>, Y> const &m) noexcept
-      : data_(splat(m)) {}
-  constexpr explicit Matrix(std::array<value_type, X * Y> m) noexcept
-      : data_(std::move(m)) {}
-  constexpr explicit Matrix(std::initializer_list<value_type> m) noexcept {
-    std::move(m.begin(), m.end(), data_.begin());
-  }
-  constexpr explicit Matrix(
-      std::initializer_list<std::initializer_list<value_type>> m) noexcept {
-    assert(m.size() == Y);
-    std::size_t y = 0;
-    for (auto &&l : m) {
-      assert(l.size() == X);
-      std::move(l.begin(), l.end(), data_.begin() + y * X);
-      ++y;
-    }
-  }
-  template <std::input_iterator Iterator>
-  constexpr explicit Matrix(Iterator first, Iterator last) noexcept {
-    std::copy(first, last, data_.begin());
-  }
+constexpr std::size_t stride_product(std::size_t stride,
+                                     std::size_t step) noexcept {
+  return stride == dynamic_stride ? dynamic_stride : stride * step;
+}
 
-private:
-  static constexpr std::array<value_type, X * Y>
-  splat(std::array<std::array<value_type, X>, Y> const &m) noexcept {
-    std::array<value_type, X * Y> m_;
-    for (std::size_t i = 0; i < X * Y; ++i) {
-      m_[i] = m[i / X][i % X];
-    }
-    return m_;
-  }
-};
+} // namespace details_
 
-template <std::size_t X, std::size_t Y, typename T>
-  requires(X > 0 && Y > 0)
+// View of X columns and Y rows. T is const for read-only views.
+// Like std::span, a const view still gives access to mutable elements.
+template <std::size_t X, std::size_t Y, typename T, std::size_t SX = 1,
+          std::size_t SY = X>
 class MatrixView final {
-private:
-  using MI = typename Matrix<X, Y, T>::iterator;
-
 public:
-  using value_type = T;
-  using iterator = MatrixIterator<MI, X, Y>;
+  using value_type = std::remove_cv_t<T>;
+  using element_type = T;
 
 private:
-  iterator begin_;
+  T *data_;
+  [[no_unique_address]] details_::Stride<SX> sx_;
+  [[no_unique_address]] details_::Stride<SY> sy_;
 
 public:
-  constexpr MatrixView(Matrix<X, Y, value_type> &m) noexcept
-      : begin_(m.begin()) {}
+  constexpr explicit MatrixView(T *data, std::size_t stride_x = SX,
+                                std::size_t stride_y = SY) noexcept
+      : data_(data), sx_(stride_x), sy_(stride_y) {
+    assert(stride_x != dynamic_stride && stride_y != dynamic_stride);
+  }
+  constexpr MatrixView(MatrixView const &) noexcept = default;
+  constexpr MatrixView(MatrixView &&) noexcept = default;
+  // Read-only view of a mutable one
+  template <std::size_t OSX, std::size_t OSY>
+    requires std::is_const_v<T> &&
+             (SX == OSX || SX == dynamic_stride) &&
+             (SY == OSY || SY == dynamic_stride)
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr MatrixView(MatrixView<X, Y, value_type, OSX, OSY> const &other)
+      : MatrixView(other.data(), other.stride_x(), other.stride_y()) {}
+  ~MatrixView() = default;
 
-  template <std::size_t XR, std::size_t YR>
-  constexpr MatrixView<XR, YR, T>
-  operator()(MatrixIndices<XR> cols, MatrixIndices<XR> rows) const noexcept {
-    return MatrixView<XR, YR, T>(begin_, std::move(cols), std::move(rows),
-                                 false);
+  // Assignments copy elements into the viewed matrix. Source must not
+  // partially overlap with the view, e.g. be its own transpose.
+  constexpr MatrixView &operator=(MatrixView const &other) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    return assign_(other);
   }
-
-  constexpr MatrixView(MatrixView const &other) noexcept
-      : begin_(other.begin_) {}
-  constexpr MatrixView(MatrixView &&other) noexcept
-      : begin_(std::move(other.begin_)) {}
-
-  constexpr MatrixView &operator=(MatrixView const &other) noexcept {
-    std::copy(other.begin(), other.end(), begin());
+  constexpr MatrixView &operator=(MatrixView &&other) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    return assign_(other);
+  }
+  template <MatrixExpression E>
+    requires(!std::is_const_v<T> && SameShape<E, MatrixView>)
+  constexpr MatrixView &operator=(E const &e) noexcept {
+    return assign_(e);
+  }
+
+  [[nodiscard]] static constexpr std::size_t size_x() noexcept { return X; }
+  [[nodiscard]] static constexpr std::size_t size_y() noexcept { return Y; }
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return X * Y; }
+  [[nodiscard]] constexpr std::size_t stride_x() const noexcept {
+    return sx_.value();
+  }
+  [[nodiscard]] constexpr std::size_t stride_y() const noexcept {
+    return sy_.value();
+  }
+  [[nodiscard]] constexpr T *data() const noexcept { return data_; }
+
+  constexpr T &operator[](std::size_t x, std::size_t y) const noexcept {
+    assert(x < X && y < Y);
+    return data_[x * stride_x() + y * stride_y()];
+  }
+  // Elements in row-major order of the view
+  constexpr T &operator[](std::size_t i) const noexcept {
+    return operator[](i % X, i / X);
+  }
+
+  [[nodiscard]] constexpr MatrixView<Y, X, T, SY, SX>
+  transposed() const noexcept {
+    return MatrixView<Y, X, T, SY, SX>(data_, stride_y(), stride_x());
+  }
+  [[nodiscard]] constexpr MatrixView<X, 1, T, SX, SY>
+  row(std::size_t y) const noexcept {
+    return block<X, 1>(0, y);
+  }
+  [[nodiscard]] constexpr MatrixView<1, Y, T, SX, SY>
+  col(std::size_t x) const noexcept {
+    return block<1, Y>(x, 0);
+  }
+  // Contiguous SubX x SubY block starting at (x0, y0)
+  template <std::size_t SubX, std::size_t SubY>
+  [[nodiscard]] constexpr MatrixView<SubX, SubY, T, SX, SY>
+  block(std::size_t x0, std::size_t y0) const noexcept {
+    static_assert(SubX <= X && SubY <= Y);
+    assert(x0 + SubX <= X && y0 + SubY <= Y);
+    return MatrixView<SubX, SubY, T, SX, SY>(&operator[](x0, y0), stride_x(),
+                                             stride_y());
+  }
+  // Every StepX-th column and StepY-th row starting from (x0, y0)
+  template <std::size_t SubX, std::size_t SubY, std::size_t StepX,
+            std::size_t StepY>
+  [[nodiscard]] constexpr MatrixView<SubX, SubY, T,
+                                     details_::stride_product(SX, StepX),
+                                     details_::stride_product(SY, StepY)>
+  strided(std::size_t x0, std::size_t y0) const noexcept {
+    static_assert(StepX > 0 && StepY > 0);
+    assert(x0 + (SubX - 1) * StepX < X && y0 + (SubY - 1) * StepY < Y);
+    return MatrixView<SubX, SubY, T, details_::stride_product(SX, StepX),
+                      details_::stride_product(SY, StepY)>(
+        &operator[](x0, y0), stride_x() * StepX, stride_y() * StepY);
+  }
+  // The same with steps known at runtime only
+  template <std::size_t SubX, std::size_t SubY>
+  [[nodiscard]] constexpr MatrixView<SubX, SubY, T, dynamic_stride,
+                                     dynamic_stride>
+  strided(std::size_t x0, std::size_t y0, std::size_t step_x,
+          std::size_t step_y) const noexcept {
+    assert(step_x > 0 && step_y > 0);
+    assert(x0 + (SubX - 1) * step_x < X && y0 + (SubY - 1) * step_y < Y);
+    return MatrixView<SubX, SubY, T, dynamic_stride, dynamic_stride>(
+        &operator[](x0, y0), stride_x() * step_x, stride_y() * step_y);
+  }
+
+  template <MatrixExpression E>
+    requires(!std::is_const_v<T> && SameShape<E, MatrixView>)
+  constexpr MatrixView &operator+=(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) += e[i];
     return *this;
   }
-  constexpr MatrixView &operator=(MatrixView &&other) noexcept {
-    std::move(other.begin(), other.end(), begin());
+  template <MatrixExpression E>
+    requires(!std::is_const_v<T> && SameShape<E, MatrixView>)
+  constexpr MatrixView &operator-=(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) -= e[i];
     return *this;
   }
-
-  constexpr value_type &operator()(std::size_t x, std::size_t y) noexcept {
-    return begin_[x + y * X];
-  }
-  constexpr value_type operator()(std::size_t x, std::size_t y) const noexcept {
-    return begin_[x + y * X];
+  constexpr MatrixView &operator+=(value_type v) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) += v;
+    return *this;
   }
-
-  constexpr MatrixView<Y, X, T> transpose() const noexcept {
-    return MatrixView<Y, X, T>(begin_, true);
+  constexpr MatrixView &operator-=(value_type v) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    return operator+=(-v);
   }
-
-  constexpr iterator begin() const noexcept { return begin_; }
-  constexpr iterator end() const noexcept { return begin_ + X * Y; }
-
-  template <std::invocable<value_type> F>
-  MatrixView &
-  elementwise(F f) noexcept(noexcept(f(std::declval<value_type>()))) {
-    std::transform(begin(), end(), begin(), f);
+  constexpr MatrixView &operator*=(value_type v) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) *= v;
     return *this;
   }
-  template <std::invocable<value_type, value_type> F,
-            std::convertible_to<value_type> MT>
-  MatrixView &elementwise(MatrixView<X, Y, MT> const &m, F f) noexcept(
-      noexcept(f(std::declval<value_type>(), std::declval<value_type>()))) {
-    std::transform(begin(), end(), m.begin(), begin(), f);
+  constexpr MatrixView &operator/=(value_type v) noexcept
+    requires(!std::is_const_v<T>)
+  {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) /= v;
     return *this;
   }
-  template <std::convertible_to<value_type> MT>
-  MatrixView &operator+=(MatrixView<X, Y, MT> const &m) noexcept {
-    return elementwise(
-        m, [](value_type a, value_type b) noexcept { return a + b; });
-  }
-  template <std::convertible_to<value_type> MT>
-  MatrixView &operator-=(MatrixView<X, Y, MT> const &m) noexcept {
-    return elementwise(
-        m, [](value_type a, value_type b) noexcept { return a - b; });
-  }
-  MatrixView &operator+=(value_type x) noexcept {
-    return elementwise([x](value_type a) noexcept { return a + x; });
-  }
-  MatrixView &operator-=(value_type x) noexcept { return operator+=(-x); }
-  MatrixView &operator*=(value_type x) noexcept {
-    return elementwise([x](value_type a) noexcept { return a * x; });
+
+private:
+  template <typename E> constexpr MatrixView &assign_(E const &e) noexcept {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      operator[](i) = e[i];
+    return *this;
   }
-  MatrixView &operator/=(value_type x) { return operator*=(value_type{1} / x); }
+};
 
-  ~MatrixView() = default;
+namespace details_ {
 
-private:
-  template <std::size_t XR, std::size_t YR>
-  constexpr MatrixView(MatrixIterator<MI, XR, YR> const &mi,
-                       MatrixIndices<X> &&cols,
-                       MatrixIndices<Y> &&rows) noexcept
-      : begin_(mi.begin(), 0, transpose, mi.real_x(), mi.real_y(),
-               reindex(mi.cols(), std::move(cols)),
-               reindex(mi.rows(), std::move(rows))) {}
+template <std::size_t X, std::size_t Y, typename T, std::size_t SX,
+          std::size_t SY>
+constexpr bool is_stored<MatrixView<X, Y, T, SX, SY>> = true;
 
-  constexpr MatrixView(MatrixIterator<MI, Y, X> const &mi, bool) noexcept
-      : begin_(mi.begin(), 0, !mi.transposed(), mi.real_y(), mi.real_x(),
-               MatrixIndices<Y>(mi.cols()), MatrixIndices<X>(mi.rows())) {}
+} // namespace details_
 
-  template <std::size_t N, std::size_t M>
-  static constexpr MatrixIndices<N>
-  reindex(MatrixIndices<M> const &original,
-          MatrixIndices<N> const &permutation) noexcept {
-    MatrixIndices<N> indices;
-    for (std::size_t i = 0; i < N; ++i) {
-      indices[i] = original[permutation[i]];
-    }
-    return indices;
-  }
-};
+template <std::size_t X, std::size_t Y, typename T>
+constexpr MatrixView<X, Y, T> view(Matrix<X, Y, T> &m) noexcept {
+  return MatrixView<X, Y, T>(std::to_address(m.begin()));
+}
+template <std::size_t X, std::size_t Y, typename T>
+constexpr MatrixView<X, Y, T const> view(Matrix<X, Y, T> const &m) noexcept {
+  return MatrixView<X, Y, T const>(std::to_address(m.begin()));
+}
+template <std::size_t X, std::size_t Y, typename T>
+void view(Matrix<X, Y, T> &&m) = delete;
+
+template <std::size_t X, std::size_t Y, typename T>
+constexpr auto transpose_view(Matrix<X, Y, T> &m) noexcept {
+  return view(m).transposed();
+}
+template <std::size_t X, std::size_t Y, typename T>
+constexpr auto transpose_view(Matrix<X, Y, T> const &m) noexcept {
+  return view(m).transposed();
+}
+template <std::size_t X, std::size_t Y, typename T>
+void transpose_view(Matrix<X, Y, T> &&m) = delete;
 
 } // namespace cpp_contests
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+#include "utils/radix_sort.hpp"
+
+namespace cpp_contests {
+
+namespace details_ {
+
+// Interleaves the lower 21 bits of x with two zero bits after each
+constexpr std::uint64_t spread_bits(std::uint64_t x) noexcept {
+  x &= 0x1FFFFFU;
+  x = (x | (x << 32U)) & 0x1F00000000FFFFU;
+  x = (x | (x << 16U)) & 0x1F0000FF0000FFU;
+  x = (x | (x << 8U)) & 0x100F00F00F00F00FU;
+  x = (x | (x << 4U)) & 0x10C30C30C30C30C3U;
+  x = (x | (x << 2U)) & 0x1249249249249249U;
+  return x;
+}
+
+} // namespace details_
+
+// Position of the point along the Z-order curve through the box: coordinates
+// are quantized to 2^21 cells along each axis, points outside of the box are
+// clamped to it. Points close in space mostly get close codes.
+template <GeometryScalar T>
+constexpr std::uint64_t morton_code(BasicPoint<T> const &p,
+                                    BasicBox<T> const &box) noexcept {
+  constexpr auto cells = static_cast<T>((1U << 21U) - 1);
+  auto code = std::uint64_t{0};
+  for (std::size_t c = 0; c < 3; ++c) {
+    auto extent = box.max[c] - box.min[c];
+    auto cell = extent > T{0} ? (p[c] - box.min[c]) / extent * cells : T{0};
+    cell = std::clamp(cell, T{0}, cells);
+    code |= details_::spread_bits(static_cast<std::uint64_t>(cell)) << c;
+  }
+  return code;
+}
+
+namespace details_ {
+
+// Indices of points along the Z-order curve through their bounding box.
+// Ordering needs no fine grid: top 10 bits of coordinates are interleaved
+// into 30-bit codes, which are radix sorted along with 32-bit indices. Equal
+// codes keep the input order.
+template <GeometryScalar T>
+std::vector<std::uint32_t> morton_order(std::span<BasicPoint<T> const> points) {
+  assert(points.size() <= std::numeric_limits<std::uint32_t>::max());
+  if (points.empty())
+    return {};
+  auto box = BasicBox<T>{points.front(), points.front()};
+  for (auto const &p : points) {
+    for (std::size_t c = 0; c < 3; ++c) {
+      box.min[c] = std::min(box.min[c], p[c]);
+      box.max[c] = std::max(box.max[c], p[c]);
+    }
+  }
+  constexpr std::size_t dropped_bits = 3 * 11;
+  auto codes = std::vector<std::uint32_t>{};
+  codes.reserve(points.size());
+  for (auto const &p : points)
+    codes.push_back(
+        static_cast<std::uint32_t>(morton_code(p, box) >> dropped_bits));
+  return cpp_contests::radix_sort_permutation<std::uint32_t>(
+      std::span<std::uint32_t const>{codes});
+}
+
+} // namespace details_
+
+// Indices of triangles along the Z-order curve through their centroids:
+// order[k] is the input index of the k-th triangle
+template <GeometryScalar T>
+std::vector<std::uint32_t>
+morton_order(std::span<BasicTriangle<T> const> triangles) {
+  auto centroids = std::vector<BasicPoint<T>>{};
+  centroids.reserve(triangles.size());
+  for (auto const &t : triangles)
+    centroids.push_back(BasicPoint<T>{(t[0] + t[1] + t[2]) / T{3}});
+  return details_::morton_order(std::span<BasicPoint<T> const>{centroids});
+}
+// The same for centers of boxes
+template <GeometryScalar T>
+std::vector<std::uint32_t> morton_order(std::span<BasicBox<T> const> boxes) {
+  auto centers = std::vector<BasicPoint<T>>{};
+  centers.reserve(boxes.size());
+  for (auto const &b : boxes)
+    centers.push_back(BasicPoint<T>{(b.min + b.max) / T{2}});
+  return details_::morton_order(std::span<BasicPoint<T> const>{centers});
+}
+
+// Triangles reordered along the Z-order curve. Spatial neighbours are stored
+// close to each other, so broad phases, BVH builds and neighbour queries
+// over them touch fewer cache lines. Results are reported in input terms
+// through original[i], the input index of triangles[i].
+template <GeometryScalar T> struct MortonSorted {
+  std::vector<BasicTriangle<T>> triangles;
+  std::vector<std::uint32_t> original;
+
+  // Input indices of reordered ones in ascending order
+  [[nodiscard]] std::vector<std::size_t>
+  to_original(std::span<std::size_t const> indices) const {
+    auto result = std::vector<std::size_t>{};
+    result.reserve(indices.size());
+    for (auto i : indices)
+      result.push_back(original[i]);
+    std::ranges::sort(result);
+    return result;
+  }
+};
+
+template <GeometryScalar T>
+MortonSorted<T> morton_sorted(std::span<BasicTriangle<T> const> triangles) {
+  auto result = MortonSorted<T>{{}, morton_order(triangles)};
+  result.triangles.reserve(triangles.size());
+  for (auto i : result.original)
+    result.triangles.push_back(triangles[i]);
+  return result;
+}
+
+} // namespace cpp_contests
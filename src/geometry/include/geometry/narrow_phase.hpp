@@ -0,0 +1,117 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "geometry/prepared_triangle.hpp"
+#include "geometry/sweep_and_prune.hpp"
+#include "geometry/triangle.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+// Set of triangle indices packed into 64-bit words
+class Bitmap final {
+private:
+  static constexpr std::size_t word_bits = 64;
+  std::vector<std::uint64_t> words_;
+
+public:
+  Bitmap() = default;
+  explicit Bitmap(std::size_t size)
+      : words_((size + word_bits - 1) / word_bits) {}
+
+  void set(std::size_t i) noexcept {
+    assert(i / word_bits < words_.size());
+    words_[i / word_bits] |= std::uint64_t{1} << (i % word_bits);
+  }
+  [[nodiscard]] bool test(std::size_t i) const noexcept {
+    assert(i / word_bits < words_.size());
+    return ((words_[i / word_bits] >> (i % word_bits)) & 1U) != 0;
+  }
+  Bitmap &operator|=(Bitmap const &other) noexcept {
+    assert(words_.size() == other.words_.size());
+    for (std::size_t i = 0; i < words_.size(); ++i)
+      words_[i] |= other.words_[i];
+    return *this;
+  }
+
+  // Indices of set bits in ascending order
+  [[nodiscard]] std::vector<std::size_t> indices() const {
+    auto result = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      for (auto word = words_[i]; word != 0; word &= word - 1)
+        result.push_back(i * word_bits +
+                         static_cast<std::size_t>(std::countr_zero(word)));
+    }
+    return result;
+  }
+};
+
+namespace details_ {
+
+template <typename Triangles>
+std::vector<std::size_t> test_candidates(std::span<IndexPair const> candidates,
+                                         Triangles const &triangles,
+                                         ThreadPool &pool) {
+  constexpr std::size_t grain = 1024;
+  auto bitmaps = std::vector<Bitmap>(pool.size(), Bitmap(triangles.size()));
+  pool.parallel_for(
+      candidates.size(), grain,
+      [&](std::size_t begin, std::size_t end, std::size_t worker) {
+        auto &bitmap = bitmaps[worker];
+        for (auto k = begin; k < end; ++k) {
+          auto [i, j] = candidates[k];
+          if (intersects(triangles[i], triangles[j])) {
+            bitmap.set(i);
+            bitmap.set(j);
+          }
+        }
+      });
+  auto &result = bitmaps.front();
+  for (std::size_t i = 1; i < bitmaps.size(); ++i)
+    result |= bitmaps[i];
+  return result.indices();
+}
+
+// Triangles are prepared once if they take part in more than one test on
+// average, otherwise preparation costs more than it saves
+template <GeometryScalar T>
+std::vector<std::size_t>
+intersected_triangles(std::span<IndexPair const> candidates,
+                      std::span<BasicTriangle<T> const> triangles,
+                      ThreadPool &pool) {
+  if (candidates.size() <= triangles.size())
+    return test_candidates(candidates, triangles, pool);
+  auto prepared = std::vector<PreparedTriangle>{};
+  prepared.reserve(triangles.size());
+  for (auto const &t : triangles)
+    prepared.emplace_back(t);
+  return test_candidates(candidates, prepared, pool);
+}
+
+} // namespace details_
+
+// Narrow phase of HW3D: tests candidate pairs from any broad phase with exact
+// triangle test on a thread pool. Each worker marks intersected triangles in
+// its own bitmap, so no synchronization is needed until the final merge.
+// Returns indices of triangles intersecting at least one other triangle in
+// ascending order, independently of scheduling.
+inline std::vector<std::size_t>
+intersected_triangles(std::span<IndexPair const> candidates,
+                      std::span<Triangle const> triangles,
+                      ThreadPool &pool = default_thread_pool()) {
+  return details_::intersected_triangles(candidates, triangles, pool);
+}
+// Float triangles are tested exactly as well, see intersects
+inline std::vector<std::size_t>
+intersected_triangles(std::span<IndexPair const> candidates,
+                      std::span<BasicTriangle<float> const> triangles,
+                      ThreadPool &pool = default_thread_pool()) {
+  return details_::intersected_triangles(candidates, triangles, pool);
+}
+
+} // namespace cpp_contests
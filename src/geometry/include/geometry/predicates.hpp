@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "geometry/arithmetic.hpp"
+#include "geometry/primitives.hpp"
+
+// Robust geometric predicates.
+// Predicates are evaluated in floating point first. Only if the result is
+// smaller than the forward error bound of the computation, it is recomputed
+// in interval arithmetic and then exactly with floating point expansions,
+// see geometry/arithmetic.hpp.
+
+namespace cpp_contests {
+
+// Orientation of points relative to the plane of three points a, b, c.
+// Orientation of d is the sign of det[b - a, c - a, d - a], i.e. it is
+// positive if d lies on the side, where cross(b - a, c - a) points, negative
+// on the other side and zero if all four points are complanar.
+// Normal of the plane and the error bound terms are computed once, so every
+// query costs a few multiply-adds unless d is very close to the plane.
+class Orientation3d final {
+private:
+  Point a_, b_, c_;
+  Point normal_;
+  // Absolute values of cross product terms, used in the error bound
+  Point permanent_;
+
+public:
+  constexpr Orientation3d(Point const &a, Point const &b,
+                          Point const &c) noexcept
+      : a_(a), b_(b), c_(c) {
+    auto u = b - a;
+    auto v = c - a;
+    normal_ = cross(u, v);
+    for (std::size_t i = 0; i < 3; ++i) {
+      auto j = (i + 1) % 3;
+      auto k = (i + 2) % 3;
+      permanent_[i] = std::abs(u[j] * v[k]) + std::abs(u[k] * v[j]);
+    }
+  }
+
+  [[nodiscard]] constexpr Point const &a() const noexcept { return a_; }
+  [[nodiscard]] constexpr Point const &b() const noexcept { return b_; }
+  [[nodiscard]] constexpr Point const &c() const noexcept { return c_; }
+  // cross(b - a, c - a), rounded
+  [[nodiscard]] constexpr Point const &normal() const noexcept {
+    return normal_;
+  }
+
+  [[nodiscard]] constexpr int operator()(Point const &d) const noexcept {
+    auto w = d - a_;
+    auto det = dot(normal_, w);
+    auto bound = 0.0;
+    for (std::size_t i = 0; i < 3; ++i)
+      bound += std::abs(w[i]) * permanent_[i];
+    bound *= details_::det3_bound;
+    if (det > bound)
+      return 1;
+    if (-det > bound)
+      return -1;
+    using details_::coords;
+    return details_::certified_det3_sign(
+        {coords(a_), coords(a_), coords(a_)},
+        {coords(b_), coords(c_), coords(d)});
+  }
+};
+
+// Sign of det[b - a, c - a, d - a], see Orientation3d
+constexpr int orient3d(Point const &a, Point const &b, Point const &c,
+                       Point const &d) noexcept {
+  return Orientation3d(a, b, c)(d);
+}
+
+// Sign of det[b - a, c - a]: positive if a, b, c go counterclockwise,
+// negative if clockwise and zero if they are collinear
+constexpr int orient2d(Point2d const &a, Point2d const &b,
+                       Point2d const &c) noexcept {
+  auto left = (b[0] - a[0]) * (c[1] - a[1]);
+  auto right = (b[1] - a[1]) * (c[0] - a[0]);
+  auto det = left - right;
+  auto bound = details_::det2_bound * (std::abs(left) + std::abs(right));
+  if (det > bound)
+    return 1;
+  if (-det > bound)
+    return -1;
+  using details_::difference;
+  return (difference(b[0], a[0]) * difference(c[1], a[1]) -
+          difference(b[1], a[1]) * difference(c[0], a[0]))
+      .sign();
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+
+#include "geometry/complanar.hpp"
+#include "geometry/predicates.hpp"
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+
+namespace cpp_contests {
+
+// Triangle with everything, which tests against other triangles need,
+// computed once: edge vectors, the orientation predicate of its plane with
+// the normal and error bound terms, the unit plane, the dominant axis of the
+// normal and the bounding box. Tests of prepared triangles construct no lines,
+// segments or planes and take no square roots, which pays off once every
+// triangle takes part in several tests, e.g. in a BVH.
+// Coordinates are double, so float triangles are prepared exactly too.
+class PreparedTriangle final {
+private:
+  Orientation3d orientation_;
+  std::array<Point, 3> edges_;
+  Plane plane_;
+  Box box_;
+  std::size_t axis_;
+
+public:
+  constexpr explicit PreparedTriangle(Triangle const &t) noexcept
+      : orientation_(t[0], t[1], t[2]),
+        edges_{Point{t[1] - t[0]}, Point{t[2] - t[1]}, Point{t[0] - t[2]}},
+        plane_(t.plane()), box_(bounding_box(t)),
+        axis_(details_::dominant_axis(orientation_.normal())) {}
+  template <GeometryScalar T>
+    requires(!std::same_as<T, double>)
+  constexpr explicit PreparedTriangle(BasicTriangle<T> const &t) noexcept
+      : PreparedTriangle(Triangle(t)) {}
+
+  [[nodiscard]] constexpr Point const &
+  operator[](std::size_t i) const noexcept {
+    assert(i < 3);
+    return i == 0 ? orientation_.a() : i == 1 ? orientation_.b()
+                                              : orientation_.c();
+  }
+  // Vector from vertex i to vertex (i + 1) % 3
+  [[nodiscard]] constexpr Point const &edge(std::size_t i) const noexcept {
+    assert(i < 3);
+    return edges_[i];
+  }
+  // Exact orientation of points relative to the plane of the triangle
+  [[nodiscard]] constexpr Orientation3d const &orientation() const noexcept {
+    return orientation_;
+  }
+  [[nodiscard]] constexpr Plane const &plane() const noexcept {
+    return plane_;
+  }
+  [[nodiscard]] constexpr Box const &box() const noexcept { return box_; }
+  // Axis, along which projection of the triangle has the largest area
+  [[nodiscard]] constexpr std::size_t axis() const noexcept { return axis_; }
+
+  [[nodiscard]] constexpr Triangle triangle() const noexcept {
+    return Triangle{plane_, (*this)[0], (*this)[1], (*this)[2]};
+  }
+};
+
+// The same test as for triangles with the cached orientation
+constexpr bool complanar_intersects(PreparedTriangle const &t1,
+                                    PreparedTriangle const &t2) noexcept {
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (t1.orientation()(t2[i]) != 0)
+      return false;
+  }
+  return details_::complanar_overlap(t1, t2,
+                                     details_::complanar_axis(t1, t2));
+}
+
+namespace details_ {
+
+constexpr std::array<int, 3>
+orientations(PreparedTriangle const &t,
+             PreparedTriangle const &other) noexcept {
+  auto const &orientation = other.orientation();
+  return {orientation(t[0]), orientation(t[1]), orientation(t[2])};
+}
+
+// Part of the line of planes intersection inside t, as coordinates along the
+// axis, where the line runs fastest, and the points themselves.
+struct LineInterval {
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+  Point lo_point{};
+  Point hi_point{};
+
+  constexpr void add(Point const &p, std::size_t axis) noexcept {
+    if (p[axis] < lo) {
+      lo = p[axis];
+      lo_point = p;
+    }
+    if (p[axis] > hi) {
+      hi = p[axis];
+      hi_point = p;
+    }
+  }
+};
+
+// Points, where t meets the other plane: vertices on it and crossings of
+// edges, which ends lie on different sides. Sides o are exact, while signed
+// distances d only place the crossings along the edges.
+constexpr LineInterval cut(PreparedTriangle const &t,
+                           std::array<int, 3> const &o,
+                           std::array<double, 3> const &d,
+                           std::size_t axis) noexcept {
+  auto result = LineInterval{};
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto j = (i + 1) % 3;
+    if (o[i] == 0) {
+      result.add(t[i], axis);
+    } else if (o[i] * o[j] < 0) {
+      auto denom = d[i] - d[j];
+      auto r = denom == 0.0 ? 0.5 : std::clamp(d[i] / denom, 0.0, 1.0);
+      result.add(Point{t[i] + r * t.edge(i)}, axis);
+    }
+  }
+  return result;
+}
+
+} // namespace details_
+
+// The same test as for triangles with cached orientations and an early
+// bounding box rejection
+constexpr bool intersects(PreparedTriangle const &t1,
+                          PreparedTriangle const &t2) noexcept {
+  if (!overlaps(t1.box(), t2.box()))
+    return false;
+  auto o1 = details_::orientations(t1, t2);
+  if (details_::same_side(o1))
+    return false;
+  return details_::oriented_intersects(t1, t2, o1,
+                                       details_::orientations(t2, t1));
+}
+
+namespace details_ {
+
+// Whether triangles intersect and, unless they are complanar, the segment of
+// intersection
+struct PreparedIntersection {
+  bool intersects = false;
+  std::optional<Segment> segment;
+};
+
+constexpr PreparedIntersection
+prepared_intersection(PreparedTriangle const &t1,
+                      PreparedTriangle const &t2) noexcept {
+  auto none = PreparedIntersection{false, std::nullopt};
+  if (!overlaps(t1.box(), t2.box()))
+    return none;
+  auto o1 = orientations(t1, t2);
+  if (same_side(o1))
+    return none;
+  auto o2 = orientations(t2, t1);
+  if (!oriented_intersects(t1, t2, o1, o2))
+    return none;
+  if (o1 == std::array{0, 0, 0} || o2 == std::array{0, 0, 0})
+    return PreparedIntersection{true, std::nullopt};
+
+  auto const &n1 = t1.plane().normal();
+  auto const &n2 = t2.plane().normal();
+  auto dir = Point{cross(n1, n2)};
+  auto axis = std::size_t{0};
+  for (std::size_t i = 1; i < 3; ++i) {
+    if (std::abs(dir[i]) > std::abs(dir[axis]))
+      axis = i;
+  }
+  auto d1 = std::array<double, 3>{};
+  auto d2 = std::array<double, 3>{};
+  for (std::size_t i = 0; i < 3; ++i) {
+    d1[i] = dot(n2, t1[i]) - t2.plane().dist();
+    d2[i] = dot(n1, t2[i]) - t1.plane().dist();
+  }
+  auto i1 = cut(t1, o1, d1, axis);
+  auto i2 = cut(t2, o2, d2, axis);
+  auto const &s = i1.lo >= i2.lo ? i1.lo_point : i2.lo_point;
+  auto const &e = i1.hi <= i2.hi ? i1.hi_point : i2.hi_point;
+  // Touching intervals may come out reversed after rounding
+  if (std::max(i1.lo, i2.lo) > std::min(i1.hi, i2.hi))
+    return PreparedIntersection{true, Segment{s, s}};
+  return PreparedIntersection{true, Segment{s, e}};
+}
+
+} // namespace details_
+
+// Segment of intersection of non-complanar triangles. Whether it exists is
+// decided exactly, as by intersects, and only its ends are computed in
+// floating point: from signed distances to the planes along cached edges.
+// Touching triangles give a degenerate segment.
+constexpr std::optional<Segment>
+intersection(PreparedTriangle const &t1, PreparedTriangle const &t2) noexcept {
+  return details_::prepared_intersection(t1, t2).segment;
+}
+
+} // namespace cpp_contests
@@ -2,23 +2,31 @@
 
 #include <algorithm>
 #include <cassert>
+#include <concepts>
 #include <optional>
 
+#include "geometry/arithmetic.hpp"
 #include "geometry/matrix.hpp"
 
 namespace cpp_contests {
 
-using Point = Vector<3, double>;
+// Scalar types of coordinates. Both convert to double exactly, so exact
+// predicates work on stored coordinates of either.
+template <typename T>
+concept GeometryScalar = std::same_as<T, float> || std::same_as<T, double>;
 
-class Line final {
+template <GeometryScalar T> using BasicPoint = Vector<3, T>;
+
+template <GeometryScalar T> class BasicLine final {
 private:
-  Point R0_, R_;
+  BasicPoint<T> R0_, R_;
 
 public:
-  constexpr explicit Line(Point const &R0, Point const &R) noexcept
+  constexpr explicit BasicLine(BasicPoint<T> const &R0,
+                               BasicPoint<T> const &R) noexcept
       : R0_(R0), R_(R / n(R)) {}
 
-  [[nodiscard]] constexpr double param(Point const &p) const noexcept {
+  [[nodiscard]] constexpr T param(BasicPoint<T> const &p) const noexcept {
     auto diff = p - R0_;
     auto mi = std::max_element(R_.begin(), R_.end(),
                                [](auto left, auto right) {
@@ -33,72 +41,153 @@ public:
       if (std::abs(R_[i]) < EPSMIN)
         continue;
       auto ldebug = diff[i] / R_[i];
-      assert(std::abs(l - ldebug) <= EPSMAX * std::abs(l));
+      // Rounding errors of coordinates are relative to their magnitude, so
+      // params near zero are compared with the absolute tolerance
+      assert(std::abs(l - ldebug) <=
+             EPSMAX * (std::abs(l) + n(p) / std::abs(R_[i])));
     }
 #endif
     return l;
   }
-  [[nodiscard]] constexpr Point point(double param) const noexcept {
+  [[nodiscard]] constexpr BasicPoint<T> point(T param) const noexcept {
     return R0_ + param * R_;
   }
 
-  [[nodiscard]] constexpr Point const &R0() const noexcept { return R0_; }
-  [[nodiscard]] constexpr Point const &R() const noexcept { return R_; }
+  [[nodiscard]] constexpr BasicPoint<T> const &R0() const noexcept {
+    return R0_;
+  }
+  [[nodiscard]] constexpr BasicPoint<T> const &R() const noexcept {
+    return R_;
+  }
 };
 
-struct Segment {
-  Point s;
-  Point e;
+template <GeometryScalar T> struct BasicSegment {
+  BasicPoint<T> s;
+  BasicPoint<T> e;
 
-  [[nodiscard]] constexpr Line line() const noexcept { return Line{s, e - s}; }
+  [[nodiscard]] constexpr BasicLine<T> line() const noexcept {
+    return BasicLine<T>{s, e - s};
+  }
 };
 
-class Plane final {
+template <GeometryScalar T> class BasicPlane final {
 private:
-  Point normal_;
-  double d_;
+  BasicPoint<T> normal_;
+  T d_;
 
-  static constexpr auto norm_coeff_(double A, double B, double C) noexcept {
-    auto &&normal = Point{A, B, C};
+  static constexpr auto norm_coeff_(T A, T B, T C) noexcept {
+    auto &&normal = BasicPoint<T>{A, B, C};
     return n(normal);
   }
 
 public:
-  constexpr explicit Plane(Point const &normal) noexcept
+  constexpr explicit BasicPlane(BasicPoint<T> const &normal) noexcept
       : normal_(normal / n(normal)), d_(n(normal)) {
     assert(n(normal) > EPSMIN);
   }
   // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-  constexpr explicit Plane(Point const &normal, double d) noexcept
+  constexpr explicit BasicPlane(BasicPoint<T> const &normal, T d) noexcept
       : normal_(normal / n(normal)), d_(d / n(normal)) {
     assert(n(normal) > EPSMIN);
   }
-  constexpr explicit Plane(Point const &p1, Point const &p2,
-                           Point const &p3) noexcept
-      : Plane(cross(p1 - p3, p2 - p3), dot(p3, cross(p1 - p3, p2 - p3))) {}
-  constexpr explicit Plane(double A, double B, double C, double D) noexcept
-      : normal_(Point{A, B, C} / norm_coeff_(A, B, C)),
+  constexpr explicit BasicPlane(BasicPoint<T> const &p1,
+                                BasicPoint<T> const &p2,
+                                BasicPoint<T> const &p3) noexcept
+      : BasicPlane(cross(p1 - p3, p2 - p3), dot(p3, cross(p1 - p3, p2 - p3))) {
+  }
+  constexpr explicit BasicPlane(T A, T B, T C, T D) noexcept
+      : normal_(BasicPoint<T>{A, B, C} / norm_coeff_(A, B, C)),
         d_(-D / norm_coeff_(A, B, C)) {}
 
-  [[nodiscard]] constexpr Point const &normal() const noexcept {
+  [[nodiscard]] constexpr BasicPoint<T> const &normal() const noexcept {
     return normal_;
   }
-  [[nodiscard]] constexpr double dist() const noexcept { return d_; }
+  [[nodiscard]] constexpr T dist() const noexcept { return d_; }
+};
+
+// Axis-aligned bounding box, bounds are inclusive
+template <GeometryScalar T> struct BasicBox {
+  BasicPoint<T> min;
+  BasicPoint<T> max;
 };
 
-constexpr double dist(Point const &p1, Point const &p2) noexcept {
+using Point = BasicPoint<double>;
+using Line = BasicLine<double>;
+using Segment = BasicSegment<double>;
+using Plane = BasicPlane<double>;
+using Box = BasicBox<double>;
+// Projection of a Point to a coordinate plane
+using Point2d = Vector<2, double>;
+
+template <GeometryScalar T>
+constexpr T dist(BasicPoint<T> const &p1, BasicPoint<T> const &p2) noexcept {
   return n(p1 - p2);
 }
 
-constexpr bool complanar(Plane const &p1, Plane const &p2,
-                         double eps = EPSMIN) noexcept {
+template <GeometryScalar T>
+constexpr bool overlaps(BasicBox<T> const &b1, BasicBox<T> const &b2) noexcept {
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (b1.max[i] < b2.min[i] || b2.max[i] < b1.min[i])
+      return false;
+  }
+  return true;
+}
+
+namespace details_ {
+
+template <GeometryScalar T>
+constexpr Coords coords(BasicPoint<T> const &p) noexcept {
+  return {static_cast<double>(p[0]), static_cast<double>(p[1]),
+          static_cast<double>(p[2])};
+}
+
+// Whether cross(a, b) is exactly zero
+template <GeometryScalar T>
+constexpr bool collinear(BasicPoint<T> const &a,
+                         BasicPoint<T> const &b) noexcept {
+  auto u = coords(a);
+  auto v = coords(b);
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto j = (i + 1) % 3;
+    auto k = (i + 2) % 3;
+    if (det2_sign(u[j], u[k], v[j], v[k]) != 0)
+      return false;
+  }
+  return true;
+}
+
+} // namespace details_
+
+// Predicates below without eps are exact for the stored coordinates, see
+// geometry/arithmetic.hpp. Ones with eps compare with relative tolerance and
+// are meant for approximate checks like assertions.
+
+// Planes are parallel or the same
+template <GeometryScalar T>
+constexpr bool complanar(BasicPlane<T> const &p1,
+                         BasicPlane<T> const &p2) noexcept {
+  return details_::collinear(p1.normal(), p2.normal());
+}
+template <GeometryScalar T>
+constexpr bool complanar(BasicPlane<T> const &p1, BasicPlane<T> const &p2,
+                         double eps) noexcept {
   auto diff = n(cross(p1.normal(), p2.normal()));
   // diff is implicitly divided by normal length squared to get relative
   // difference Since normal is a unit vector, division is omitted
   return diff < eps;
 }
-constexpr bool complanar(Point const &p1, Point const &p2, Point const &p3,
-                         Point const &p4, double eps = EPSMIN) noexcept {
+template <GeometryScalar T>
+constexpr bool complanar(BasicPoint<T> const &p1, BasicPoint<T> const &p2,
+                         BasicPoint<T> const &p3,
+                         BasicPoint<T> const &p4) noexcept {
+  using details_::coords;
+  return details_::det3_sign({coords(p4), coords(p4), coords(p4)},
+                             {coords(p1), coords(p2), coords(p3)}) == 0;
+}
+template <GeometryScalar T>
+constexpr bool complanar(BasicPoint<T> const &p1, BasicPoint<T> const &p2,
+                         BasicPoint<T> const &p3, BasicPoint<T> const &p4,
+                         double eps) noexcept {
 
   auto v1 = p1 - p3;
   auto v2 = p2 - p3;
@@ -110,79 +199,110 @@ constexpr bool complanar(Point const &p1, Point const &p2, Point const &p3,
   if (n(cross(v3, v4)) <= eps * n(v3) * n(v4))
     return true;
 
-  auto plane1 = Plane{p1, p2, p3};
-  auto plane2 = Plane{p1, p2, p4};
+  auto plane1 = BasicPlane<T>{p1, p2, p3};
+  auto plane2 = BasicPlane<T>{p1, p2, p4};
   return complanar(plane1, plane2, eps);
 }
-constexpr bool complanar(Line const &l1, Line const &l2,
-                         double eps = EPSMIN) noexcept {
-  return complanar(l1.R0(), l1.R0() + l1.R(), l2.R0(), l2.R0() + l2.R(), eps);
+template <GeometryScalar T>
+constexpr bool complanar(BasicLine<T> const &l1,
+                         BasicLine<T> const &l2) noexcept {
+  using details_::coords;
+  constexpr auto origin = details_::Coords{};
+  return details_::det3_sign({origin, origin, coords(l1.R0())},
+                             {coords(l1.R()), coords(l2.R()),
+                              coords(l2.R0())}) == 0;
+}
+template <GeometryScalar T>
+constexpr bool complanar(BasicLine<T> const &l1, BasicLine<T> const &l2,
+                         double eps) noexcept {
+  return complanar<T>(l1.R0(), l1.R0() + l1.R(), l2.R0(), l2.R0() + l2.R(),
+                      eps);
 }
 
-constexpr bool parallel(Line const &l1, Line const &l2,
-                        double eps = EPSMIN) noexcept {
+template <GeometryScalar T>
+constexpr bool parallel(BasicLine<T> const &l1,
+                        BasicLine<T> const &l2) noexcept {
+  return details_::collinear(l1.R(), l2.R());
+}
+template <GeometryScalar T>
+constexpr bool parallel(BasicLine<T> const &l1, BasicLine<T> const &l2,
+                        double eps) noexcept {
   auto diff = n(cross(l1.R(), l2.R()));
   // diff is implicitly divided by normal length squared to get relative
   // difference Since normal is a unit vector, division is omitted
   return diff < eps;
 }
 
-constexpr std::optional<Point> complanar_intersection(Line const &p1,
-                                                      Line const &p2) noexcept {
+template <GeometryScalar T>
+constexpr std::optional<BasicPoint<T>>
+complanar_intersection(BasicLine<T> const &p1,
+                       BasicLine<T> const &p2) noexcept {
   assert(complanar(p1, p2, EPSMAX));
   if (parallel(p1, p2))
     return std::nullopt;
 
-  auto right = p2.R0() - p1.R0();
-  auto left = Matrix<2, 3, double>{p1.R(), -p2.R()};
-
-  auto first = iota<1>();
-  auto first2 = iota<2>();
-  auto rows = iota<2>();
-
-  std::size_t i = 0;
-  for (; i < 3; ++i) {
-    auto leftcut = left[first2, rows];
-    if (!invertible(leftcut)) {
-      // A case where both line projections on the plane are the same line
-      rows += 1;
-      rows %= 3;
-      continue;
-    }
-    auto rightcut = right[first, rows];
-    auto answ = inv(leftcut) * rightcut;
-    return answ[0] * p1.R() + p1.R0();
-  }
-  assert(false);
-  return Point{};
+  // Lines are solved in projection on the coordinate plane, where their
+  // directions are the most far from parallel, i.e. the one orthogonal to
+  // the largest component of the cross product
+  auto normal = cross(p1.R(), p2.R());
+  auto k = static_cast<std::size_t>(
+      std::max_element(normal.begin(), normal.end(),
+                       [](auto left, auto right) {
+                         return std::abs(left) < std::abs(right);
+                       }) -
+      normal.begin());
+  auto rows = iota<2>(k + 1);
+  rows %= 3;
+  BasicPoint<T> right = p2.R0() - p1.R0();
+  auto left = Matrix<2, 3, T>{p1.R(), -p2.R()};
+  auto leftcut = left[iota<2>(), rows];
+  auto denominator = det(leftcut);
+  if (denominator == T{0})
+    // Directions differ in the last bits, which the projection lost
+    return std::nullopt;
+  // Cramer's rule for the parameter on the first line
+  auto rightcut = leftcut;
+  for (std::size_t y = 0; y < 2; ++y)
+    rightcut[0, y] = right[rows[y]];
+  return det(rightcut) / denominator * p1.R() + p1.R0();
 }
 
-constexpr std::optional<Line> intersection(Plane const &p1,
-                                           Plane const &p2) noexcept {
+template <GeometryScalar T>
+constexpr std::optional<BasicLine<T>>
+intersection(BasicPlane<T> const &p1, BasicPlane<T> const &p2) noexcept {
   if (complanar(p1, p2))
     return std::nullopt;
 
+  auto R = cross(p1.normal(), p2.normal());
+  // Equals 1 - dot(n1, n2)^2 for unit normals, without its cancellation
+  auto sin2 = dot(R, R);
+  if (sin2 == T{0})
+    // Normals differ in the last bits, which the cross product lost
+    return std::nullopt;
   auto d1 = p1.dist();
   auto d2 = p2.dist();
   auto nn = dot(p1.normal(), p2.normal());
-  auto c1 = (d1 - d2 * nn) / (1 - nn * nn);
-  auto c2 = (d2 - d1 * nn) / (1 - nn * nn);
+  auto c1 = (d1 - d2 * nn) / sin2;
+  auto c2 = (d2 - d1 * nn) / sin2;
   auto R0 = c1 * p1.normal() + c2 * p2.normal();
-  auto R = cross(p1.normal(), p2.normal());
-  return Line{R0, R};
+  return BasicLine<T>{R0, R};
 }
 
-constexpr std::optional<Point> intersection(Plane const &p1, Plane const &p2,
-                                            Plane const &p3) noexcept {
-  if (complanar(Point{}, p1.normal(), p2.normal(), p3.normal()))
+template <GeometryScalar T>
+constexpr std::optional<BasicPoint<T>>
+intersection(BasicPlane<T> const &p1, BasicPlane<T> const &p2,
+             BasicPlane<T> const &p3) noexcept {
+  if (complanar(BasicPoint<T>{}, p1.normal(), p2.normal(), p3.normal()))
     return std::nullopt;
 
-  Matrix<3, 3, double> M{t(p1.normal()), t(p2.normal()), t(p3.normal())};
-  return inv(M) * Point{p1.dist(), p2.dist(), p3.dist()};
+  Matrix<3, 3, T> M{t(p1.normal()), t(p2.normal()), t(p3.normal())};
+  return solve(M, BasicPoint<T>{p1.dist(), p2.dist(), p3.dist()});
 }
 
-constexpr std::optional<Point> complanar_intersection(Segment const &s,
-                                                      Line const &l) noexcept {
+template <GeometryScalar T>
+constexpr std::optional<BasicPoint<T>>
+complanar_intersection(BasicSegment<T> const &s,
+                       BasicLine<T> const &l) noexcept {
   auto seg = s.line();
   assert(complanar(seg, l, EPSMAX));
   auto intersection = complanar_intersection(seg, l);
@@ -191,19 +311,23 @@ constexpr std::optional<Point> complanar_intersection(Segment const &s,
     return std::nullopt;
 
   auto param = seg.param(intersection.value());
-  if (0.0 <= param && param <= n(s.e - s.s))
+  if (T{0} <= param && param <= n(s.e - s.s))
     return intersection;
   return std::nullopt;
 }
 
-constexpr std::optional<Point>
-complanar_intersection(Line const &l, Segment const &s) noexcept {
+template <GeometryScalar T>
+constexpr std::optional<BasicPoint<T>>
+complanar_intersection(BasicLine<T> const &l,
+                       BasicSegment<T> const &s) noexcept {
   return complanar_intersection(s, l);
 }
 
-constexpr std::optional<Point>
+template <GeometryScalar T>
+constexpr std::optional<BasicPoint<T>>
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-complanar_intersection(Segment const &s1, Segment const &s2) noexcept {
+complanar_intersection(BasicSegment<T> const &s1,
+                       BasicSegment<T> const &s2) noexcept {
   auto l1 = s1.line();
   auto l2 = s2.line();
   auto i1 = complanar_intersection(s1, l2);
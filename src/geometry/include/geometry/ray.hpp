@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "geometry/primitives.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle.hpp"
+#include "geometry/triangle_batch.hpp"
+
+namespace cpp_contests {
+
+// Ray origin + t * direction, which hits count for tmin <= t <= tmax only.
+// The direction need not be normalized, t is measured in its lengths, so a
+// segment from p to q is the ray {p, q - p, 0, 1}.
+template <GeometryScalar T> struct BasicRay {
+  BasicPoint<T> origin;
+  BasicPoint<T> direction;
+  T tmin = T{0};
+  T tmax = std::numeric_limits<T>::infinity();
+
+  [[nodiscard]] constexpr BasicPoint<T> point(T t) const noexcept {
+    return origin + t * direction;
+  }
+};
+
+// Hit at the ray param t and point (1 - u - v) * t[0] + u * t[1] + v * t[2]
+// of the triangle
+template <GeometryScalar T> struct BasicRayHit {
+  T t;
+  T u;
+  T v;
+  // Index of the hit triangle, when the ray is cast against several ones
+  std::size_t triangle = 0;
+};
+
+using Ray = BasicRay<double>;
+using RayHit = BasicRayHit<double>;
+
+// Moller-Trumbore ray-triangle test. Barycentric coordinates and the param are
+// compared before the division by the determinant, so rays missing the
+// triangle take no division. Rays in the plane of the triangle miss it.
+// Unlike triangle tests, this one is not exact: a ray through a shared edge
+// may hit both triangles or, rarely, neither.
+template <GeometryScalar T>
+constexpr std::optional<BasicRayHit<T>>
+intersection(BasicRay<T> const &ray, BasicTriangle<T> const &t) noexcept {
+  auto e1 = t[1] - t[0];
+  auto e2 = t[2] - t[0];
+  auto p = cross(ray.direction, e2);
+  auto det = dot(e1, p);
+  if (det == T{0})
+    return std::nullopt;
+  auto sign = det < T{0} ? T{-1} : T{1};
+  auto s = ray.origin - t[0];
+  auto u = sign * dot(s, p);
+  auto q = cross(s, e1);
+  auto v = sign * dot(ray.direction, q);
+  auto param = sign * dot(e2, q);
+  auto adet = sign * det;
+  if (u < T{0} || v < T{0} || u + v > adet || param < ray.tmin * adet ||
+      param > ray.tmax * adet)
+    return std::nullopt;
+  return BasicRayHit<T>{param / adet, u / adet, v / adet};
+}
+
+namespace details_ {
+
+// Moller-Trumbore test of the ray against W triangles, all lanes at once.
+// Coordinate c of vertex v of the triangles is loaded from coords[3 * v + c],
+// only the first count lanes are valid. Params of missed lanes are infinite.
+template <typename T, std::size_t W> struct PackRayHits {
+  simd::Pack<T, W> t;
+  simd::Pack<T, W> u;
+  simd::Pack<T, W> v;
+  std::uint64_t bits = 0;
+};
+
+template <typename T, std::size_t W>
+PackRayHits<T, W> ray_hits(BasicRay<T> const &ray,
+                           std::array<T const *, 9> const &coords,
+                           std::size_t count, T tmax) noexcept {
+  using P = simd::Pack<T, W>;
+  using PP = PackPoint<P>;
+  auto load = [&](std::size_t v) {
+    return PP{P::load(coords[3 * v]), P::load(coords[3 * v + 1]),
+              P::load(coords[3 * v + 2])};
+  };
+  auto broadcast = [](BasicPoint<T> const &p) {
+    return PP{P{p[0]}, P{p[1]}, P{p[2]}};
+  };
+  auto zero = P{0};
+  auto v0 = load(0);
+  auto e1 = load(1) - v0;
+  auto e2 = load(2) - v0;
+  auto d = broadcast(ray.direction);
+  auto p = cross(d, e2);
+  auto det = dot(e1, p);
+  auto negative = det < zero;
+  auto flip = [&](P const &x) { return select(negative, -x, x); };
+  auto s = broadcast(ray.origin) - v0;
+  auto u = flip(dot(s, p));
+  auto q = cross(s, e1);
+  auto v = flip(dot(d, q));
+  auto t = flip(dot(e2, q));
+  auto adet = abs(det);
+  auto hit = (adet > zero) & (u >= zero) & (v >= zero) & (u + v <= adet) &
+             (t >= P{ray.tmin} * adet) & (t <= P{tmax} * adet) &
+             simd::first_lanes<T, W>(count);
+  auto inv = P{T{1}} / select(hit, adet, P{T{1}});
+  auto inf = P{std::numeric_limits<T>::infinity()};
+  return {select(hit, t * inv, inf), u * inv, v * inv, hit.bits()};
+}
+
+} // namespace details_
+
+// Tests the ray against W triangles of the batch starting from first.
+// Bit i of the result is set if the ray hits triangle first + i. Decisions
+// are made as by the single triangle test, but may differ from it in rare
+// borderline cases, as the vector code rounds cross products differently.
+template <typename T, std::size_t W = simd::native_width<T>>
+  requires GeometryScalar<T>
+std::uint64_t intersects(BasicRay<T> const &ray,
+                         TriangleBatch<T> const &batch,
+                         std::size_t first) noexcept {
+  static_assert(TriangleBatch<T>::padding % W == 0);
+  assert(first < batch.size() && first % W == 0);
+  auto coords = std::array<T const *, 9>{};
+  for (std::size_t k = 0; k < 9; ++k)
+    coords[k] = batch.coord(k / 3, k % 3) + first;
+  return details_::ray_hits<T, W>(ray, coords, batch.size() - first, ray.tmax)
+      .bits;
+}
+
+} // namespace cpp_contests
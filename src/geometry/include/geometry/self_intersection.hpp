@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "geometry/prepared_triangle.hpp"
+#include "geometry/primitives.hpp"
+#include "geometry/sweep_and_prune.hpp"
+#include "geometry/triangle.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+// Vertex indices of mesh triangles. Triangle soups are welded: vertices with
+// exactly equal coordinates get the same index.
+class MeshAdjacency final {
+public:
+  using Face = std::array<std::uint32_t, 3>;
+
+private:
+  std::vector<Face> faces_;
+
+public:
+  MeshAdjacency() = default;
+  explicit MeshAdjacency(std::vector<Face> faces) : faces_(std::move(faces)) {}
+  template <GeometryScalar T>
+  explicit MeshAdjacency(std::span<BasicTriangle<T> const> triangles)
+      : faces_(triangles.size()) {
+    assert(3 * triangles.size() <= std::numeric_limits<std::uint32_t>::max());
+    auto corner = [&](std::uint32_t k) -> BasicPoint<T> const & {
+      return triangles[k / 3][k % 3];
+    };
+    auto order = std::vector<std::uint32_t>(3 * triangles.size());
+    std::iota(order.begin(), order.end(), std::uint32_t{0});
+    auto coords = [&](std::uint32_t k) {
+      auto const &p = corner(k);
+      return std::tuple{p[0], p[1], p[2]};
+    };
+    std::sort(order.begin(), order.end(),
+              [&](auto i, auto j) { return coords(i) < coords(j); });
+    auto vertex = std::uint32_t{0};
+    for (std::size_t k = 0; k < order.size(); ++k) {
+      if (k != 0 && coords(order[k]) != coords(order[k - 1]))
+        ++vertex;
+      faces_[order[k] / 3][order[k] % 3] = vertex;
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return faces_.size(); }
+  [[nodiscard]] Face const &operator[](std::size_t i) const noexcept {
+    assert(i < faces_.size());
+    return faces_[i];
+  }
+  // Whether triangles share a vertex, and maybe an edge
+  [[nodiscard]] bool adjacent(std::size_t i, std::size_t j) const noexcept {
+    auto const &a = (*this)[i];
+    auto const &b = (*this)[j];
+    return std::ranges::any_of(a, [&](std::uint32_t v) {
+      return std::ranges::find(b, v) != b.end();
+    });
+  }
+};
+
+// Intersecting pair of mesh triangles, first < second
+struct SelfIntersection {
+  std::size_t first;
+  std::size_t second;
+  // Absent for complanar triangles, which share an area rather than a
+  // segment
+  std::optional<Segment> segment;
+};
+
+namespace details_ {
+
+// Candidate pairs are tested in blocks of this size: large enough to keep
+// the pool busy and small enough to bound memory by it
+constexpr std::size_t self_intersection_block = 1 << 16;
+
+template <GeometryScalar T, typename Sink>
+void self_intersections(std::span<BasicTriangle<T> const> triangles,
+                        MeshAdjacency const &adjacency, Sink &sink,
+                        ThreadPool &pool) {
+  assert(adjacency.size() == triangles.size());
+  auto boxes = std::vector<BasicBox<T>>{};
+  boxes.reserve(triangles.size());
+  for (auto const &t : triangles)
+    boxes.push_back(bounding_box(t));
+  // Every pair, which intersects, also needs its segment, so triangles are
+  // prepared once for both
+  auto prepared = std::vector<PreparedTriangle>{};
+  prepared.reserve(triangles.size());
+  for (auto const &t : triangles)
+    prepared.emplace_back(t);
+
+  auto block = std::vector<IndexPair>{};
+  block.reserve(self_intersection_block);
+  auto found = std::vector<std::optional<SelfIntersection>>{};
+  auto flush = [&] {
+    found.assign(block.size(), std::nullopt);
+    constexpr std::size_t grain = 1024;
+    pool.parallel_for(
+        block.size(), grain,
+        [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+          for (auto k = begin; k < end; ++k) {
+            auto [i, j] = block[k];
+            auto [hit, segment] =
+                prepared_intersection(prepared[i], prepared[j]);
+            if (hit)
+              found[k] = SelfIntersection{i, j, segment};
+          }
+        });
+    // Results go out in the order of the sweep, independently of scheduling
+    for (auto const &result : found) {
+      if (result)
+        sink(*result);
+    }
+    block.clear();
+  };
+
+  sweep(std::span<BasicBox<T> const>{boxes},
+        [&](std::size_t i, std::size_t j) {
+          if (adjacency.adjacent(i, j))
+            return;
+          block.emplace_back(i, j);
+          if (block.size() == self_intersection_block)
+            flush();
+        });
+  flush();
+}
+
+} // namespace details_
+
+// Self-intersections of a mesh. Calls sink for every pair of intersecting
+// triangles, which are not adjacent, i.e. share no vertex. Candidates come
+// from the sweep over bounding boxes and are tested in fixed-size blocks on
+// the pool, so neither candidates nor results are ever stored all at once.
+// The sink is called from the calling thread only.
+template <std::invocable<SelfIntersection const &> Sink>
+void self_intersections(std::span<Triangle const> triangles,
+                        MeshAdjacency const &adjacency, Sink &&sink,
+                        ThreadPool &pool = default_thread_pool()) {
+  details_::self_intersections(triangles, adjacency, sink, pool);
+}
+// Float triangles are tested exactly as well, see intersects
+template <std::invocable<SelfIntersection const &> Sink>
+void self_intersections(std::span<BasicTriangle<float> const> triangles,
+                        MeshAdjacency const &adjacency, Sink &&sink,
+                        ThreadPool &pool = default_thread_pool()) {
+  details_::self_intersections(triangles, adjacency, sink, pool);
+}
+
+} // namespace cpp_contests
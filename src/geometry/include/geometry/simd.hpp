@@ -0,0 +1,382 @@
+#pragma once
+
+// Thin wrappers over SIMD registers.
+// Algorithms are written once in terms of Pack<T, W> and Mask<T, W>, while
+// the widest instruction set enabled for the translation unit is picked at
+// compile time. Without AVX2 or AVX-512 portable array-based packs are used,
+// which compiler is still free to vectorize with whatever it has.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace cpp_contests::simd {
+
+#if defined(__AVX512F__)
+constexpr std::size_t register_bytes = 64;
+#else
+constexpr std::size_t register_bytes = 32;
+#endif
+
+// Number of lanes used by default for the given scalar type
+template <typename T>
+constexpr std::size_t native_width = register_bytes / sizeof(T);
+
+// Whether Pack<T, W> is backed by a SIMD register rather than by an array
+template <typename T, std::size_t W> constexpr bool is_native = false;
+
+template <typename T, std::size_t W> class Mask final {
+private:
+  std::array<bool, W> m_{};
+
+public:
+  constexpr Mask() noexcept = default;
+  constexpr explicit Mask(bool b) noexcept { m_.fill(b); }
+
+  constexpr bool operator[](std::size_t i) const noexcept { return m_[i]; }
+  constexpr bool &operator[](std::size_t i) noexcept { return m_[i]; }
+
+  friend constexpr Mask operator&(Mask a, Mask const &b) noexcept {
+    for (std::size_t i = 0; i < W; ++i)
+      a.m_[i] = a.m_[i] && b.m_[i];
+    return a;
+  }
+  friend constexpr Mask operator|(Mask a, Mask const &b) noexcept {
+    for (std::size_t i = 0; i < W; ++i)
+      a.m_[i] = a.m_[i] || b.m_[i];
+    return a;
+  }
+  friend constexpr Mask operator~(Mask a) noexcept {
+    for (std::size_t i = 0; i < W; ++i)
+      a.m_[i] = !a.m_[i];
+    return a;
+  }
+  // Bit i of the result is lane i
+  [[nodiscard]] constexpr std::uint64_t bits() const noexcept {
+    auto result = std::uint64_t{0};
+    for (std::size_t i = 0; i < W; ++i)
+      result |= std::uint64_t{m_[i]} << i;
+    return result;
+  }
+};
+
+template <typename T, std::size_t W> class Pack final {
+public:
+  using value_type = T;
+  using mask_type = Mask<T, W>;
+  static constexpr std::size_t width = W;
+
+private:
+  std::array<T, W> v_{};
+
+  template <typename F>
+  friend constexpr Pack apply_(Pack a, Pack const &b, F f) noexcept {
+    for (std::size_t i = 0; i < W; ++i)
+      a.v_[i] = f(a.v_[i], b.v_[i]);
+    return a;
+  }
+  template <typename F>
+  friend constexpr mask_type compare_(Pack const &a, Pack const &b,
+                                      F f) noexcept {
+    auto m = mask_type{};
+    for (std::size_t i = 0; i < W; ++i)
+      m[i] = f(a.v_[i], b.v_[i]);
+    return m;
+  }
+
+public:
+  constexpr Pack() noexcept = default;
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr Pack(T x) noexcept { v_.fill(x); }
+
+  static constexpr Pack load(T const *p) noexcept {
+    auto pack = Pack{};
+    std::copy(p, p + W, pack.v_.begin());
+    return pack;
+  }
+  constexpr void store(T *p) const noexcept {
+    std::copy(v_.begin(), v_.end(), p);
+  }
+  constexpr T operator[](std::size_t i) const noexcept { return v_[i]; }
+
+  friend constexpr Pack operator+(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return x + y; });
+  }
+  friend constexpr Pack operator-(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return x - y; });
+  }
+  friend constexpr Pack operator*(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return x * y; });
+  }
+  friend constexpr Pack operator/(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return x / y; });
+  }
+  friend constexpr Pack operator-(Pack const &a) noexcept {
+    return Pack{T{0}} - a;
+  }
+  friend constexpr Pack min(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return std::min(x, y); });
+  }
+  friend constexpr Pack max(Pack const &a, Pack const &b) noexcept {
+    return apply_(a, b, [](T x, T y) { return std::max(x, y); });
+  }
+  friend constexpr Pack abs(Pack const &a) noexcept {
+    return max(a, -a);
+  }
+  friend constexpr Pack fma(Pack const &a, Pack const &b,
+                            Pack const &c) noexcept {
+    return a * b + c;
+  }
+  friend constexpr mask_type operator<(Pack const &a, Pack const &b) noexcept {
+    return compare_(a, b, [](T x, T y) { return x < y; });
+  }
+  friend constexpr mask_type operator<=(Pack const &a,
+                                        Pack const &b) noexcept {
+    return compare_(a, b, [](T x, T y) { return x <= y; });
+  }
+  friend constexpr mask_type operator>(Pack const &a, Pack const &b) noexcept {
+    return b < a;
+  }
+  friend constexpr mask_type operator>=(Pack const &a,
+                                        Pack const &b) noexcept {
+    return b <= a;
+  }
+  friend constexpr Pack select(mask_type const &m, Pack const &a,
+                               Pack const &b) noexcept {
+    auto pack = Pack{};
+    for (std::size_t i = 0; i < W; ++i)
+      pack.v_[i] = m[i] ? a.v_[i] : b.v_[i];
+    return pack;
+  }
+};
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+
+// Generates specializations for a register type.
+// Only the set of intrinsics differs between them.
+// clang-format off
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define CPP_CONTESTS_SIMD_AVX_PACK(T, W, REG, SFX)                             \
+  template <> class Mask<T, W> final {                                         \
+  private:                                                                     \
+    REG m_;                                                                    \
+                                                                               \
+  public:                                                                      \
+    Mask() noexcept : m_(_mm256_setzero_##SFX()) {}                            \
+    explicit Mask(REG m) noexcept : m_(m) {}                                   \
+    explicit Mask(bool b) noexcept                                             \
+        : m_(b ? _mm256_castsi256_##SFX(_mm256_set1_epi32(-1))                 \
+               : _mm256_setzero_##SFX()) {}                                    \
+    [[nodiscard]] REG reg() const noexcept { return m_; }                      \
+    friend Mask operator&(Mask a, Mask b) noexcept {                           \
+      return Mask{_mm256_and_##SFX(a.m_, b.m_)};                               \
+    }                                                                          \
+    friend Mask operator|(Mask a, Mask b) noexcept {                           \
+      return Mask{_mm256_or_##SFX(a.m_, b.m_)};                                \
+    }                                                                          \
+    friend Mask operator~(Mask a) noexcept {                                   \
+      return Mask{_mm256_xor_##SFX(                                            \
+          a.m_, _mm256_castsi256_##SFX(_mm256_set1_epi32(-1)))};               \
+    }                                                                          \
+    [[nodiscard]] std::uint64_t bits() const noexcept {                        \
+      return static_cast<std::uint64_t>(                                       \
+          static_cast<unsigned>(_mm256_movemask_##SFX(m_)));                   \
+    }                                                                          \
+    bool operator[](std::size_t i) const noexcept {                            \
+      return ((bits() >> i) & 1U) != 0;                                        \
+    }                                                                          \
+  };                                                                           \
+                                                                               \
+  template <> class Pack<T, W> final {                                         \
+  public:                                                                      \
+    using value_type = T;                                                      \
+    using mask_type = Mask<T, W>;                                              \
+    static constexpr std::size_t width = W;                                    \
+                                                                               \
+  private:                                                                     \
+    REG v_;                                                                    \
+                                                                               \
+  public:                                                                      \
+    Pack() noexcept : v_(_mm256_setzero_##SFX()) {}                            \
+    explicit Pack(REG v) noexcept : v_(v) {}                                   \
+    Pack(T x) noexcept : v_(_mm256_set1_##SFX(x)) {}                           \
+    static Pack load(T const *p) noexcept {                                    \
+      return Pack{_mm256_loadu_##SFX(p)};                                      \
+    }                                                                          \
+    void store(T *p) const noexcept { _mm256_storeu_##SFX(p, v_); }            \
+    T operator[](std::size_t i) const noexcept {                               \
+      alignas(32) std::array<T, W> a;                                          \
+      _mm256_store_##SFX(a.data(), v_);                                        \
+      return a[i];                                                             \
+    }                                                                          \
+    [[nodiscard]] REG reg() const noexcept { return v_; }                      \
+                                                                               \
+    friend Pack operator+(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm256_add_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator-(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm256_sub_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator*(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm256_mul_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator/(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm256_div_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator-(Pack a) noexcept {                                   \
+      return Pack{_mm256_xor_##SFX(a.v_, _mm256_set1_##SFX(T{-0.0}))};         \
+    }                                                                          \
+    friend Pack min(Pack a, Pack b) noexcept {                                 \
+      return Pack{_mm256_min_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack max(Pack a, Pack b) noexcept {                                 \
+      return Pack{_mm256_max_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack abs(Pack a) noexcept {                                         \
+      return Pack{_mm256_andnot_##SFX(_mm256_set1_##SFX(T{-0.0}), a.v_)};      \
+    }                                                                          \
+    friend Pack fma(Pack a, Pack b, Pack c) noexcept { return a * b + c; }     \
+    friend mask_type operator<(Pack a, Pack b) noexcept {                      \
+      return mask_type{_mm256_cmp_##SFX(a.v_, b.v_, _CMP_LT_OQ)};              \
+    }                                                                          \
+    friend mask_type operator<=(Pack a, Pack b) noexcept {                     \
+      return mask_type{_mm256_cmp_##SFX(a.v_, b.v_, _CMP_LE_OQ)};              \
+    }                                                                          \
+    friend mask_type operator>(Pack a, Pack b) noexcept { return b < a; }      \
+    friend mask_type operator>=(Pack a, Pack b) noexcept { return b <= a; }    \
+    friend Pack select(mask_type m, Pack a, Pack b) noexcept {                 \
+      return Pack{_mm256_blendv_##SFX(b.v_, a.v_, m.reg())};                   \
+    }                                                                          \
+  };
+
+#define CPP_CONTESTS_SIMD_AVX512_PACK(T, W, REG, SFX, MASK)                    \
+  template <> class Mask<T, W> final {                                         \
+  private:                                                                     \
+    MASK m_ = 0;                                                               \
+                                                                               \
+  public:                                                                      \
+    Mask() noexcept = default;                                                 \
+    explicit Mask(MASK m) noexcept : m_(m) {}                                  \
+    explicit Mask(bool b) noexcept : m_(b ? static_cast<MASK>(~MASK{0}) : 0) {} \
+    [[nodiscard]] MASK reg() const noexcept { return m_; }                     \
+    friend Mask operator&(Mask a, Mask b) noexcept {                           \
+      return Mask{static_cast<MASK>(a.m_ & b.m_)};                             \
+    }                                                                          \
+    friend Mask operator|(Mask a, Mask b) noexcept {                           \
+      return Mask{static_cast<MASK>(a.m_ | b.m_)};                             \
+    }                                                                          \
+    friend Mask operator~(Mask a) noexcept {                                   \
+      return Mask{static_cast<MASK>(~a.m_)};                                   \
+    }                                                                          \
+    [[nodiscard]] std::uint64_t bits() const noexcept { return m_; }           \
+    bool operator[](std::size_t i) const noexcept {                            \
+      return ((m_ >> i) & 1U) != 0;                                            \
+    }                                                                          \
+  };                                                                           \
+                                                                               \
+  template <> class Pack<T, W> final {                                         \
+  public:                                                                      \
+    using value_type = T;                                                      \
+    using mask_type = Mask<T, W>;                                              \
+    static constexpr std::size_t width = W;                                    \
+                                                                               \
+  private:                                                                     \
+    REG v_;                                                                    \
+                                                                               \
+  public:                                                                      \
+    Pack() noexcept : v_(_mm512_setzero_##SFX()) {}                            \
+    explicit Pack(REG v) noexcept : v_(v) {}                                   \
+    Pack(T x) noexcept : v_(_mm512_set1_##SFX(x)) {}                           \
+    static Pack load(T const *p) noexcept {                                    \
+      return Pack{_mm512_loadu_##SFX(p)};                                      \
+    }                                                                          \
+    void store(T *p) const noexcept { _mm512_storeu_##SFX(p, v_); }            \
+    T operator[](std::size_t i) const noexcept {                               \
+      alignas(64) std::array<T, W> a;                                          \
+      _mm512_store_##SFX(a.data(), v_);                                        \
+      return a[i];                                                             \
+    }                                                                          \
+    [[nodiscard]] REG reg() const noexcept { return v_; }                      \
+                                                                               \
+    friend Pack operator+(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm512_add_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator-(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm512_sub_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator*(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm512_mul_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator/(Pack a, Pack b) noexcept {                           \
+      return Pack{_mm512_div_##SFX(a.v_, b.v_)};                               \
+    }                                                                          \
+    friend Pack operator-(Pack a) noexcept { return Pack{T{0}} - a; }          \
+    friend Pack min(Pack a, Pack b) noexcept {                                 \
+      /* Unmasked form trips -Wmaybe-uninitialized in GCC headers */          \
+      return Pack{_mm512_maskz_min_##SFX(static_cast<MASK>(~0U), a.v_, b.v_)}; \
+    }                                                                          \
+    friend Pack max(Pack a, Pack b) noexcept {                                 \
+      /* Unmasked form trips -Wmaybe-uninitialized in GCC headers */          \
+      return Pack{_mm512_maskz_max_##SFX(static_cast<MASK>(~0U), a.v_, b.v_)}; \
+    }                                                                          \
+    friend Pack abs(Pack a) noexcept { return Pack{_mm512_abs_##SFX(a.v_)}; }  \
+    friend Pack fma(Pack a, Pack b, Pack c) noexcept {                         \
+      return Pack{_mm512_fmadd_##SFX(a.v_, b.v_, c.v_)};                       \
+    }                                                                          \
+    friend mask_type operator<(Pack a, Pack b) noexcept {                      \
+      return mask_type{_mm512_cmp_##SFX##_mask(a.v_, b.v_, _CMP_LT_OQ)};       \
+    }                                                                          \
+    friend mask_type operator<=(Pack a, Pack b) noexcept {                     \
+      return mask_type{_mm512_cmp_##SFX##_mask(a.v_, b.v_, _CMP_LE_OQ)};       \
+    }                                                                          \
+    friend mask_type operator>(Pack a, Pack b) noexcept { return b < a; }      \
+    friend mask_type operator>=(Pack a, Pack b) noexcept { return b <= a; }    \
+    friend Pack select(mask_type m, Pack a, Pack b) noexcept {                 \
+      return Pack{_mm512_mask_blend_##SFX(m.reg(), b.v_, a.v_)};               \
+    }                                                                          \
+  };
+// clang-format on
+
+CPP_CONTESTS_SIMD_AVX_PACK(double, 4, __m256d, pd)
+CPP_CONTESTS_SIMD_AVX_PACK(float, 8, __m256, ps)
+template <> constexpr bool is_native<double, 4> = true;
+template <> constexpr bool is_native<float, 8> = true;
+#if defined(__AVX512F__)
+CPP_CONTESTS_SIMD_AVX512_PACK(double, 8, __m512d, pd, __mmask8)
+CPP_CONTESTS_SIMD_AVX512_PACK(float, 16, __m512, ps, __mmask16)
+template <> constexpr bool is_native<double, 8> = true;
+template <> constexpr bool is_native<float, 16> = true;
+#endif
+
+#undef CPP_CONTESTS_SIMD_AVX_PACK
+#undef CPP_CONTESTS_SIMD_AVX512_PACK
+// NOLINTEND(cppcoreguidelines-macro-usage)
+
+#endif
+
+template <typename T, std::size_t W> bool any(Mask<T, W> const &m) noexcept {
+  return m.bits() != 0;
+}
+template <typename T, std::size_t W> bool all(Mask<T, W> const &m) noexcept {
+  static_assert(W < 64);
+  return m.bits() == (std::uint64_t{1} << W) - 1;
+}
+template <typename T, std::size_t W> bool none(Mask<T, W> const &m) noexcept {
+  return !any(m);
+}
+
+// Mask with first n lanes set
+template <typename T, std::size_t W>
+Mask<T, W> first_lanes(std::size_t n) noexcept {
+  auto indices = std::array<T, W>{};
+  for (std::size_t i = 0; i < W; ++i)
+    indices[i] = static_cast<T>(i);
+  return Pack<T, W>::load(indices.data()) < Pack<T, W>{static_cast<T>(n)};
+}
+
+} // namespace cpp_contests::simd
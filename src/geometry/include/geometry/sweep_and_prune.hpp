@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+
+namespace cpp_contests {
+
+// Pair of box indices, first < second
+using IndexPair = std::pair<std::size_t, std::size_t>;
+
+namespace details_ {
+
+template <GeometryScalar T, typename F>
+void sweep(std::span<BasicBox<T> const> boxes, F &f) {
+  auto order = std::vector<std::size_t>(boxes.size());
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::sort(order.begin(), order.end(), [&](std::size_t i, std::size_t j) {
+    return boxes[i].min[0] < boxes[j].min[0];
+  });
+
+  // Active boxes, which X interval may still overlap with the next ones
+  auto active = std::vector<std::size_t>{};
+  for (auto i : order) {
+    auto const &box = boxes[i];
+    std::erase_if(active, [&](std::size_t j) {
+      return boxes[j].max[0] < box.min[0];
+    });
+    for (auto j : active) {
+      if (overlaps(box, boxes[j]))
+        f(std::min(i, j), std::max(i, j));
+    }
+    active.push_back(i);
+  }
+}
+
+} // namespace details_
+
+// One-shot sort and sweep over the X axis.
+// Calls f(i, j) with i < j for every pair of overlapping boxes without storing
+// the pairs, so it can feed arbitrary large outputs.
+template <std::invocable<std::size_t, std::size_t> F>
+void sweep(std::span<Box const> boxes, F &&f) {
+  details_::sweep(boxes, f);
+}
+template <std::invocable<std::size_t, std::size_t> F>
+void sweep(std::span<BasicBox<float> const> boxes, F &&f) {
+  details_::sweep(boxes, f);
+}
+
+// Incremental sweep and prune broad phase.
+// Keeps box endpoints sorted along each axis. When boxes move a little between
+// frames, insertion sort restores the order in nearly linear time and every
+// swap of endpoints is exactly one event of a pair starting or stopping to
+// overlap along that axis. Thus only changed pairs are touched.
+class SweepAndPrune final {
+public:
+  struct Changes {
+    std::vector<IndexPair> added;
+    std::vector<IndexPair> removed;
+  };
+
+private:
+  struct Endpoint {
+    double value;
+    std::uint32_t box;
+    bool is_max;
+  };
+
+  std::vector<Box> boxes_;
+  std::array<std::vector<Endpoint>, 3> axes_;
+  std::unordered_set<std::uint64_t> pairs_;
+  // Pairs, touched during current update, and whether they were present
+  // before it
+  std::unordered_map<std::uint64_t, bool> journal_;
+
+public:
+  SweepAndPrune() = default;
+  explicit SweepAndPrune(std::vector<Box> boxes) : boxes_(std::move(boxes)) {
+    assert(boxes_.size() <= std::numeric_limits<std::uint32_t>::max());
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      auto &endpoints = axes_[axis];
+      endpoints.reserve(2 * boxes_.size());
+      for (std::size_t i = 0; i < boxes_.size(); ++i) {
+        auto box = static_cast<std::uint32_t>(i);
+        endpoints.push_back(Endpoint{boxes_[i].min[axis], box, false});
+        endpoints.push_back(Endpoint{boxes_[i].max[axis], box, true});
+      }
+      std::sort(endpoints.begin(), endpoints.end(), less_);
+    }
+    sweep(boxes_, [&](std::size_t i, std::size_t j) {
+      pairs_.insert(key_(i, j));
+    });
+  }
+  explicit SweepAndPrune(std::span<Triangle const> triangles)
+      : SweepAndPrune(boxes_of_(triangles)) {}
+
+  // Moves boxes to new positions. Number of boxes must stay the same.
+  Changes update(std::span<Box const> boxes) {
+    assert(boxes.size() == boxes_.size());
+    std::copy(boxes.begin(), boxes.end(), boxes_.begin());
+    journal_.clear();
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      auto &endpoints = axes_[axis];
+      for (auto &endpoint : endpoints) {
+        auto const &box = boxes_[endpoint.box];
+        endpoint.value = endpoint.is_max ? box.max[axis] : box.min[axis];
+      }
+      insertion_sort_(endpoints);
+    }
+
+    auto changes = Changes{};
+    for (auto const &[key, was_present] : journal_) {
+      if (pairs_.contains(key) == was_present)
+        continue;
+      auto &to = was_present ? changes.removed : changes.added;
+      to.push_back(pair_(key));
+    }
+    std::sort(changes.added.begin(), changes.added.end());
+    std::sort(changes.removed.begin(), changes.removed.end());
+    return changes;
+  }
+  Changes update(std::span<Triangle const> triangles) {
+    return update(boxes_of_(triangles));
+  }
+
+  // Currently overlapping pairs in ascending order
+  [[nodiscard]] std::vector<IndexPair> pairs() const {
+    auto result = std::vector<IndexPair>{};
+    result.reserve(pairs_.size());
+    for (auto key : pairs_)
+      result.push_back(pair_(key));
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+  [[nodiscard]] bool overlapping(std::size_t i, std::size_t j) const {
+    return i != j && pairs_.contains(key_(std::min(i, j), std::max(i, j)));
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return boxes_.size(); }
+  [[nodiscard]] std::span<Box const> boxes() const noexcept { return boxes_; }
+
+private:
+  static std::vector<Box> boxes_of_(std::span<Triangle const> triangles) {
+    auto boxes = std::vector<Box>{};
+    boxes.reserve(triangles.size());
+    for (auto const &t : triangles)
+      boxes.push_back(bounding_box(t));
+    return boxes;
+  }
+
+  static bool less_(Endpoint const &lhs, Endpoint const &rhs) noexcept {
+    // Bounds are inclusive, so touching boxes must overlap. That is why
+    // minimum goes before maximum when values are equal.
+    if (lhs.value != rhs.value)
+      return lhs.value < rhs.value;
+    return !lhs.is_max && rhs.is_max;
+  }
+
+  static std::uint64_t key_(std::size_t i, std::size_t j) noexcept {
+    assert(i < j);
+    return (std::uint64_t{i} << 32U) | std::uint64_t{j};
+  }
+  static IndexPair pair_(std::uint64_t key) noexcept {
+    return {static_cast<std::size_t>(key >> 32U),
+            static_cast<std::size_t>(key & 0xFFFFFFFFU)};
+  }
+
+  void add_(std::size_t i, std::size_t j) {
+    if (!overlaps(boxes_[i], boxes_[j]))
+      return;
+    auto key = key_(std::min(i, j), std::max(i, j));
+    if (pairs_.insert(key).second)
+      journal_.try_emplace(key, false);
+  }
+  void remove_(std::size_t i, std::size_t j) {
+    auto key = key_(std::min(i, j), std::max(i, j));
+    if (pairs_.erase(key) != 0)
+      journal_.try_emplace(key, true);
+  }
+
+  void insertion_sort_(std::vector<Endpoint> &endpoints) {
+    for (std::size_t k = 1; k < endpoints.size(); ++k) {
+      auto endpoint = endpoints[k];
+      auto j = k;
+      for (; j > 0 && less_(endpoint, endpoints[j - 1]); --j) {
+        auto const &passed = endpoints[j - 1];
+        // Each swap resolves exactly one inversion, i.e. one pair of boxes
+        // changed its relative order along this axis
+        if (!endpoint.is_max && passed.is_max)
+          add_(endpoint.box, passed.box);
+        else if (endpoint.is_max && !passed.is_max)
+          remove_(endpoint.box, passed.box);
+        endpoints[j] = passed;
+      }
+      endpoints[j] = endpoint;
+    }
+  }
+};
+
+// Narrow phase: filters candidate pairs with exact triangle test
+inline std::vector<IndexPair>
+intersecting_pairs(std::span<IndexPair const> candidates,
+                   std::span<Triangle const> triangles) {
+  auto result = std::vector<IndexPair>{};
+  for (auto const &[i, j] : candidates) {
+    if (intersects(triangles[i], triangles[j]))
+      result.push_back({i, j});
+  }
+  return result;
+}
+
+inline std::vector<IndexPair>
+intersecting_pairs(SweepAndPrune const &sap,
+                   std::span<Triangle const> triangles) {
+  assert(sap.size() == triangles.size());
+  return intersecting_pairs(sap.pairs(), triangles);
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <span>
+
+#include "geometry/batch.hpp"
+#include "geometry/matrix.hpp"
+#include "geometry/primitives.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle.hpp"
+#include "geometry/triangle_batch.hpp"
+#include "utils/thread_pool.hpp"
+
+// Rotations and transforms of 3D space.
+// Rigid transforms keep a unit quaternion and a translation: 7 numbers
+// instead of 12, rotations compose in 28 flops instead of 45, rounding drift
+// is removed by normalizing 4 numbers rather than orthogonalizing a matrix,
+// and planes and triangles are moved without recomputing their normals.
+// Affine transforms keep a general 3 x 3 matrix and a translation. Both are
+// applied to batches of points as a 3 x 3 matrix and a translation, which is
+// the cheapest form per point.
+
+namespace cpp_contests {
+
+// Quaternion w + x i + y j + z k, vec() is (x, y, z)
+template <GeometryScalar T> class BasicQuaternion final {
+private:
+  T w_ = T{1};
+  BasicPoint<T> v_{};
+
+public:
+  constexpr BasicQuaternion() noexcept = default;
+  constexpr BasicQuaternion(T w, BasicPoint<T> const &v) noexcept
+      : w_(w), v_(v) {}
+  constexpr BasicQuaternion(T w, T x, T y, T z) noexcept
+      : w_(w), v_{x, y, z} {}
+
+  // Rotation by angle radians counterclockwise around axis
+  static BasicQuaternion rotation(BasicPoint<T> const &axis, T angle) noexcept {
+    assert(n(axis) > EPSMIN);
+    auto half = angle / T{2};
+    return BasicQuaternion{std::cos(half),
+                           BasicPoint<T>{axis * (std::sin(half) / n(axis))}};
+  }
+
+  [[nodiscard]] constexpr T w() const noexcept { return w_; }
+  [[nodiscard]] constexpr BasicPoint<T> const &vec() const noexcept {
+    return v_;
+  }
+
+  // Rotates p by a unit quaternion, which is q p q* expanded to 30 flops
+  [[nodiscard]] constexpr BasicPoint<T>
+  rotate(BasicPoint<T> const &p) const noexcept {
+    auto t = BasicPoint<T>{T{2} * cross(v_, p)};
+    return BasicPoint<T>{p + w_ * t + cross(v_, t)};
+  }
+
+  // Rotation matrix of a unit quaternion
+  [[nodiscard]] constexpr Matrix<3, 3, T> matrix() const noexcept {
+    auto [x, y, z] = std::array<T, 3>{v_[0], v_[1], v_[2]};
+    auto w = w_;
+    // clang-format off
+    return Matrix<3, 3, T>{
+      {T{1} - T{2} * (y * y + z * z), T{2} * (x * y - w * z),        T{2} * (x * z + w * y)},
+      {T{2} * (x * y + w * z),        T{1} - T{2} * (x * x + z * z), T{2} * (y * z - w * x)},
+      {T{2} * (x * z - w * y),        T{2} * (y * z + w * x),        T{1} - T{2} * (x * x + y * y)},
+    };
+    // clang-format on
+  }
+
+  // Hamilton product: rotation by b, then by a
+  friend constexpr BasicQuaternion
+  operator*(BasicQuaternion const &a, BasicQuaternion const &b) noexcept {
+    return BasicQuaternion{
+        a.w_ * b.w_ - dot(a.v_, b.v_),
+        BasicPoint<T>{a.w_ * b.v_ + b.w_ * a.v_ + cross(a.v_, b.v_)}};
+  }
+};
+
+using Quaternion = BasicQuaternion<double>;
+
+template <GeometryScalar T>
+constexpr BasicQuaternion<T> conjugate(BasicQuaternion<T> const &q) noexcept {
+  return BasicQuaternion<T>{q.w(), BasicPoint<T>{-q.vec()}};
+}
+template <GeometryScalar T> T norm(BasicQuaternion<T> const &q) noexcept {
+  return std::sqrt(q.w() * q.w() + dot(q.vec(), q.vec()));
+}
+template <GeometryScalar T>
+BasicQuaternion<T> normalized(BasicQuaternion<T> const &q) noexcept {
+  auto len = norm(q);
+  assert(len > EPSMIN);
+  return BasicQuaternion<T>{q.w() / len, BasicPoint<T>{q.vec() / len}};
+}
+
+// Rotation followed by translation
+template <GeometryScalar T> class BasicRigidTransform final {
+public:
+  using value_type = T;
+  // Angles and lengths are kept, so normals are rotated as directions
+  static constexpr bool preserves_shape = true;
+
+private:
+  BasicQuaternion<T> rotation_;
+  BasicPoint<T> translation_{};
+
+public:
+  constexpr BasicRigidTransform() noexcept = default;
+  // Rotation must be a unit quaternion
+  constexpr explicit BasicRigidTransform(
+      BasicQuaternion<T> const &rotation,
+      BasicPoint<T> const &translation = BasicPoint<T>{}) noexcept
+      : rotation_(rotation), translation_(translation) {
+    assert(std::abs(norm(rotation) - T{1}) < T{EPSMAX} * T{10});
+  }
+
+  [[nodiscard]] constexpr BasicQuaternion<T> const &rotation() const noexcept {
+    return rotation_;
+  }
+  [[nodiscard]] constexpr BasicPoint<T> const &translation() const noexcept {
+    return translation_;
+  }
+  [[nodiscard]] constexpr Matrix<3, 3, T> linear() const noexcept {
+    return rotation_.matrix();
+  }
+
+  constexpr BasicPoint<T> operator()(BasicPoint<T> const &p) const noexcept {
+    return BasicPoint<T>{rotation_.rotate(p) + translation_};
+  }
+  [[nodiscard]] constexpr BasicPoint<T>
+  direction(BasicPoint<T> const &v) const noexcept {
+    return rotation_.rotate(v);
+  }
+  [[nodiscard]] constexpr BasicPoint<T>
+  normal(BasicPoint<T> const &v) const noexcept {
+    return rotation_.rotate(v);
+  }
+
+  // b, then a. The rotation is renormalized, so that rounding errors do not
+  // pile up along chains of compositions.
+  friend BasicRigidTransform operator*(BasicRigidTransform const &a,
+                                       BasicRigidTransform const &b) noexcept {
+    return BasicRigidTransform{
+        normalized(a.rotation_ * b.rotation_),
+        BasicPoint<T>{a.rotation_.rotate(b.translation_) + a.translation_}};
+  }
+};
+
+using RigidTransform = BasicRigidTransform<double>;
+
+template <GeometryScalar T>
+constexpr BasicRigidTransform<T>
+inv(BasicRigidTransform<T> const &f) noexcept {
+  auto r = conjugate(f.rotation());
+  return BasicRigidTransform<T>{r,
+                                BasicPoint<T>{-r.rotate(f.translation())}};
+}
+
+// Linear map followed by translation. The linear part must be invertible.
+template <GeometryScalar T> class BasicAffineTransform final {
+public:
+  using value_type = T;
+  static constexpr bool preserves_shape = false;
+
+private:
+  Matrix<3, 3, T> linear_ = eye<3, 3, T>();
+  BasicPoint<T> translation_{};
+
+public:
+  constexpr BasicAffineTransform() noexcept = default;
+  constexpr explicit BasicAffineTransform(
+      Matrix<3, 3, T> const &linear,
+      BasicPoint<T> const &translation = BasicPoint<T>{}) noexcept
+      : linear_(linear), translation_(translation) {}
+  constexpr explicit BasicAffineTransform(
+      BasicRigidTransform<T> const &f) noexcept
+      : linear_(f.linear()), translation_(f.translation()) {}
+
+  [[nodiscard]] constexpr Matrix<3, 3, T> const &linear() const noexcept {
+    return linear_;
+  }
+  [[nodiscard]] constexpr BasicPoint<T> const &translation() const noexcept {
+    return translation_;
+  }
+
+  constexpr BasicPoint<T> operator()(BasicPoint<T> const &p) const noexcept {
+    return BasicPoint<T>{linear_ * p + translation_};
+  }
+  [[nodiscard]] constexpr BasicPoint<T>
+  direction(BasicPoint<T> const &v) const noexcept {
+    return linear_ * v;
+  }
+  // Normals are transformed by the inverse transpose, the result is not
+  // normalized
+  [[nodiscard]] constexpr BasicPoint<T>
+  normal(BasicPoint<T> const &v) const noexcept {
+    return t(inv(linear_)) * v;
+  }
+
+  // b, then a
+  friend constexpr BasicAffineTransform
+  operator*(BasicAffineTransform const &a,
+            BasicAffineTransform const &b) noexcept {
+    return BasicAffineTransform{
+        a.linear_ * b.linear_,
+        BasicPoint<T>{a.linear_ * b.translation_ + a.translation_}};
+  }
+};
+
+using AffineTransform = BasicAffineTransform<double>;
+
+template <GeometryScalar T>
+constexpr BasicAffineTransform<T>
+inv(BasicAffineTransform<T> const &f) noexcept {
+  auto l = inv(f.linear());
+  return BasicAffineTransform<T>{l, BasicPoint<T>{-(l * f.translation())}};
+}
+
+// Rigid or affine transform, which maps points, directions and normals
+template <typename F>
+concept SpatialTransform =
+    GeometryScalar<typename F::value_type> &&
+    requires(F const &f, BasicPoint<typename F::value_type> const &p) {
+      { f(p) } -> std::same_as<BasicPoint<typename F::value_type>>;
+      { f.direction(p) } -> std::same_as<BasicPoint<typename F::value_type>>;
+      { f.normal(p) } -> std::same_as<BasicPoint<typename F::value_type>>;
+      {
+        f.linear()
+      } -> std::convertible_to<Matrix<3, 3, typename F::value_type>>;
+      {
+        f.translation()
+      } -> std::convertible_to<BasicPoint<typename F::value_type>>;
+      { F::preserves_shape } -> std::convertible_to<bool>;
+    };
+
+// In-place transformations of primitives
+
+template <SpatialTransform F>
+constexpr void apply(F const &f,
+                     BasicPoint<typename F::value_type> &p) noexcept {
+  p = f(p);
+}
+template <SpatialTransform F>
+constexpr void apply(F const &f,
+                     BasicLine<typename F::value_type> &l) noexcept {
+  l = BasicLine<typename F::value_type>{f(l.R0()), f.direction(l.R())};
+}
+template <SpatialTransform F>
+constexpr void apply(F const &f,
+                     BasicSegment<typename F::value_type> &s) noexcept {
+  s = BasicSegment<typename F::value_type>{f(s.s), f(s.e)};
+}
+template <SpatialTransform F>
+constexpr void apply(F const &f,
+                     BasicPlane<typename F::value_type> &p) noexcept {
+  using T = typename F::value_type;
+  auto normal = f.normal(p.normal());
+  auto origin = f(BasicPoint<T>{p.dist() * p.normal()});
+  p = BasicPlane<T>{normal, dot(normal, origin)};
+}
+template <SpatialTransform F>
+constexpr void apply(F const &f,
+                     BasicTriangle<typename F::value_type> &t) noexcept {
+  using T = typename F::value_type;
+  if constexpr (F::preserves_shape) {
+    auto plane = t.plane();
+    apply(f, plane);
+    t = BasicTriangle<T>{plane, f(t[0]), f(t[1]), f(t[2])};
+  } else {
+    t = BasicTriangle<T>{f(t[0]), f(t[1]), f(t[2])};
+  }
+}
+
+namespace details_ {
+
+// Transforms n points, which coordinates are x[i], y[i] and z[i]
+template <typename T>
+void transform_soa(Matrix<3, 3, T> const &m, BasicPoint<T> const &shift,
+                   T *x, T *y, T *z, std::size_t n) noexcept {
+  constexpr auto W = simd::native_width<T>;
+  using P = simd::Pack<T, W>;
+  std::size_t i = 0;
+  for (; i + W <= n; i += W) {
+    auto px = P::load(x + i);
+    auto py = P::load(y + i);
+    auto pz = P::load(z + i);
+    for (std::size_t r = 0; r < 3; ++r) {
+      auto c = fma(P{m[0, r]}, px,
+                   fma(P{m[1, r]}, py, fma(P{m[2, r]}, pz, P{shift[r]})));
+      c.store((r == 0 ? x : r == 1 ? y : z) + i);
+    }
+  }
+  for (; i < n; ++i) {
+    auto p = BasicPoint<T>{x[i], y[i], z[i]};
+    p = m * p + shift;
+    x[i] = p[0];
+    y[i] = p[1];
+    z[i] = p[2];
+  }
+}
+
+} // namespace details_
+
+// Transforms points in SoA layout: coordinates of point i are x[i], y[i] and
+// z[i]. Large batches are split between workers of the pool.
+template <SpatialTransform F>
+void apply(F const &f, std::span<typename F::value_type> x,
+           std::span<typename F::value_type> y,
+           std::span<typename F::value_type> z,
+           ThreadPool &pool = default_thread_pool()) {
+  using T = typename F::value_type;
+  assert(x.size() == y.size() && x.size() == z.size());
+  auto m = Matrix<3, 3, T>{f.linear()};
+  auto shift = BasicPoint<T>{f.translation()};
+  details_::batch_for<simd::native_width<T>>(
+      x.size(), pool, [&](std::size_t begin, std::size_t end) {
+        details_::transform_soa(m, shift, x.data() + begin, y.data() + begin,
+                                z.data() + begin, end - begin);
+      });
+}
+
+// Transforms all vertices of the batch. Padding stays zero.
+template <SpatialTransform F>
+void apply(F const &f, TriangleBatch<typename F::value_type> &batch,
+           ThreadPool &pool = default_thread_pool()) {
+  using T = typename F::value_type;
+  for (std::size_t v = 0; v < 3; ++v) {
+    apply(f, std::span<T>{batch.coord(v, 0), batch.size()},
+          std::span<T>{batch.coord(v, 1), batch.size()},
+          std::span<T>{batch.coord(v, 2), batch.size()}, pool);
+  }
+}
+
+// Transforms points stored one after another, through SoA blocks
+template <SpatialTransform F>
+void apply(F const &f, std::span<BasicPoint<typename F::value_type>> points,
+           ThreadPool &pool = default_thread_pool()) {
+  using T = typename F::value_type;
+  auto m = details_::broadcast(Matrix<3, 3, T>{f.linear()});
+  auto shift = details_::broadcast(BasicPoint<T>{f.translation()});
+  details_::batch_map<T>(
+      pool,
+      [&](auto const &p) {
+        auto r = details_::multiply_soa<3, 3, 1>(m, p);
+        for (std::size_t i = 0; i < 3; ++i)
+          r[i] = r[i] + shift[i];
+        return r;
+      },
+      points, std::span<BasicPoint<T> const>{points});
+}
+
+} // namespace cpp_contests
@@ -1,20 +1,30 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <concepts>
+#include <cstddef>
 
+#include "geometry/complanar.hpp"
 #include "geometry/matrix.hpp"
+#include "geometry/predicates.hpp"
 #include "geometry/primitives.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle_filter.hpp"
 
 namespace cpp_contests {
 
-class Triangle final {
+// Triangle with coordinates of type T. Float triangles take half of the
+// memory, while tests on them are as exact as on double ones, see below.
+template <GeometryScalar T> class BasicTriangle final {
 private:
-  Plane plane_;
-  std::array<Point, 3> points_;
+  BasicPlane<T> plane_;
+  std::array<BasicPoint<T>, 3> points_;
 
 public:
-  constexpr Triangle(Point p1, Point p2, Point p3) noexcept
+  constexpr BasicTriangle(BasicPoint<T> p1, BasicPoint<T> p2,
+                          BasicPoint<T> p3) noexcept
       : plane_(p1, p2, p3), points_({p1, p2, p3}) {
 #ifndef NDEBUG
     auto d1 = dist(p1, p2);
@@ -23,37 +33,77 @@ public:
     assert(d1 + d2 > d3 && d2 + d3 > d1 && d3 + d1 > d2);
 #endif
   }
+  // Triangle, which plane is already known, e.g. moved along with the points
+  // by a rigid transform
+  constexpr BasicTriangle(BasicPlane<T> const &plane, BasicPoint<T> p1,
+                          BasicPoint<T> p2, BasicPoint<T> p3) noexcept
+      : plane_(plane), points_({p1, p2, p3}) {}
+  // Conversion to float rounds coordinates
+  template <GeometryScalar U>
+    requires(!std::same_as<T, U>)
+  constexpr explicit BasicTriangle(BasicTriangle<U> const &other) noexcept
+      : BasicTriangle(BasicPoint<T>(other[0]), BasicPoint<T>(other[1]),
+                      BasicPoint<T>(other[2])) {}
 
-  [[nodiscard]] constexpr Point const &
+  [[nodiscard]] constexpr BasicPoint<T> const &
   operator[](std::size_t i) const noexcept {
     assert(i < 3);
     return points_[i];
   }
-  [[nodiscard]] constexpr Plane const &plane() const noexcept { return plane_; }
+  [[nodiscard]] constexpr BasicPlane<T> const &plane() const noexcept {
+    return plane_;
+  }
 };
 
+using Triangle = BasicTriangle<double>;
+
+namespace details_ {
+
+// The same triangle with double coordinates. No copy is made for double ones.
+template <GeometryScalar T>
+constexpr decltype(auto) promoted(BasicTriangle<T> const &t) noexcept {
+  if constexpr (std::same_as<T, double>)
+    return (t);
+  else
+    return Triangle(t);
+}
+
+} // namespace details_
+
+template <GeometryScalar T>
+constexpr BasicBox<T> bounding_box(BasicTriangle<T> const &t) noexcept {
+  auto box = BasicBox<T>{t[0], t[0]};
+  for (std::size_t i = 1; i < 3; ++i) {
+    for (std::size_t j = 0; j < 3; ++j) {
+      box.min[j] = std::min(box.min[j], t[i][j]);
+      box.max[j] = std::max(box.max[j], t[i][j]);
+    }
+  }
+  return box;
+}
+
+// Exact, see geometry/complanar.hpp. Triangles, which are not complanar,
+// do not intersect as far as this test is concerned.
 constexpr bool complanar_intersects(Triangle const &t1,
                                     Triangle const &t2) noexcept {
-  if (std::abs(t1.plane().dist() - t2.plane().dist()) > EPSMIN) {
-    return false;
-  }
+  // Planes of triangles may have opposite normals, so the plane of t1 is
+  // compared with vertices of t2 exactly rather than with the plane of t2
+  auto orientation = Orientation3d(t1[0], t1[1], t1[2]);
   for (std::size_t i = 0; i < 3; ++i) {
-    auto seg1 = Segment(t1[i % 3], t1[(i + 1) % 3]);
-    for (std::size_t j = 0; j < 3; ++j) {
-      auto seg2 = Segment(t2[j % 3], t2[(j + 1) % 3]);
-      if (complanar_intersection(seg1, seg2))
-        return true;
-    }
+    if (orientation(t2[i]) != 0)
+      return false;
   }
-  return false;
+  return details_::complanar_overlap(t1, t2,
+                                     details_::complanar_axis(t1, t2));
 }
 
-constexpr std::optional<Segment> complanar_intersection(Triangle const &t,
-                                                        Line const &l) {
-  Vector<3, Point> result{};
+template <GeometryScalar T>
+constexpr std::optional<BasicSegment<T>>
+complanar_intersection(BasicTriangle<T> const &t, BasicLine<T> const &l) {
+  Vector<3, BasicPoint<T>> result{};
   std::size_t j = 0;
   for (std::size_t i = 0; i < 3; ++i) {
-    auto side = Segment(t[i % 3], t[(i + 1) % 3]);
+    auto side = BasicSegment<T>(t[i % 3], t[(i + 1) % 3]);
     auto intersection = complanar_intersection(side, l);
     if (!intersection) {
       continue;
@@ -61,17 +111,19 @@ constexpr std::optional<Segment> complanar_intersection(Triangle const &t,
     result[j] = intersection.value();
     ++j;
   }
-  assert(j == 0 || j == 2 || j == 3);
   if (j == 0)
     return std::nullopt;
+  if (j == 1)
+    // The line touches a vertex, rounding placed it on one side only
+    return BasicSegment<T>(result[0], result[0]);
   if (j == 2)
-    return Segment(result[0], result[1]);
+    return BasicSegment<T>(result[0], result[1]);
 
   // A corner case where line intersects triangle through one of the vertices
   // and the opposite side
   // We need to pick two most distant points
   // clang-format off
-  auto diffs = std::array<double, 3>{
+  auto diffs = std::array<T, 3>{
       n(result[1] - result[0]),
       n(result[2] - result[1]),
       n(result[0] - result[2])
@@ -79,16 +131,88 @@ constexpr std::optional<Segment> complanar_intersection(Triangle const &t,
   // clang-format on
   auto n = std::max_element(diffs.begin(), diffs.end()) - diffs.begin();
   auto inds = (iota<2>() + n) % 3;
-  return Segment{result[inds[0]], result[inds[1]]};
+  return BasicSegment<T>{result[inds[0]], result[inds[1]]};
 }
 
-constexpr std::optional<Segment> complanar_intersection(Line const &l,
-                                                        Triangle const &t) {
+template <GeometryScalar T>
+constexpr std::optional<BasicSegment<T>>
+complanar_intersection(BasicLine<T> const &l, BasicTriangle<T> const &t) {
   return complanar_intersection(t, l);
 }
 
+namespace details_ {
+
+// Orientations of vertices of t relative to the plane of other
+constexpr std::array<int, 3> orientations(Triangle const &t,
+                                          Triangle const &other) noexcept {
+  auto orientation = Orientation3d(other[0], other[1], other[2]);
+  return {orientation(t[0]), orientation(t[1]), orientation(t[2])};
+}
+
+constexpr bool same_side(std::array<int, 3> const &o) noexcept {
+  return o[0] != 0 && o[0] == o[1] && o[0] == o[2];
+}
+
+// Guigue-Devillers test for triangles in canonical form: p1 is alone on its
+// side of the plane of the second triangle (or the only vertex on it) and p2
+// is alone on the positive side of the plane of the first triangle. Then
+// triangles intersect iff intervals cut from the planes intersection line
+// overlap, which is decided by two orientations of input points only.
+constexpr bool min_max_overlap(Point const &p1, Point const &q1,
+                               Point const &r1, Point const &p2,
+                               Point const &q2, Point const &r2) noexcept {
+  if (orient3d(q1, p2, p1, q2) > 0)
+    return false;
+  return orient3d(p1, p2, r1, r2) <= 0;
+}
+
+// Brings the second triangle to canonical form, given that p1 is already
+// alone on its side. o2 are orientations of p2, q2, r2 relative to the plane
+// of the first triangle, not all of them are zero.
+constexpr bool canonical_intersects(Point const &p1, Point const &q1,
+                                    Point const &r1, Point const &p2,
+                                    Point const &q2, Point const &r2,
+                                    std::array<int, 3> const &o2) noexcept {
+  auto [dp2, dq2, dr2] = o2;
+  if (dp2 > 0) {
+    if (dq2 > 0)
+      return min_max_overlap(p1, r1, q1, r2, p2, q2);
+    if (dr2 > 0)
+      return min_max_overlap(p1, r1, q1, q2, r2, p2);
+    return min_max_overlap(p1, q1, r1, p2, q2, r2);
+  }
+  if (dp2 < 0) {
+    if (dq2 < 0)
+      return min_max_overlap(p1, q1, r1, r2, p2, q2);
+    if (dr2 < 0)
+      return min_max_overlap(p1, q1, r1, q2, r2, p2);
+    return min_max_overlap(p1, r1, q1, p2, q2, r2);
+  }
+  if (dq2 < 0) {
+    if (dr2 >= 0)
+      return min_max_overlap(p1, r1, q1, q2, r2, p2);
+    return min_max_overlap(p1, q1, r1, p2, q2, r2);
+  }
+  if (dq2 > 0) {
+    if (dr2 > 0)
+      return min_max_overlap(p1, r1, q1, p2, q2, r2);
+    return min_max_overlap(p1, q1, r1, q2, r2, p2);
+  }
+  assert(dr2 != 0);
+  if (dr2 > 0)
+    return min_max_overlap(p1, q1, r1, r2, p2, q2);
+  return min_max_overlap(p1, r1, q1, r2, p2, q2);
+}
+
+} // namespace details_
+
 constexpr std::optional<Segment> intersection(Triangle const &t1,
                                               Triangle const &t2) noexcept {
+  // Cheap rejection before any construction
+  if (details_::same_side(details_::orientations(t1, t2)) ||
+      details_::same_side(details_::orientations(t2, t1)))
+    return std::nullopt;
+
   auto intersection_opt = intersection(t1.plane(), t2.plane());
   if (!intersection_opt)
     // Triangles are complanar
@@ -115,16 +239,121 @@ constexpr std::optional<Segment> intersection(Triangle const &t1,
     swap(s1, s2);
     swap(e1, e2);
   }
+  // The second interval may lie inside the first one
   if (s2 <= e1)
-    return Segment{intersection.point(s2), intersection.point(e1)};
+    return Segment{intersection.point(s2),
+                   intersection.point(std::min(e1, e2))};
 
   return std::nullopt;
 }
 
+namespace details_ {
+
+// Exact test of triangles, given orientations o1 of vertices of t1 relative
+// to the plane of t2 and o2 the other way around. Triangles are anything
+// with three Points, complanar ones are passed to complanar_overlap.
+template <typename Tri>
+constexpr bool oriented_intersects(Tri const &t1, Tri const &t2,
+                                   std::array<int, 3> const &o1,
+                                   std::array<int, 3> const &o2) noexcept {
+  if (same_side(o1) || same_side(o2))
+    return false;
+  if (o1 == std::array{0, 0, 0} || o2 == std::array{0, 0, 0})
+    return complanar_overlap(t1, t2, complanar_axis(t1, t2));
+
+  // Bring the first triangle to canonical form: p1 is alone on its side
+  auto const &p1 = t1[0];
+  auto const &q1 = t1[1];
+  auto const &r1 = t1[2];
+  auto const &p2 = t2[0];
+  auto const &q2 = t2[1];
+  auto const &r2 = t2[2];
+  auto flipped = std::array{o2[0], o2[2], o2[1]};
+  auto [dp1, dq1, dr1] = o1;
+  if (dp1 > 0) {
+    if (dq1 > 0)
+      return canonical_intersects(r1, p1, q1, p2, r2, q2, flipped);
+    if (dr1 > 0)
+      return canonical_intersects(q1, r1, p1, p2, r2, q2, flipped);
+    return canonical_intersects(p1, q1, r1, p2, q2, r2, o2);
+  }
+  if (dp1 < 0) {
+    if (dq1 < 0)
+      return canonical_intersects(r1, p1, q1, p2, q2, r2, o2);
+    if (dr1 < 0)
+      return canonical_intersects(q1, r1, p1, p2, q2, r2, o2);
+    return canonical_intersects(p1, q1, r1, p2, r2, q2, flipped);
+  }
+  if (dq1 < 0) {
+    if (dr1 >= 0)
+      return canonical_intersects(q1, r1, p1, p2, r2, q2, flipped);
+    return canonical_intersects(p1, q1, r1, p2, q2, r2, o2);
+  }
+  if (dq1 > 0) {
+    if (dr1 > 0)
+      return canonical_intersects(p1, q1, r1, p2, r2, q2, flipped);
+    return canonical_intersects(q1, r1, p1, p2, q2, r2, o2);
+  }
+  if (dr1 > 0)
+    return canonical_intersects(r1, p1, q1, p2, q2, r2, o2);
+  return canonical_intersects(r1, p1, q1, p2, r2, q2, flipped);
+}
+
+} // namespace details_
+
+// Intersection test based on exact orientation predicates only.
+// Most of the pairs are rejected after signs of vertex distances to the other
+// plane, which cost a few multiply-adds each. No points are constructed, so
+// touching and nearly degenerate configurations are decided exactly.
 constexpr bool intersects(Triangle const &t1, Triangle const &t2) noexcept {
-  if (complanar(t1.plane(), t2.plane()))
-    return complanar_intersects(t1, t2);
-  return intersection(t1, t2).has_value();
+  auto o1 = details_::orientations(t1, t2);
+  if (details_::same_side(o1))
+    return false;
+  return details_::oriented_intersects(t1, t2, o1,
+                                       details_::orientations(t2, t1));
+}
+
+// Triangles with float coordinates are intersected in double, which holds
+// their coordinates exactly
+template <GeometryScalar T>
+  requires(!std::same_as<T, double>)
+constexpr bool complanar_intersects(BasicTriangle<T> const &t1,
+                                    BasicTriangle<T> const &t2) noexcept {
+  return complanar_intersects(Triangle(t1), Triangle(t2));
+}
+template <GeometryScalar T>
+  requires(!std::same_as<T, double>)
+constexpr std::optional<Segment>
+intersection(BasicTriangle<T> const &t1, BasicTriangle<T> const &t2) noexcept {
+  return intersection(Triangle(t1), Triangle(t2));
+}
+// Float triangles are tested by the certified float filter first, and only
+// pairs, which it leaves uncertain, are promoted to double
+template <GeometryScalar T>
+  requires(!std::same_as<T, double>)
+constexpr bool intersects(BasicTriangle<T> const &t1,
+                          BasicTriangle<T> const &t2) noexcept {
+  using P = simd::Pack<T, 1>;
+  auto points = [](BasicTriangle<T> const &t) {
+    auto point = [&](std::size_t v) {
+      return details_::PackPoint<P>{P{t[v][0]}, P{t[v][1]}, P{t[v][2]}};
+    };
+    return std::array{point(0), point(1), point(2)};
+  };
+  // Stages go one by one, as in the double test, so most pairs are rejected
+  // after the distances of one triangle
+  auto u = points(t1);
+  auto v = points(t2);
+  auto du = details_::plane_distances(u, v);
+  if (du.separated()[0])
+    return false;
+  auto dv = details_::plane_distances(v, u);
+  if (dv.separated()[0])
+    return false;
+  auto [hits, uncertain] = details_::filtered_overlap(u, v, du, dv);
+  if (!uncertain[0])
+    return hits[0];
+  return intersects(Triangle(t1), Triangle(t2));
 }
 
 } // namespace cpp_contests
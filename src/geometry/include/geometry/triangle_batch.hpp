@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "geometry/primitives.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle.hpp"
+#include "geometry/triangle_filter.hpp"
+
+namespace cpp_contests {
+
+// Structure of arrays triangle storage.
+// Coordinate c of vertex v of all triangles lies contiguously in
+// coord(v, c), so one SIMD register holds the same coordinate of several
+// triangles. Arrays are padded with zeros up to a multiple of the widest
+// SIMD register, so kernels may always load whole packs.
+// Float batches take half of the memory and process twice as many triangles
+// per register, while the results stay exact, see intersects below.
+template <typename T = double> class TriangleBatch final {
+public:
+  using value_type = T;
+  static constexpr std::size_t padding = 64 / sizeof(T);
+
+private:
+  std::array<std::vector<T>, 9> coords_;
+  std::size_t size_ = 0;
+
+public:
+  TriangleBatch() = default;
+  explicit TriangleBatch(std::span<Triangle const> triangles) {
+    reserve(triangles.size());
+    for (auto const &t : triangles)
+      push_back(t);
+  }
+  explicit TriangleBatch(std::span<BasicTriangle<T> const> triangles)
+    requires(!std::same_as<T, double>)
+  {
+    reserve(triangles.size());
+    for (auto const &t : triangles)
+      push_back(t);
+  }
+
+  void reserve(std::size_t n) {
+    for (auto &c : coords_)
+      c.reserve(padded_(n));
+  }
+  // New triangles have all vertices at the origin
+  void resize(std::size_t n) {
+    for (auto &c : coords_) {
+      c.resize(padded_(n));
+      std::fill(c.begin() + static_cast<std::ptrdiff_t>(n), c.end(), T{0});
+    }
+    size_ = n;
+  }
+  template <GeometryScalar U> void push_back(BasicTriangle<U> const &t) {
+    for (auto &c : coords_)
+      c.resize(padded_(size_ + 1));
+    for (std::size_t v = 0; v < 3; ++v) {
+      for (std::size_t c = 0; c < 3; ++c)
+        coords_[3 * v + c][size_] = static_cast<T>(t[v][c]);
+    }
+    ++size_;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] T const *coord(std::size_t vertex,
+                               std::size_t axis) const noexcept {
+    assert(vertex < 3 && axis < 3);
+    return coords_[3 * vertex + axis].data();
+  }
+  [[nodiscard]] T *coord(std::size_t vertex, std::size_t axis) noexcept {
+    assert(vertex < 3 && axis < 3);
+    return coords_[3 * vertex + axis].data();
+  }
+  [[nodiscard]] Point point(std::size_t i, std::size_t vertex) const noexcept {
+    assert(i < size_);
+    return Point{static_cast<double>(coord(vertex, 0)[i]),
+                 static_cast<double>(coord(vertex, 1)[i]),
+                 static_cast<double>(coord(vertex, 2)[i])};
+  }
+  // Triangle i with double coordinates, which are exact for any T
+  [[nodiscard]] Triangle operator[](std::size_t i) const noexcept {
+    return Triangle{point(i, 0), point(i, 1), point(i, 2)};
+  }
+  [[nodiscard]] BasicTriangle<T> triangle(std::size_t i) const noexcept
+    requires GeometryScalar<T>
+  {
+    assert(i < size_);
+    auto vertex = [&](std::size_t v) {
+      return BasicPoint<T>{coord(v, 0)[i], coord(v, 1)[i], coord(v, 2)[i]};
+    };
+    return BasicTriangle<T>{vertex(0), vertex(1), vertex(2)};
+  }
+
+private:
+  static std::size_t padded_(std::size_t n) noexcept {
+    return (n + padding - 1) / padding * padding;
+  }
+};
+
+// Tests t against W triangles of the batch starting from first with the
+// certified filter of triangle_filter.hpp in all lanes at once. Lanes, which
+// it leaves uncertain (touching, coplanar or nearly parallel triangles,
+// slivers), are re-checked with scalar intersects, so results are the same as
+// of intersects. If t is not representable in T, all lanes are tested by it.
+// Bit i of the result is set if t intersects triangle first + i.
+template <typename T, std::size_t W = simd::native_width<T>,
+          GeometryScalar U = double>
+std::uint64_t intersects(BasicTriangle<U> const &t,
+                         TriangleBatch<T> const &batch,
+                         std::size_t first) noexcept {
+  using P = simd::Pack<T, W>;
+  using PP = details_::PackPoint<P>;
+  static_assert(TriangleBatch<T>::padding % W == 0);
+  assert(first < batch.size());
+  auto valid = simd::first_lanes<T, W>(batch.size() - first);
+
+  auto recheck_all = false;
+  if constexpr (!std::same_as<T, U>) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      for (std::size_t c = 0; c < 3; ++c)
+        recheck_all |= static_cast<U>(static_cast<T>(t[i][c])) != t[i][c];
+    }
+  }
+  auto recheck_lanes = [&](std::uint64_t result, std::uint64_t recheck) {
+    for (; recheck != 0; recheck &= recheck - 1) {
+      auto lane = static_cast<std::size_t>(std::countr_zero(recheck));
+      if (intersects(details_::promoted(t), batch[first + lane]))
+        result |= std::uint64_t{1} << lane;
+    }
+    return result;
+  };
+  if (recheck_all)
+    return recheck_lanes(0, valid.bits());
+
+  auto load = [&](std::size_t v) {
+    return PP{P::load(batch.coord(v, 0) + first),
+              P::load(batch.coord(v, 1) + first),
+              P::load(batch.coord(v, 2) + first)};
+  };
+  auto broadcast = [](BasicPoint<U> const &p) {
+    return PP{P{static_cast<T>(p[0])}, P{static_cast<T>(p[1])},
+              P{static_cast<T>(p[2])}};
+  };
+  auto u =
+      std::array<PP, 3>{broadcast(t[0]), broadcast(t[1]), broadcast(t[2])};
+  auto v = std::array<PP, 3>{load(0), load(1), load(2)};
+
+  auto [hits, uncertain] = details_::filtered_intersects(u, v);
+  return recheck_lanes((hits & valid).bits(), (uncertain & valid).bits());
+}
+
+// Calls f(i) for every triangle of the batch intersected by t. This suits
+// one triangle against a contiguous range of many; candidate pairs of a broad
+// phase are scattered, so the narrow phase tests them one by one instead.
+template <typename T, GeometryScalar U, std::invocable<std::size_t> F>
+void for_each_intersecting(BasicTriangle<U> const &t,
+                           TriangleBatch<T> const &batch, F &&f) {
+  constexpr auto W = simd::native_width<T>;
+  for (std::size_t first = 0; first < batch.size(); first += W) {
+    auto bits = intersects<T, W>(t, batch, first);
+    for (; bits != 0; bits &= bits - 1)
+      f(first + static_cast<std::size_t>(std::countr_zero(bits)));
+  }
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "geometry/bvh.hpp"
+#include "geometry/distance.hpp"
+#include "geometry/morton.hpp"
+#include "geometry/primitives.hpp"
+#include "geometry/ray.hpp"
+#include "geometry/simd.hpp"
+#include "geometry/triangle.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+namespace details_ {
+
+// Order, in which rays are cast in batches: grouped by direction octant and
+// then along the Z-order curve of origins quantized to a grid in the box with
+// 2^Bits cells along each axis. Neighbouring rays traverse mostly the same
+// nodes, which then stay in cache. Keys are few, so rays are counting sorted
+// by them in linear time.
+template <std::size_t Bits, GeometryScalar T>
+std::vector<std::uint32_t> coherent_order(std::span<BasicRay<T> const> rays,
+                                          BasicBox<T> const &box) {
+  static_assert(Bits <= 5);
+  assert(rays.size() <= std::numeric_limits<std::uint32_t>::max());
+  constexpr std::size_t bits = Bits;
+  constexpr auto cells = static_cast<T>((1U << bits) - 1);
+  auto scale = BasicPoint<T>{};
+  for (std::size_t c = 0; c < 3; ++c) {
+    auto extent = box.max[c] - box.min[c];
+    scale[c] = extent > T{0} ? cells / extent : T{0};
+  }
+  auto key = [&](BasicRay<T> const &ray) {
+    auto result = std::uint32_t{0};
+    for (std::size_t c = 0; c < 3; ++c) {
+      auto cell = std::clamp((ray.origin[c] - box.min[c]) * scale[c], T{0},
+                             cells);
+      result |= static_cast<std::uint32_t>(
+                    spread_bits(static_cast<std::uint64_t>(cell)))
+                << c;
+      if (ray.direction[c] < T{0})
+        result |= std::uint32_t{1} << (3 * bits + c);
+    }
+    return result;
+  };
+
+  auto keys = std::vector<std::uint32_t>(rays.size());
+  auto starts = std::vector<std::uint32_t>(std::size_t{1} << (3 * bits + 3));
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    keys[i] = key(rays[i]);
+    ++starts[keys[i]];
+  }
+  auto sum = std::uint32_t{0};
+  for (auto &start : starts)
+    sum += std::exchange(start, sum);
+  auto order = std::vector<std::uint32_t>(rays.size());
+  for (std::size_t i = 0; i < rays.size(); ++i)
+    order[starts[keys[i]]++] = static_cast<std::uint32_t>(i);
+  return order;
+}
+
+} // namespace details_
+
+// Triangles with a BVH over them for ray casts and closest point queries.
+// The binary BVH is collapsed into a wide one, which nodes have up to
+// native_width<T> children, so that the ray is tested against all child
+// boxes of a node with one SIMD slab test. Leaves hold up to as many
+// triangles, which are tested with one SIMD Moller-Trumbore kernel call.
+// Coordinates of a leaf are stored contiguously as structure of arrays, so
+// the test reads a few adjacent cache lines. Children are visited front to
+// back and subtrees farther than the closest hit so far are skipped.
+// Closest point queries visit children nearest first too and skip those,
+// which boxes are farther than the closest triangle found so far.
+template <GeometryScalar T> class BasicTriangleBvh final {
+public:
+  static constexpr std::size_t width = simd::native_width<T>;
+
+private:
+  using Pack = simd::Pack<T, width>;
+
+  // Children of a node: inner nodes have zero count and refer to nodes_ by
+  // first, leaves refer to blocks of leaves_. Unused slots have empty boxes.
+  struct Node {
+    // Minimal and then maximal coordinates of child boxes along each axis
+    std::array<std::array<T, width>, 6> bounds;
+    std::array<std::uint32_t, width> first;
+    std::array<std::uint32_t, width> count;
+  };
+
+  // Child to visit with the param, where the ray enters it
+  struct Entry {
+    std::uint32_t first;
+    std::uint32_t count;
+    T t;
+  };
+
+  // Coordinates of leaf triangles: block b holds coordinate c of vertex v
+  // of its triangles at b * block_ + (3 * v + c) * width. Unused lanes are
+  // zero.
+  static constexpr std::size_t block_ = 9 * width;
+
+  std::vector<Node> nodes_;
+  std::vector<T> leaves_;
+  // Mesh indices of leaf triangles, block by block
+  std::vector<std::uint32_t> indices_;
+  std::size_t size_ = 0;
+  BasicBox<T> box_{};
+  // Wide node depth never exceeds the binary one
+  static constexpr std::size_t stack_size_ = BasicBvh<T>::max_depth * width;
+
+public:
+  BasicTriangleBvh() = default;
+  explicit BasicTriangleBvh(std::span<BasicTriangle<T> const> triangles) {
+    auto boxes = std::vector<BasicBox<T>>{};
+    boxes.reserve(triangles.size());
+    for (auto const &t : triangles)
+      boxes.push_back(bounding_box(t));
+    auto bvh = BasicBvh<T>(std::span<BasicBox<T> const>{boxes}, width);
+    size_ = triangles.size();
+    if (bvh.empty())
+      return;
+    box_ = bvh.box();
+    // A lone leaf still gets a node over it
+    auto root = bvh.nodes().front();
+    if (root.leaf()) {
+      nodes_.emplace_back(empty_node_());
+      set_child_(nodes_.back(), 0, root.box,
+                 add_leaf_(bvh, triangles, root.first, root.count),
+                 root.count);
+    } else {
+      collapse_(bvh, triangles, 0);
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  // Bounds of all triangles
+  [[nodiscard]] BasicBox<T> const &box() const noexcept { return box_; }
+
+  // The closest hit in [ray.tmin, ray.tmax] with the triangle index
+  [[nodiscard]] std::optional<BasicRayHit<T>>
+  closest_hit(BasicRay<T> const &ray) const noexcept {
+    return cast_<false>(ray);
+  }
+  // Whether anything is hit in [ray.tmin, ray.tmax], e.g. whether the
+  // segment between two points is blocked. Stops at the first hit found.
+  [[nodiscard]] bool any_hit(BasicRay<T> const &ray) const noexcept {
+    return cast_<true>(ray).has_value();
+  }
+
+  // Batched casts. Rays are cast on the pool in the coherent order rather
+  // than in the given one, results are stored at indices of their rays.
+  void closest_hits(std::span<BasicRay<T> const> rays,
+                    std::span<std::optional<BasicRayHit<T>>> hits,
+                    ThreadPool &pool = default_thread_pool()) const {
+    assert(hits.size() == rays.size());
+    cast_all_(rays, pool,
+              [&](std::size_t i) { hits[i] = closest_hit(rays[i]); });
+  }
+  // Non-zero hits[i] tell, that ray i hits anything
+  void any_hits(std::span<BasicRay<T> const> rays,
+                std::span<std::uint8_t> hits,
+                ThreadPool &pool = default_thread_pool()) const {
+    assert(hits.size() == rays.size());
+    cast_all_(rays, pool, [&](std::size_t i) {
+      hits[i] = static_cast<std::uint8_t>(any_hit(rays[i]));
+    });
+  }
+
+  // Point of the mesh closest to p, if it is not farther than max_dist.
+  // Smaller bounds prune more, e.g. clearance checks need only the distance
+  // they compare with.
+  [[nodiscard]] std::optional<BasicNearestPoint<T>> nearest_point(
+      BasicPoint<T> const &p,
+      T max_dist = std::numeric_limits<T>::infinity()) const noexcept {
+    if (empty())
+      return std::nullopt;
+    // Squared distances are compared. Unused slots are infinitely far, so
+    // the bound is kept finite to never visit them.
+    auto bound = std::min(max_dist * max_dist, std::numeric_limits<T>::max());
+    auto point = std::array<Pack, 3>{Pack{p[0]}, Pack{p[1]}, Pack{p[2]}};
+    auto best = std::optional<BasicNearestPoint<T>>{};
+    std::array<Entry, stack_size_> stack; // NOLINT
+    auto top = std::size_t{0};
+    stack[top++] = Entry{0, 0, T{0}};
+    while (top != 0) {
+      auto current = stack[--top];
+      if (current.t > bound)
+        continue;
+      if (current.count != 0) {
+        auto const *block = leaves_.data() + current.first * block_;
+        auto vertex = [&](std::size_t v, std::size_t lane) {
+          auto const *coords = block + 3 * v * width + lane;
+          return BasicPoint<T>{coords[0], coords[width], coords[2 * width]};
+        };
+        for (std::size_t lane = 0; lane < current.count; ++lane) {
+          auto q = details_::closest_point(p, vertex(0, lane), vertex(1, lane),
+                                           vertex(2, lane));
+          auto d = BasicPoint<T>{q - p};
+          auto dist = dot(d, d);
+          if (best ? dist >= bound : dist > bound)
+            continue;
+          bound = dist;
+          best = BasicNearestPoint<T>{q, dist,
+                                      indices_[current.first * width + lane]};
+        }
+        continue;
+      }
+
+      auto const &node = nodes_[current.first];
+      auto dists = box_dists_(node, point);
+      auto base = top;
+      for (auto bits = (dists <= Pack{bound}).bits(); bits != 0;
+           bits &= bits - 1) {
+        auto slot = static_cast<std::size_t>(std::countr_zero(bits));
+        auto entry = Entry{node.first[slot], node.count[slot], dists[slot]};
+        auto k = top++;
+        assert(top <= stack.size());
+        for (; k != base && stack[k - 1].t < entry.t; --k)
+          stack[k] = stack[k - 1];
+        stack[k] = entry;
+      }
+    }
+    if (best)
+      best->distance = std::sqrt(best->distance);
+    return best;
+  }
+
+  // Batched closest point queries on the pool
+  void nearest_points(
+      std::span<BasicPoint<T> const> points,
+      std::span<std::optional<BasicNearestPoint<T>>> nearest,
+      T max_dist = std::numeric_limits<T>::infinity(),
+      ThreadPool &pool = default_thread_pool()) const {
+    assert(nearest.size() == points.size());
+    constexpr std::size_t grain = 256;
+    pool.parallel_for(
+        points.size(), grain,
+        [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+          for (auto i = begin; i < end; ++i)
+            nearest[i] = nearest_point(points[i], max_dist);
+        });
+  }
+
+private:
+  static Node empty_node_() noexcept {
+    constexpr auto inf = std::numeric_limits<T>::infinity();
+    auto node = Node{};
+    for (std::size_t c = 0; c < 3; ++c) {
+      node.bounds[c].fill(inf);
+      node.bounds[3 + c].fill(-inf);
+    }
+    node.first.fill(0);
+    node.count.fill(0);
+    return node;
+  }
+  static void set_child_(Node &node, std::size_t slot, BasicBox<T> const &box,
+                         std::uint32_t first, std::uint32_t count) noexcept {
+    for (std::size_t c = 0; c < 3; ++c) {
+      node.bounds[c][slot] = box.min[c];
+      node.bounds[3 + c][slot] = box.max[c];
+    }
+    node.first[slot] = first;
+    node.count[slot] = count;
+  }
+  static T area_(BasicBox<T> const &box) noexcept {
+    auto d = BasicPoint<T>{box.max - box.min};
+    return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+  }
+
+  // Copies triangles of the binary leaf to a new block and returns its index
+  std::uint32_t add_leaf_(BasicBvh<T> const &bvh,
+                          std::span<BasicTriangle<T> const> triangles,
+                          std::uint32_t first, std::uint32_t count) {
+    assert(count <= width);
+    auto block = static_cast<std::uint32_t>(indices_.size() / width);
+    leaves_.resize(leaves_.size() + block_);
+    indices_.resize(indices_.size() + width);
+    auto *coords = leaves_.data() + block * block_;
+    for (std::size_t lane = 0; lane < count; ++lane) {
+      auto index = bvh.indices()[first + lane];
+      auto const &t = triangles[index];
+      for (std::size_t k = 0; k < 9; ++k)
+        coords[k * width + lane] = t[k / 3][k % 3];
+      indices_[block * width + lane] = index;
+    }
+    return block;
+  }
+
+  // Makes the wide node of the binary inner one: its largest inner
+  // descendants are opened, until there are enough children
+  std::uint32_t collapse_(BasicBvh<T> const &bvh,
+                          std::span<BasicTriangle<T> const> triangles,
+                          std::uint32_t index) {
+    auto nodes = bvh.nodes();
+    auto children = std::vector<std::uint32_t>{index + 1, nodes[index].first};
+    while (children.size() < width) {
+      auto largest = children.end();
+      for (auto it = children.begin(); it != children.end(); ++it) {
+        if (!nodes[*it].leaf() &&
+            (largest == children.end() ||
+             area_(nodes[*it].box) > area_(nodes[*largest].box)))
+          largest = it;
+      }
+      if (largest == children.end())
+        break;
+      auto opened = *largest;
+      *largest = opened + 1;
+      children.push_back(nodes[opened].first);
+    }
+
+    auto result = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back(empty_node_());
+    for (std::size_t slot = 0; slot < children.size(); ++slot) {
+      auto const &child = nodes[children[slot]];
+      auto first = child.leaf()
+                       ? add_leaf_(bvh, triangles, child.first, child.count)
+                       : collapse_(bvh, triangles, children[slot]);
+      set_child_(nodes_[result], slot, child.box, first, child.count);
+    }
+    return result;
+  }
+
+  // Ray data for slab tests. Inverse direction components are finite, so
+  // params are never NaN: rays parallel to a slab get huge ones of the
+  // proper sign, or zero ones exactly on it.
+  struct Slabs {
+    std::array<Pack, 3> origin;
+    std::array<Pack, 3> inv;
+    std::array<std::size_t, 3> near;
+  };
+
+  static Slabs slabs_(BasicRay<T> const &ray) noexcept {
+    constexpr auto huge = std::numeric_limits<T>::max();
+    auto slabs = Slabs{};
+    for (std::size_t c = 0; c < 3; ++c) {
+      auto inv = std::clamp(T{1} / ray.direction[c], -huge, huge);
+      if (ray.direction[c] == T{0})
+        inv = std::signbit(ray.direction[c]) ? -huge : huge;
+      slabs.origin[c] = Pack{ray.origin[c]};
+      slabs.inv[c] = Pack{inv};
+      slabs.near[c] = inv < T{0} ? 3 + c : c;
+    }
+    return slabs;
+  }
+
+  // Params, where the ray enters child boxes within [tmin, tmax], and the
+  // mask of boxes it hits
+  static std::pair<Pack, std::uint64_t> enter_(Node const &node,
+                                               Slabs const &slabs, T tmin,
+                                               T tmax) noexcept {
+    // Params are widened outward by a few roundings whatever their signs, so
+    // boxes of triangles, which the ray grazes, are never culled. Scaling by
+    // 1 -+ eps rather than adding |x| * eps keeps infinite params from NaNs.
+    constexpr auto eps = 4 * std::numeric_limits<T>::epsilon();
+    auto down = Pack{T{1} - eps};
+    auto up = Pack{T{1} + eps};
+    auto near = std::array<Pack, 3>{};
+    auto far = std::array<Pack, 3>{};
+    for (std::size_t c = 0; c < 3; ++c) {
+      auto const &bounds = node.bounds;
+      near[c] = (Pack::load(bounds[slabs.near[c]].data()) - slabs.origin[c]) *
+                slabs.inv[c];
+      far[c] = (Pack::load(bounds[(slabs.near[c] + 3) % 6].data()) -
+                slabs.origin[c]) *
+               slabs.inv[c];
+    }
+    // Independent axes are combined pairwise to shorten dependency chains
+    auto lo = max(max(near[0], near[1]), near[2]);
+    auto hi = min(min(far[0], far[1]), far[2]);
+    lo = max(min(lo * down, lo * up), Pack{tmin});
+    hi = min(max(hi * down, hi * up), Pack{tmax});
+    return {lo, (lo <= hi).bits()};
+  }
+
+  // Squared distances from p to child boxes, zero for boxes containing it
+  static Pack box_dists_(Node const &node,
+                         std::array<Pack, 3> const &p) noexcept {
+    auto zero = Pack{T{0}};
+    auto sum = zero;
+    for (std::size_t c = 0; c < 3; ++c) {
+      auto below = Pack::load(node.bounds[c].data()) - p[c];
+      auto above = p[c] - Pack::load(node.bounds[3 + c].data());
+      auto d = max(max(below, above), zero);
+      sum = fma(d, d, sum);
+    }
+    return sum;
+  }
+
+  template <bool Any>
+  std::optional<BasicRayHit<T>> cast_(BasicRay<T> const &ray) const noexcept {
+    if (empty())
+      return std::nullopt;
+    auto slabs = slabs_(ray);
+    auto tmax = ray.tmax;
+    auto best = std::optional<BasicRayHit<T>>{};
+    // Not initialized: only pushed entries are read
+    std::array<Entry, stack_size_> stack; // NOLINT
+    auto top = std::size_t{0};
+    stack[top++] = Entry{0, 0, ray.tmin};
+    while (top != 0) {
+      auto current = stack[--top];
+      if (current.t > tmax)
+        continue;
+      if (current.count != 0) {
+        auto const *block = leaves_.data() + current.first * block_;
+        auto coords = std::array<T const *, 9>{};
+        for (std::size_t k = 0; k < 9; ++k)
+          coords[k] = block + k * width;
+        auto hits =
+            details_::ray_hits<T, width>(ray, coords, current.count, tmax);
+        for (auto bits = hits.bits; bits != 0; bits &= bits - 1) {
+          auto lane = static_cast<std::size_t>(std::countr_zero(bits));
+          auto t = hits.t[lane];
+          if (t > tmax)
+            continue;
+          tmax = t;
+          best = BasicRayHit<T>{t, hits.u[lane], hits.v[lane],
+                                indices_[current.first * width + lane]};
+          if constexpr (Any)
+            return best;
+        }
+        continue;
+      }
+
+      auto const &node = nodes_[current.first];
+      auto [entries, bits] = enter_(node, slabs, ray.tmin, tmax);
+      // Children are pushed in the order of decreasing entry params, so
+      // the nearest one is popped first
+      auto base = top;
+      for (; bits != 0; bits &= bits - 1) {
+        auto slot = static_cast<std::size_t>(std::countr_zero(bits));
+        auto entry = Entry{node.first[slot], node.count[slot], entries[slot]};
+        auto k = top++;
+        assert(top <= stack.size());
+        if constexpr (!Any) {
+          for (; k != base && stack[k - 1].t < entry.t; --k)
+            stack[k] = stack[k - 1];
+        }
+        stack[k] = entry;
+      }
+    }
+    return best;
+  }
+
+  // Rays are cast in the coherent order. Gathering rays and scattering hits
+  // in it costs cache misses of its own, so the global order is used only
+  // when the tree is larger than caches and traversals miss them anyway.
+  // Otherwise only windows of consecutive rays are reordered.
+  template <typename F>
+  void cast_all_(std::span<BasicRay<T> const> rays, ThreadPool &pool,
+                 F const &cast) const {
+    if (empty()) {
+      for (std::size_t i = 0; i < rays.size(); ++i)
+        cast(i);
+      return;
+    }
+    constexpr std::size_t cache_bytes = 16 << 20;
+    constexpr std::size_t window = 4096;
+    auto bytes = nodes_.size() * sizeof(Node) + leaves_.size() * sizeof(T);
+    if (bytes > cache_bytes) {
+      auto order = details_::coherent_order<5>(rays, box_);
+      pool.parallel_for(
+          order.size(), window,
+          [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+            for (auto k = begin; k < end; ++k)
+              cast(order[k]);
+          });
+      return;
+    }
+    pool.parallel_for(
+        rays.size(), window,
+        [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+          for (; begin < end; begin += window) {
+            auto size = std::min(window, end - begin);
+            auto order =
+                details_::coherent_order<3>(rays.subspan(begin, size), box_);
+            for (auto k : order)
+              cast(begin + k);
+          }
+        });
+  }
+};
+
+using TriangleBvh = BasicTriangleBvh<double>;
+
+} // namespace cpp_contests
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+#include "geometry/simd.hpp"
+
+// Moller interval overlap test of triangles in floating point of the lane
+// type, which is certified by forward error bounds: signs of vertex distances
+// to the other plane are bounded as orient3d does, and interval ends by the
+// error of distances and of their own evaluation. It decides most pairs in a
+// few dozens of operations, the rest is reported uncertain and is left to the
+// exact test. Lanes of packs hold independent pairs, so the same code tests a
+// pair of float triangles in Pack<float, 1> and a triangle against a batch.
+
+namespace cpp_contests::details_ {
+
+template <typename P> struct PackPoint {
+  P x, y, z;
+
+  friend constexpr PackPoint operator-(PackPoint const &a,
+                                       PackPoint const &b) noexcept {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+  }
+};
+
+template <typename P>
+constexpr PackPoint<P> cross(PackPoint<P> const &a,
+                             PackPoint<P> const &b) noexcept {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+          a.x * b.y - a.y * b.x};
+}
+template <typename P>
+constexpr P dot(PackPoint<P> const &a, PackPoint<P> const &b) noexcept {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+// Lanes, where a and b have the same non-zero sign. Products of them would
+// underflow for tiny ones.
+template <typename P>
+constexpr typename P::mask_type same_sign(P const &a, P const &b) noexcept {
+  auto zero = P{0};
+  return ((a > zero) & (b > zero)) | ((a < zero) & (b < zero));
+}
+
+// Bound of the rounding error of dot(cross(a, b), c), which is a 3x3
+// determinant of differences, see det3_bound. Unlike there, products may
+// underflow, which is easy to meet in float: each of them is off by at most
+// half of the smallest subnormal then, and those of the cross product are
+// scaled by c. The smallest normal number is taken instead, which keeps
+// the bound itself off slow subnormal arithmetic.
+template <typename P>
+constexpr P det3_error(PackPoint<P> const &a, PackPoint<P> const &b,
+                       PackPoint<P> const &c) noexcept {
+  using T = typename P::value_type;
+  constexpr auto u = std::numeric_limits<T>::epsilon() / 2;
+  constexpr auto bound = (T{7} + T{56} * u) * u;
+  constexpr auto tiny = std::numeric_limits<T>::min();
+  auto permanent = abs(c.x) * (abs(a.y * b.z) + abs(a.z * b.y)) +
+                   abs(c.y) * (abs(a.z * b.x) + abs(a.x * b.z)) +
+                   abs(c.z) * (abs(a.x * b.y) + abs(a.y * b.x));
+  return P{bound} * permanent +
+         P{tiny} * (P{1} + abs(c.x) + abs(c.y) + abs(c.z));
+}
+
+// Interval on the planes intersection line, cut by a triangle, which vertices
+// have projections p and signed distances d to the other plane, computed
+// with errors below e. All signs of d are certified and exactly one of them
+// differs. Returns the interval ends and a bound of their errors.
+template <typename P>
+constexpr std::array<P, 3> interval(std::array<P, 3> const &p,
+                                    std::array<P, 3> const &d,
+                                    std::array<P, 3> const &e) noexcept {
+  using T = typename P::value_type;
+  constexpr auto u = std::numeric_limits<T>::epsilon() / 2;
+  auto lone2 = same_sign(d[0], d[1]);
+  auto lone1 = ~lone2 & same_sign(d[0], d[2]);
+  auto pick = [&](std::array<P, 3> const &x, std::size_t i2, std::size_t i1,
+                  std::size_t i0) {
+    return select(lone2, x[i2], select(lone1, x[i1], x[i0]));
+  };
+  auto a = pick(p, 2, 1, 0);
+  auto da = pick(d, 2, 1, 0);
+  auto ea = pick(e, 2, 1, 0);
+  // Point of the edge from a to b on the other plane is a + (b - a) t with
+  // t = da / (da - db). da and db have opposite signs, so t is in [0, 1] and
+  // moving them by ea and eb moves t by at most (ea + eb) / (|da| + |db| -
+  // ea - eb). Rounding adds a few units of roundoff of |b - a| and of |a| +
+  // |b| and the product may underflow. Constants are doubled to cover
+  // rounding of the bound itself.
+  auto end = [&](P const &b, P const &db, P const &eb) {
+    constexpr auto tiny = std::numeric_limits<T>::min();
+    auto dt = P{2} * (ea + eb) / ((abs(da) - ea) + (abs(db) - eb));
+    auto ab = b - a;
+    return std::array{a + ab * da / (da - db),
+                      abs(ab) * (dt + P{8 * u}) +
+                          P{4 * u} * (abs(a) + abs(b)) + P{tiny}};
+  };
+  auto [i0, e0] = end(pick(p, 0, 0, 1), pick(d, 0, 0, 1), pick(e, 0, 0, 1));
+  auto [i1, e1] = end(pick(p, 1, 2, 2), pick(d, 1, 2, 2), pick(e, 1, 2, 2));
+  return {min(i0, i1), max(i0, i1), max(e0, e1)};
+}
+
+// Signed distances of vertices of a triangle to the plane of another one,
+// scaled by the length of its normal, with bounds of their errors
+template <typename P> struct PlaneDistances {
+  std::array<P, 3> d;
+  std::array<P, 3> e;
+  PackPoint<P> normal;
+  // Lanes, where all signs of d are certified
+  typename P::mask_type certain;
+
+  // Lanes, where the triangle certainly lies on one side of the plane
+  [[nodiscard]] constexpr typename P::mask_type separated() const noexcept {
+    return certain & same_sign(d[0], d[1]) & same_sign(d[0], d[2]);
+  }
+};
+
+// Distances of vertices of t to the plane of other
+template <typename P>
+constexpr PlaneDistances<P>
+plane_distances(std::array<PackPoint<P>, 3> const &t,
+                std::array<PackPoint<P>, 3> const &other) noexcept {
+  auto e1 = other[1] - other[0];
+  auto e2 = other[2] - other[0];
+  auto result = PlaneDistances<P>{};
+  result.normal = cross(e1, e2);
+  result.certain = typename P::mask_type{true};
+  for (std::size_t i = 0; i < 3; ++i) {
+    auto r = t[i] - other[0];
+    result.d[i] = dot(result.normal, r);
+    result.e[i] = det3_error(e1, e2, r);
+    result.certain = result.certain & (abs(result.d[i]) > result.e[i]);
+  }
+  return result;
+}
+
+template <typename P> struct FilteredIntersects {
+  // Lanes, where triangles certainly intersect
+  typename P::mask_type hits;
+  // Lanes, where nothing is certified
+  typename P::mask_type uncertain;
+};
+
+// Interval overlap of triangles u and v, which distances to the planes of
+// each other are du and dv, in lanes, where neither is separated from the
+// plane of the other
+template <typename P>
+constexpr FilteredIntersects<P>
+filtered_overlap(std::array<PackPoint<P>, 3> const &u,
+                 std::array<PackPoint<P>, 3> const &v,
+                 PlaneDistances<P> const &du,
+                 PlaneDistances<P> const &dv) noexcept {
+  // Project both triangles onto the dominant axis of the line of planes
+  // intersection. Any axis, which the line is not orthogonal to, orders
+  // points of the line, and if the line is orthogonal to the chosen one,
+  // all interval ends are equal, so their comparisons are not certified.
+  auto dir = cross(dv.normal, du.normal);
+  auto ax = abs(dir.x);
+  auto ay = abs(dir.y);
+  auto az = abs(dir.z);
+  auto use_x = (ax >= ay) & (ax >= az);
+  auto use_y = ~use_x & (ay >= az);
+  auto project = [&](PackPoint<P> const &p) {
+    return select(use_x, p.x, select(use_y, p.y, p.z));
+  };
+
+  auto i1 = interval(
+      std::array<P, 3>{project(u[0]), project(u[1]), project(u[2])}, du.d,
+      du.e);
+  auto i2 = interval(
+      std::array<P, 3>{project(v[0]), project(v[1]), project(v[2])}, dv.d,
+      dv.e);
+  auto overlap = ~((i1[1] < i2[0]) | (i2[1] < i1[0]));
+  auto error = P{2} * (i1[2] + i2[2]);
+  auto certain = du.certain & dv.certain &
+                 (abs(i1[1] - i2[0]) > error) & (abs(i2[1] - i1[0]) > error);
+  return {overlap & certain, ~certain};
+}
+
+// The whole test without branches, for all lanes at once
+template <typename P>
+constexpr FilteredIntersects<P>
+filtered_intersects(std::array<PackPoint<P>, 3> const &u,
+                    std::array<PackPoint<P>, 3> const &v) noexcept {
+  auto du = plane_distances(u, v);
+  auto dv = plane_distances(v, u);
+  auto separated = du.separated() | dv.separated();
+  auto [hits, uncertain] = filtered_overlap(u, v, du, dv);
+  return {~separated & hits, ~separated & uncertain};
+}
+
+} // namespace cpp_contests::details_
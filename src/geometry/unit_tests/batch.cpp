@@ -0,0 +1,129 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Matrix // NOLINT
+#define _CRT_SECURE_NO_WARNINGS  // NOLINT
+
+#include <cmath>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/batch.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+template <std::size_t X, std::size_t Y, typename T>
+std::vector<Matrix<X, Y, T>> random_matrices(std::size_t n,
+                                             std::mt19937 &gen) {
+  auto coord = std::uniform_real_distribution<T>{-1.0, 1.0};
+  auto result = std::vector<Matrix<X, Y, T>>(n);
+  for (auto &m : result) {
+    for (std::size_t i = 0; i < X * Y; ++i)
+      m[i] = coord(gen);
+  }
+  return result;
+}
+
+template <std::size_t X, std::size_t Y, typename T>
+T max_diff(std::vector<Matrix<X, Y, T>> const &a,
+           std::vector<Matrix<X, Y, T>> const &b) {
+  auto diff = T{0};
+  for (std::size_t i = 0; i < a.size(); ++i)
+    diff = std::max(diff, n(a[i] - b[i]));
+  return diff;
+}
+
+// Sizes cover tails of packs and the parallel path
+template <typename T> void batch_check(ThreadPool &pool) {
+  auto gen = std::mt19937{0};
+  for (std::size_t size : {1U, 7U, 33U, 70001U}) {
+    auto m3 = random_matrices<3, 3, T>(size, gen);
+    auto v3 = random_matrices<1, 3, T>(size, gen);
+    auto w3 = random_matrices<1, 3, T>(size, gen);
+    auto m2 = random_matrices<2, 2, T>(size, gen);
+    auto m4 = random_matrices<4, 4, T>(size, gen);
+    auto a = std::span<Matrix<3, 3, T> const>{m3};
+    auto b = std::span<Vector<3, T> const>{v3};
+    auto c = std::span<Vector<3, T> const>{w3};
+
+    auto mv = std::vector<Vector<3, T>>(size);
+    multiply(a, b, std::span<Vector<3, T>>{mv}, pool);
+    auto mm = std::vector<Matrix<3, 3, T>>(size);
+    multiply(a, a, std::span<Matrix<3, 3, T>>{mm}, pool);
+    auto bv = std::vector<Vector<3, T>>(size);
+    multiply(m3.front(), b, std::span<Vector<3, T>>{bv}, pool);
+    auto cr = std::vector<Vector<3, T>>(size);
+    cross(b, c, std::span<Vector<3, T>>{cr}, pool);
+    auto dt = std::vector<T>(size);
+    dot(b, c, std::span<T>{dt}, pool);
+
+    auto expected_mv = std::vector<Vector<3, T>>{};
+    auto expected_mm = std::vector<Matrix<3, 3, T>>{};
+    auto expected_bv = std::vector<Vector<3, T>>{};
+    auto expected_cr = std::vector<Vector<3, T>>{};
+    auto dot_diff = T{0};
+    for (std::size_t i = 0; i < size; ++i) {
+      expected_mv.push_back(m3[i] * v3[i]);
+      expected_mm.push_back(m3[i] * m3[i]);
+      expected_bv.push_back(m3.front() * v3[i]);
+      expected_cr.push_back(cross(v3[i], w3[i]));
+      dot_diff = std::max(dot_diff, std::abs(dt[i] - dot(v3[i], w3[i])));
+    }
+    constexpr auto eps = std::is_same_v<T, float> ? T{1e-5} : T{1e-12};
+    BOOST_TEST(max_diff(mv, expected_mv) < eps);
+    BOOST_TEST(max_diff(mm, expected_mm) < eps);
+    BOOST_TEST(max_diff(bv, expected_bv) < eps);
+    BOOST_TEST(max_diff(cr, expected_cr) < eps);
+    BOOST_TEST(dot_diff < eps);
+
+    auto d3 = std::vector<T>(size);
+    det(a, std::span<T>{d3}, pool);
+    auto d2 = std::vector<T>(size);
+    det(std::span<Matrix<2, 2, T> const>{m2}, std::span<T>{d2}, pool);
+    auto d4 = std::vector<T>(size);
+    det(std::span<Matrix<4, 4, T> const>{m4}, std::span<T>{d4}, pool);
+    auto i3 = std::vector<Matrix<3, 3, T>>(size);
+    inv(a, std::span<Matrix<3, 3, T>>{i3}, pool);
+    auto i2 = std::vector<Matrix<2, 2, T>>(size);
+    inv(std::span<Matrix<2, 2, T> const>{m2},
+        std::span<Matrix<2, 2, T>>{i2}, pool);
+    auto det_diff = T{0};
+    // Random matrices may be close to singular, so inverses are checked
+    // relative to the condition
+    auto inv_diff = T{0};
+    for (std::size_t i = 0; i < size; ++i) {
+      det_diff = std::max({det_diff, std::abs(d3[i] - det(m3[i])),
+                           std::abs(d2[i] - det(m2[i])),
+                           std::abs(d4[i] - det(m4[i]))});
+      inv_diff = std::max(
+          {inv_diff,
+           n(m3[i] * i3[i] - eye<3, 3, T>()) / (n(m3[i]) * n(i3[i])),
+           n(m2[i] * i2[i] - eye<2, 2, T>()) / (n(m2[i]) * n(i2[i]))});
+    }
+    BOOST_TEST(det_diff < eps);
+    BOOST_TEST(inv_diff < eps);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(batch_test) {
+  auto pool = ThreadPool{4};
+  batch_check<double>(pool);
+  batch_check<float>(pool);
+
+  constexpr Matrix<2, 2, double> singular{{1.0, 2.0}, {2.0, 4.0}};
+  auto matrices = std::vector<Matrix<2, 2, double>>{singular};
+  auto inverses = std::vector<Matrix<2, 2, double>>(1);
+  inv(std::span<Matrix<2, 2, double> const>{matrices},
+      std::span<Matrix<2, 2, double>>{inverses});
+  BOOST_TEST(!std::isfinite(inverses.front()[0]));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
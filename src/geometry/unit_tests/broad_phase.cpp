@@ -0,0 +1,144 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE BroadPhase // NOLINT
+#define _CRT_SECURE_NO_WARNINGS      // NOLINT
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/narrow_phase.hpp"
+#include "geometry/sweep_and_prune.hpp"
+#include "geometry/triangle.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+using cpp_contests::testing::random_triangles;
+
+namespace {
+
+// Triangles of the given size in the cube [0, side)^3
+testing::TriangleOptions scene(double side, double size) {
+  return {.lo = 0.0, .hi = side, .size = size, .min_area = size * size * 1e-3};
+}
+
+std::vector<IndexPair> brute_force_pairs(std::vector<Triangle> const &ts) {
+  auto result = std::vector<IndexPair>{};
+  for (std::size_t i = 0; i < ts.size(); ++i) {
+    for (std::size_t j = i + 1; j < ts.size(); ++j) {
+      if (overlaps(bounding_box(ts[i]), bounding_box(ts[j])))
+        result.emplace_back(i, j);
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(box_test) {
+  constexpr Triangle t(Point{0.0, 0.0, 0.0}, Point{1.0, 2.0, 0.0},
+                       Point{-1.0, 1.0, 3.0});
+  constexpr auto box = bounding_box(t);
+  static_assert(box.min[0] == -1.0 && box.min[1] == 0.0 && box.min[2] == 0.0);
+  static_assert(box.max[0] == 1.0 && box.max[1] == 2.0 && box.max[2] == 3.0);
+
+  constexpr Box touching{Point{1.0, 2.0, 3.0}, Point{2.0, 3.0, 4.0}};
+  constexpr Box apart{Point{1.0, 2.0, 3.1}, Point{2.0, 3.0, 4.0}};
+  static_assert(overlaps(box, touching));
+  static_assert(!overlaps(box, apart));
+}
+
+BOOST_AUTO_TEST_CASE(sweep_test) {
+  auto gen = std::mt19937{0};
+  constexpr std::size_t N = 300;
+  auto triangles = random_triangles(N, gen, scene(10.0, 0.7));
+  auto boxes = std::vector<Box>{};
+  for (auto const &t : triangles)
+    boxes.push_back(bounding_box(t));
+
+  auto pairs = std::vector<IndexPair>{};
+  sweep(boxes,
+        [&](std::size_t i, std::size_t j) { pairs.emplace_back(i, j); });
+  std::sort(pairs.begin(), pairs.end());
+  BOOST_TEST((pairs == brute_force_pairs(triangles)));
+}
+
+BOOST_AUTO_TEST_CASE(sweep_and_prune_incremental_test) {
+  auto gen = std::mt19937{1};
+  constexpr std::size_t N = 300;
+  constexpr std::size_t Frames = 20;
+  auto triangles = random_triangles(N, gen, scene(10.0, 0.7));
+  auto sap = SweepAndPrune(triangles);
+  auto pairs = brute_force_pairs(triangles);
+  BOOST_TEST((sap.pairs() == pairs));
+
+  auto shift = std::uniform_real_distribution<double>{-0.05, 0.05};
+  for (std::size_t frame = 0; frame < Frames; ++frame) {
+    for (auto &t : triangles) {
+      auto delta = Point{shift(gen), shift(gen), shift(gen)};
+      t = Triangle(t[0] + delta, t[1] + delta, t[2] + delta);
+    }
+    auto changes = sap.update(triangles);
+    auto new_pairs = brute_force_pairs(triangles);
+    BOOST_TEST((sap.pairs() == new_pairs));
+
+    auto added = std::vector<IndexPair>{};
+    auto removed = std::vector<IndexPair>{};
+    std::set_difference(new_pairs.begin(), new_pairs.end(), pairs.begin(),
+                        pairs.end(), std::back_inserter(added));
+    std::set_difference(pairs.begin(), pairs.end(), new_pairs.begin(),
+                        new_pairs.end(), std::back_inserter(removed));
+    BOOST_TEST((changes.added == added));
+    BOOST_TEST((changes.removed == removed));
+    pairs = std::move(new_pairs);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(narrow_phase_test) {
+  auto gen = std::mt19937{2};
+  constexpr std::size_t N = 200;
+  auto triangles = random_triangles(N, gen, scene(5.0, 0.7));
+  auto sap = SweepAndPrune(triangles);
+
+  auto reference = std::vector<IndexPair>{};
+  for (std::size_t i = 0; i < N; ++i) {
+    for (std::size_t j = i + 1; j < N; ++j) {
+      if (intersects(triangles[i], triangles[j]))
+        reference.emplace_back(i, j);
+    }
+  }
+  BOOST_TEST(!reference.empty());
+  BOOST_TEST((intersecting_pairs(sap, triangles) == reference));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_narrow_phase_test) {
+  auto gen = std::mt19937{3};
+  constexpr std::size_t N = 2000;
+  auto triangles = random_triangles(N, gen, scene(10.0, 0.5));
+  auto sap = SweepAndPrune(triangles);
+  auto candidates = sap.pairs();
+
+  auto reference = std::vector<std::size_t>{};
+  for (auto const &[i, j] : intersecting_pairs(candidates, triangles)) {
+    reference.push_back(i);
+    reference.push_back(j);
+  }
+  std::sort(reference.begin(), reference.end());
+  reference.erase(std::unique(reference.begin(), reference.end()),
+                  reference.end());
+  BOOST_TEST(!reference.empty());
+
+  for (std::size_t nthreads : {1, 3, 8}) {
+    auto pool = ThreadPool{nthreads};
+    BOOST_TEST((intersected_triangles(candidates, triangles, pool) ==
+                reference));
+  }
+  BOOST_TEST(intersected_triangles({}, triangles).empty());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,185 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Distance // NOLINT
+#define _CRT_SECURE_NO_WARNINGS    // NOLINT
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/distance.hpp"
+#include "geometry/triangle_bvh.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+// Triangles of the scene, which is the cube [0, 10)^3
+constexpr auto scene = testing::TriangleOptions{
+    .lo = 0.0, .hi = 10.0, .size = 1.0, .min_area = 1e-2};
+
+// Points of the triangle on a barycentric grid, edges and vertices included
+std::vector<Point> samples(Triangle const &t) {
+  constexpr int steps = 24;
+  auto result = std::vector<Point>{};
+  for (int i = 0; i <= steps; ++i) {
+    for (int j = 0; i + j <= steps; ++j) {
+      auto u = static_cast<double>(i) / steps;
+      auto v = static_cast<double>(j) / steps;
+      result.emplace_back(t[0] + u * (t[1] - t[0]) + v * (t[2] - t[0]));
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(primitive_distance_test) {
+  auto const tol = boost::test_tools::tolerance(1e-12);
+  auto segment = Segment{Point{-1.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0}};
+  BOOST_TEST(dist(Point{0.5, 1.0, 0.0}, segment) == 1.0, tol);
+  BOOST_TEST(dist(Point{3.0, 0.0, 0.0}, segment) == 2.0, tol);
+  BOOST_TEST(dist(Point{0.0, 3.0, 4.0},
+                  Segment{Point{0.0, 0.0, 0.0}, Point{0.0, 0.0, 0.0}}) == 5.0,
+             tol);
+
+  // Skew segments crossing in projection, parallel and collinear ones
+  auto skew = Segment{Point{0.0, -1.0, 1.0}, Point{0.0, 1.0, 1.0}};
+  auto [p1, p2] = closest_points(segment, skew);
+  BOOST_TEST(dist(p1, Point{0.0, 0.0, 0.0}) == 0.0, tol);
+  BOOST_TEST(dist(p2, Point{0.0, 0.0, 1.0}) == 0.0, tol);
+  BOOST_TEST(dist(segment, Segment{Point{0.0, 2.0, 0.0},
+                                   Point{5.0, 2.0, 0.0}}) == 2.0,
+             tol);
+  BOOST_TEST(dist(segment, Segment{Point{4.0, 0.0, 0.0},
+                                   Point{2.0, 0.0, 0.0}}) == 1.0,
+             tol);
+  BOOST_TEST(dist(segment, Segment{Point{2.0, 2.0, 0.0},
+                                   Point{2.0, 5.0, 0.0}}) == std::sqrt(5.0),
+             tol);
+
+  // Regions of the face, an edge and a vertex
+  auto t = Triangle(Point{0.0, 0.0, 0.0}, Point{4.0, 0.0, 0.0},
+                    Point{0.0, 4.0, 0.0});
+  BOOST_TEST(dist(Point{1.0, 1.0, 3.0}, t) == 3.0, tol);
+  BOOST_TEST(dist(closest_point(Point{3.0, 3.0, 0.0}, t),
+                  Point{2.0, 2.0, 0.0}) == 0.0,
+             tol);
+  BOOST_TEST(dist(Point{-3.0, -4.0, 0.0}, t) == 5.0, tol);
+
+  // Crossing triangles, a parallel one above and an edge facing a face
+  auto crossing = Triangle(Point{1.0, 1.0, -1.0}, Point{1.0, 1.0, 1.0},
+                           Point{5.0, 5.0, 0.0});
+  BOOST_TEST(dist(t, crossing) == 0.0);
+  auto above = Triangle(Point{0.0, 0.0, 2.0}, Point{1.0, 0.0, 2.0},
+                        Point{0.0, 1.0, 2.0});
+  BOOST_TEST(dist(t, above) == 2.0, tol);
+  auto edge = Triangle(Point{1.0, 1.0, 1.0}, Point{2.0, 1.0, 1.0},
+                       Point{1.5, 1.0, 3.0});
+  BOOST_TEST(dist(edge, t) == 1.0, tol);
+}
+
+BOOST_AUTO_TEST_CASE(random_distance_test) {
+  auto gen = std::mt19937{0};
+  auto ts = testing::random_triangles<double>(60, gen, scene);
+  auto coord = std::uniform_real_distribution<double>{-2.0, 12.0};
+  auto mismatches = std::size_t{0};
+  for (std::size_t i = 0; i + 1 < ts.size(); i += 2) {
+    auto const &t1 = ts[i];
+    auto const &t2 = ts[i + 1];
+    // Closest points lie on triangles and no sampled pair is closer
+    auto [p1, p2] = closest_points(t1, t2);
+    auto d = dist(t1, t2);
+    if (dist(p1, t1) > 1e-9 || dist(p2, t2) > 1e-9)
+      ++mismatches;
+    if (!intersects(t1, t2) && std::abs(d - dist(p1, p2)) > 1e-12)
+      ++mismatches;
+    auto sampled = std::numeric_limits<double>::infinity();
+    for (auto const &s : samples(t1))
+      sampled = std::min(sampled, dist(s, t2));
+    if (d > sampled + 1e-9)
+      ++mismatches;
+
+    auto p = Point{coord(gen), coord(gen), coord(gen)};
+    auto q = closest_point(p, t1);
+    auto nearest = std::numeric_limits<double>::infinity();
+    for (auto const &s : samples(t1))
+      nearest = std::min(nearest, dist(p, s));
+    if (dist(q, t1) > 1e-9 || dist(p, q) > nearest + 1e-9)
+      ++mismatches;
+  }
+  BOOST_TEST(mismatches == 0U);
+}
+
+namespace {
+
+template <typename T> void nearest_check(ThreadPool &pool) {
+  auto gen = std::mt19937{1};
+  auto ts = testing::random_triangles<T>(2000, gen, scene);
+  auto bvh = BasicTriangleBvh<T>(std::span<BasicTriangle<T> const>{ts});
+  auto coord = std::uniform_real_distribution<T>{-2.0, 12.0};
+  auto points = std::vector<BasicPoint<T>>{};
+  for (std::size_t i = 0; i < 500; ++i)
+    points.push_back(BasicPoint<T>{coord(gen), coord(gen), coord(gen)});
+
+  constexpr auto eps = std::is_same_v<T, float> ? T{1e-4} : T{1e-12};
+  constexpr auto bound = T{0.5};
+  auto mismatches = std::size_t{0};
+  auto within = std::size_t{0};
+  for (auto const &p : points) {
+    auto expected = std::numeric_limits<T>::infinity();
+    for (auto const &t : ts)
+      expected = std::min(expected, dist(p, t));
+    auto found = bvh.nearest_point(p);
+    if (!found || std::abs(found->distance - expected) > eps ||
+        std::abs(dist(p, ts[found->triangle]) - expected) > eps ||
+        std::abs(dist(p, found->point) - expected) > eps) {
+      ++mismatches;
+      continue;
+    }
+    // Bounded queries find the same point or nothing farther than the bound
+    auto bounded = bvh.nearest_point(p, bound);
+    within += bounded.has_value();
+    if (bounded.has_value() != (found->distance <= bound) ||
+        (bounded && bounded->distance != found->distance))
+      ++mismatches;
+  }
+  BOOST_TEST(within > 0U);
+  BOOST_TEST(within < points.size());
+  BOOST_TEST(mismatches == 0U);
+
+  auto nearest = std::vector<std::optional<BasicNearestPoint<T>>>(
+      points.size());
+  bvh.nearest_points(
+      std::span<BasicPoint<T> const>{points},
+      std::span<std::optional<BasicNearestPoint<T>>>{nearest}, bound, pool);
+  auto batch_mismatches = std::size_t{0};
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    auto single = bvh.nearest_point(points[i], bound);
+    if (single.has_value() != nearest[i].has_value() ||
+        (single && single->triangle != nearest[i]->triangle))
+      ++batch_mismatches;
+  }
+  BOOST_TEST(batch_mismatches == 0U);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(nearest_point_test) {
+  auto pool = ThreadPool{4};
+  nearest_check<double>(pool);
+  nearest_check<float>(pool);
+  BOOST_TEST(!TriangleBvh{}.nearest_point(Point{0.0, 0.0, 0.0}));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,116 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Matrix // NOLINT
+#define _CRT_SECURE_NO_WARNINGS  // NOLINT
+
+#include <cstdint>
+#include <random>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/dynamic_matrix.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+DynamicMatrix<double> random_matrix(std::size_t x, std::size_t y,
+                                    std::mt19937 &gen) {
+  auto coord = std::uniform_real_distribution<double>{-1.0, 1.0};
+  auto m = DynamicMatrix<double>(x, y);
+  for (std::size_t j = 0; j < y; ++j) {
+    for (std::size_t i = 0; i < x; ++i)
+      m[i, j] = coord(gen);
+  }
+  return m;
+}
+
+// Straightforward product to check blocked kernels against
+DynamicMatrix<double> naive_product(DynamicMatrix<double> const &a,
+                                    DynamicMatrix<double> const &b) {
+  auto c = DynamicMatrix<double>(b.size_x(), a.size_y());
+  for (std::size_t y = 0; y < a.size_y(); ++y) {
+    for (std::size_t z = 0; z < b.size_x(); ++z) {
+      for (std::size_t k = 0; k < a.size_x(); ++k)
+        c[z, y] += a[k, y] * b[z, k];
+    }
+  }
+  return c;
+}
+
+double max_diff(DynamicMatrix<double> const &a,
+                DynamicMatrix<double> const &b) {
+  auto diff = 0.0;
+  for (std::size_t y = 0; y < a.size_y(); ++y) {
+    for (std::size_t x = 0; x < a.size_x(); ++x)
+      diff = std::max(diff, std::abs(a[x, y] - b[x, y]));
+  }
+  return diff;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(dynamic_matrix_layout_test) {
+  auto m = DynamicMatrix<double>(3, 5, 1.0);
+  BOOST_TEST(m.size_x() == 3U);
+  BOOST_TEST(m.size_y() == 5U);
+  BOOST_TEST(m.ld() == 8U);
+  for (std::size_t y = 0; y < m.size_y(); ++y) {
+    auto address = reinterpret_cast<std::uintptr_t>(m.row(y).data()); // NOLINT
+    BOOST_TEST(address % DynamicMatrix<double>::alignment == 0U);
+  }
+
+  constexpr Matrix<3, 2, int> fixed{{1, 2, 3}, {4, 5, 6}};
+  auto d = DynamicMatrix<int>{fixed};
+  BOOST_TEST((d[2, 1] == 6));
+  BOOST_TEST((d.fixed<3, 2>() == fixed));
+  BOOST_TEST((t(d).fixed<2, 3>() == t(fixed)));
+  BOOST_TEST((DynamicMatrix<int>{fixed + fixed} == d * 2));
+  BOOST_TEST(((-d + d) == DynamicMatrix<int>(3, 2)));
+  BOOST_TEST(dot(d, d) == 91);
+}
+
+BOOST_AUTO_TEST_CASE(dynamic_matrix_mult_test) {
+  auto gen = std::mt19937{0};
+  auto pool = ThreadPool{4};
+  // Sizes cover register tile tails, cache blocks and the parallel path
+  for (auto [x, y, z] : {std::array<std::size_t, 3>{1, 1, 1},
+                         {3, 5, 7},
+                         {17, 9, 33},
+                         {300, 70, 530},
+                         {64, 128, 64}}) {
+    auto a = random_matrix(x, y, gen);
+    auto b = random_matrix(z, x, gen);
+    auto expected = naive_product(a, b);
+    BOOST_TEST(max_diff(a * b, expected) < 1e-12 * static_cast<double>(x));
+    BOOST_TEST(max_diff(multiply(a, b, pool), expected) <
+               1e-12 * static_cast<double>(x));
+  }
+
+  constexpr Matrix<2, 2, double> fixed{{1.0, 2.0}, {3.0, 4.0}};
+  auto d = DynamicMatrix<double>{fixed};
+  auto expected = DynamicMatrix<double>{fixed * fixed};
+  BOOST_TEST(max_diff(d * fixed, expected) == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(dynamic_matrix_solve_test) {
+  auto gen = std::mt19937{1};
+  auto pool = ThreadPool{4};
+  for (std::size_t size : {1U, 2U, 5U, 40U, 300U}) {
+    auto a = random_matrix(size, size, gen);
+    auto b = random_matrix(3, size, gen);
+    auto x = solve(lu(a, pool), b);
+    BOOST_TEST(max_diff(a * x, b) < 1e-9);
+    auto ai = inv(a);
+    BOOST_TEST(max_diff(a * ai, dynamic_eye<double>(size)) < 1e-9);
+  }
+
+  constexpr Matrix<3, 3, double> fixed{
+      {2.0, -1.0, 0.5}, {1.0, 3.0, -2.0}, {0.0, 4.0, 1.0}};
+  BOOST_TEST(std::abs(det(DynamicMatrix<double>{fixed}) - det(fixed)) < 1e-12);
+  BOOST_TEST(det(DynamicMatrix<double>(4, 4, 1.0)) == 0.0);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,124 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE IO    // NOLINT
+#define _CRT_SECURE_NO_WARNINGS // NOLINT
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/io.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+template <typename T>
+bool same(TriangleBatch<T> const &batch, std::vector<Triangle> const &ts) {
+  if (batch.size() != ts.size())
+    return false;
+  for (std::size_t i = 0; i < ts.size(); ++i) {
+    for (std::size_t v = 0; v < 3; ++v) {
+      for (std::size_t c = 0; c < 3; ++c) {
+        if (batch.coord(v, c)[i] != static_cast<T>(ts[i][v][c]))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::filesystem::path temp_path(std::string const &name) {
+  return std::filesystem::temp_directory_path() / ("cpp_contests_io_" + name);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(text_test) {
+  auto batch = parse_text_mesh("2\n0 0 0 1 0 0 0 1 0\n"
+                               "-1.5 2e-3 3  4 5 6\t7 8 9.25\r\n");
+  BOOST_TEST(batch.size() == 2U);
+  BOOST_TEST(batch.coord(0, 0)[1] == -1.5);
+  BOOST_TEST(batch.coord(0, 1)[1] == 2e-3);
+  BOOST_TEST(batch.coord(2, 2)[1] == 9.25);
+  BOOST_TEST(batch.coord(1, 0)[0] == 1.0);
+
+  BOOST_CHECK_THROW(parse_text_mesh("2\n0 0 0 1 0 0 0 1 0\n"),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(parse_text_mesh("1\n0 0 0 1 0 x 0 1 0\n"),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(parse_text_mesh("1000000 0"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(file_test) {
+  auto gen = std::mt19937{0};
+  auto triangles = testing::random_triangles(
+      1000, gen, {.lo = -5.0, .hi = 5.0, .size = 5.0});
+
+  auto text_path = temp_path("mesh.txt");
+  {
+    auto output = std::ofstream{text_path};
+    output.precision(17);
+    output << triangles.size() << "\n";
+    for (auto const &t : triangles) {
+      for (std::size_t v = 0; v < 3; ++v)
+        output << t[v][0] << " " << t[v][1] << " " << t[v][2] << " ";
+      output << "\n";
+    }
+  }
+  BOOST_TEST(same(load_mesh(text_path), triangles));
+
+  auto f64_path = temp_path("mesh.f64");
+  save_raw_mesh<double>(f64_path, triangles);
+  BOOST_TEST(same(load_mesh(f64_path), triangles));
+  BOOST_TEST(same(load_mesh<float>(f64_path), triangles));
+
+  auto f32_path = temp_path("mesh.f32");
+  save_raw_mesh<float>(f32_path, triangles);
+  BOOST_TEST(same(load_mesh<float>(f32_path), triangles));
+  BOOST_TEST(load_mesh(f32_path, MeshFormat::float64).size() ==
+             triangles.size() / 2);
+
+  // Binary STL: 80 bytes header, count, then normal, vertices and attribute
+  auto stl_path = temp_path("mesh.stl");
+  {
+    auto output = std::ofstream{stl_path, std::ios::binary};
+    auto header = std::array<char, 80>{};
+    output.write(header.data(), header.size());
+    auto count = static_cast<std::uint32_t>(triangles.size());
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+    output.write(reinterpret_cast<char const *>(&count), sizeof(count));
+    for (auto const &t : triangles) {
+      auto record = std::array<float, 12>{};
+      for (std::size_t v = 0; v < 3; ++v) {
+        for (std::size_t c = 0; c < 3; ++c)
+          record[3 + 3 * v + c] = static_cast<float>(t[v][c]);
+      }
+      auto attribute = std::uint16_t{0};
+      output.write(reinterpret_cast<char const *>(record.data()),
+                   sizeof(record));
+      output.write(reinterpret_cast<char const *>(&attribute),
+                   sizeof(attribute));
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+  }
+  BOOST_TEST(same(load_mesh<float>(stl_path), triangles));
+
+  auto empty_path = temp_path("empty.f64");
+  { auto output = std::ofstream{empty_path}; }
+  BOOST_TEST(load_mesh(empty_path).empty());
+  BOOST_CHECK_THROW(load_mesh(temp_path("missing.f64")), std::system_error);
+
+  for (auto const &path : {text_path, f64_path, f32_path, stl_path, empty_path})
+    std::filesystem::remove(path);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,93 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Morton // NOLINT
+#define _CRT_SECURE_NO_WARNINGS  // NOLINT
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/morton.hpp"
+
+using namespace cpp_contests;
+
+BOOST_AUTO_TEST_CASE(morton_code_test) {
+  static_assert(details_::spread_bits(0b1011U) == 0b1000001001U);
+  static_assert(details_::spread_bits(0x1FFFFFU) == 0x1249249249249249U);
+  // Cells of the box are unit ones
+  constexpr auto side = static_cast<double>((1U << 21U) - 1);
+  constexpr auto box = Box{Point{0.0, 0.0, 0.0}, Point{side, side, side}};
+  static_assert(morton_code(Point{0.0, 0.0, 0.0}, box) == 0U);
+  static_assert(morton_code(Point{side, side, side}, box) ==
+                0x7FFFFFFFFFFFFFFFU);
+  static_assert(morton_code(Point{1.0, 0.0, 0.0}, box) == 1U);
+  static_assert(morton_code(Point{0.0, 1.0, 0.0}, box) == 2U);
+  static_assert(morton_code(Point{0.0, 0.0, 1.0}, box) == 4U);
+  static_assert(morton_code(Point{2.0, 1.0, 0.0}, box) == 0b1010U);
+  static_assert(morton_code(Point{0.0, 0.0, 1U << 20U}, box) ==
+                std::uint64_t{1} << 62U);
+  // Points outside are clamped, flat boxes give zero coordinates
+  static_assert(morton_code(Point{-1.0, 2 * side, 0.0}, box) ==
+                morton_code(Point{0.0, side, 0.0}, box));
+  constexpr auto flat = Box{Point{0.0, 0.0, 0.0}, Point{1.0, 1.0, 0.0}};
+  static_assert(morton_code(Point{0.0, 0.0, 5.0}, flat) == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(morton_order_test) {
+  auto gen = std::mt19937{0};
+  auto coord = std::uniform_real_distribution<double>{0.0, 100.0};
+  auto triangles = std::vector<Triangle>{};
+  for (std::size_t i = 0; i < 1000; ++i) {
+    auto p = Point{coord(gen), coord(gen), coord(gen)};
+    triangles.emplace_back(p, p + Point{1.0, 0.0, 0.0},
+                           p + Point{0.0, 1.0, 0.0});
+  }
+  auto span = std::span<Triangle const>{triangles};
+  auto sorted = morton_sorted(span);
+  BOOST_TEST_REQUIRE(sorted.triangles.size() == triangles.size());
+  auto seen = std::vector<std::uint32_t>(sorted.original);
+  std::ranges::sort(seen);
+  auto unique = std::ranges::adjacent_find(seen) == seen.end();
+  BOOST_TEST(unique);
+  BOOST_TEST(seen.back() == triangles.size() - 1);
+
+  // Triangles are copies of input ones along the curve through centroids
+  auto centroid = [](Triangle const &t) {
+    return Point{(t[0] + t[1] + t[2]) / 3.0};
+  };
+  auto box = Box{centroid(triangles[0]), centroid(triangles[0])};
+  for (auto const &t : triangles) {
+    auto c = centroid(t);
+    for (std::size_t i = 0; i < 3; ++i) {
+      box.min[i] = std::min(box.min[i], c[i]);
+      box.max[i] = std::max(box.max[i], c[i]);
+    }
+  }
+  auto ordered = true;
+  auto copied = true;
+  for (std::size_t k = 0; k < triangles.size(); ++k) {
+    auto const &t = sorted.triangles[k];
+    copied = copied && dist(t[0], triangles[sorted.original[k]][0]) == 0.0;
+    // Ordering takes the top 10 bits of coordinates only
+    if (k != 0)
+      ordered = ordered &&
+                morton_code(centroid(sorted.triangles[k - 1]), box) >> 33U <=
+                    morton_code(centroid(t), box) >> 33U;
+  }
+  BOOST_TEST(copied);
+  BOOST_TEST(ordered);
+
+  auto indices = std::vector<std::size_t>{5, 0, 7};
+  auto original = sorted.to_original(indices);
+  BOOST_TEST(std::ranges::is_sorted(original));
+  BOOST_TEST(std::ranges::count(original, sorted.original[5]) == 1);
+  BOOST_TEST(morton_sorted(std::span<Triangle const>{}).triangles.empty());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,119 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Predicates // NOLINT
+#define _CRT_SECURE_NO_WARNINGS      // NOLINT
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/predicates.hpp"
+
+using namespace cpp_contests;
+
+BOOST_AUTO_TEST_CASE(expansion_test) {
+  using namespace cpp_contests::details_;
+  constexpr auto x = 1.0 + 0x1p-52;
+  constexpr auto product = two_product(x, x);
+  static_assert(product.first == 1.0 + 0x1p-51);
+  static_assert(product.second == 0x1p-104);
+  constexpr auto sum = two_sum(1.0, 0x1p-60);
+  static_assert(sum.first == 1.0 && sum.second == 0x1p-60);
+
+  constexpr auto a = difference(1.0, 0x1p-60);
+  constexpr auto b = difference(0x1p-60, 1.0);
+  static_assert(a.size() == 2 && a.sign() == 1);
+  static_assert((a + b).sign() == 0);
+  static_assert((a * a - a * a).sign() == 0);
+  static_assert((a * b).sign() == -1);
+}
+
+BOOST_AUTO_TEST_CASE(orient3d_test) {
+  constexpr Point a{0.0, 0.0, 0.0};
+  constexpr Point b{1.0, 0.0, 0.0};
+  constexpr Point c{0.0, 1.0, 0.0};
+  static_assert(orient3d(a, b, c, Point{0.3, 0.3, 1.0}) == 1);
+  static_assert(orient3d(a, b, c, Point{0.3, 0.3, -1.0}) == -1);
+  static_assert(orient3d(a, b, c, Point{5.0, -7.0, 0.0}) == 0);
+  static_assert(orient3d(a, c, b, Point{0.3, 0.3, 1.0}) == -1);
+
+  // Points near the line y = x, where naive evaluation of the determinant
+  // gets the sign wrong for a large share of cases
+  constexpr auto u = 0x1p-53;
+  constexpr Point q{12.0, 12.0, 0.0};
+  constexpr Point r{24.0, 24.0, 0.0};
+  constexpr Point top{0.0, 0.0, 1.0};
+  static_assert(orient3d(Point{0.5, 0.5 + u, 0.0}, q, r, top) == 1);
+  static_assert(orient3d(Point{0.5 + u, 0.5, 0.0}, q, r, top) == -1);
+
+  std::size_t mismatches = 0;
+  std::size_t naive_mismatches = 0;
+  auto sign = [](double x) { return (x > 0.0) - (x < 0.0); };
+  for (int i = 0; i < 64; ++i) {
+    for (int j = 0; j < 64; ++j) {
+      auto p = Point{0.5 + i * u, 0.5 + j * u, 0.0};
+      auto expected = sign(j - i);
+      auto orientation = Orientation3d(p, q, r);
+      mismatches += orientation(top) != expected ? 1 : 0;
+      naive_mismatches +=
+          sign(dot(cross(q - p, r - p), top - p)) != expected ? 1 : 0;
+    }
+  }
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(naive_mismatches > 0U);
+}
+
+BOOST_AUTO_TEST_CASE(interval_test) {
+  using namespace cpp_contests::details_;
+  // 1 + 2^-60 rounds to 1, the interval keeps the exact sum inside
+  constexpr auto sum = Interval{1.0} + Interval{0x1p-60};
+  static_assert(sum.lo() <= 1.0 && 1.0 < sum.hi());
+  static_assert(sum.sign() == 1);
+  static_assert((sum - Interval{1.0}).sign() == std::nullopt);
+  static_assert((Interval{-2.0} * Interval{-3.0, 4.0}).lo() < -8.0);
+  static_assert((Interval{0.0} * Interval{0.0}).sign() == std::nullopt);
+
+  // (1 + u) * (1 - u) - 1 * 1 rounds to zero, while exactly it is -u^2
+  constexpr auto u = 0x1p-30;
+  static_assert(det2_sign(1.0 + u, 1.0, 1.0, 1.0 - u) == -1);
+  static_assert(det2_sign(1.0, 1.0, 1.0, 1.0) == 0);
+
+  constexpr auto id = Columns{Coords{1.0, 0.0, 0.0}, Coords{0.0, 1.0, 0.0},
+                              Coords{0.0, 0.0, 1.0}};
+  static_assert(det3_sign(Columns{}, id) == 1);
+  static_assert(certified_det3_sign(Columns{}, id) == 1);
+  static_assert(det3_sign(id, id) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(robust_primitives_test) {
+  constexpr auto u = 0x1p-30;
+  constexpr auto nearly_singular = Matrix<2, 2, double>{{1.0 + u, 1.0},
+                                                        {1.0, 1.0 - u}};
+  static_assert(det(nearly_singular) == 0.0);
+  static_assert(invertible(nearly_singular));
+  static_assert(!invertible(nearly_singular, EPSMIN));
+  static_assert(!invertible(Matrix<3, 3, float>{{1.0F, 2.0F, 3.0F},
+                                                {2.0F, 4.0F, 6.0F},
+                                                {0.0F, 1.0F, 5.0F}}));
+
+  // The midpoint is exact, so d lies on the line through a and b
+  constexpr Point a{0.5, 0.25, 0.125};
+  constexpr Point b{1.5, 0.75, -0.375};
+  constexpr Point c{-0.4, 1.9, 0.3};
+  constexpr Point d = (a + b) * 0.5;
+  static_assert(complanar(a, b, c, d));
+  static_assert(!complanar(a, b, c, Point{d[0], d[1], d[2] + 0x1p-52}));
+
+  constexpr Line l1{Point{0.0, 0.0, 1.0}, Point{1.0, 1.0, 0.0}};
+  constexpr Line l2{Point{1.0, 0.0, 1.0}, Point{1.0, 1.0, 0.0}};
+  constexpr Line l3{Point{1.0, 0.0, 1.0}, Point{1.0, 1.0 + 0x1p-40, 0.0}};
+  static_assert(complanar(l1, l2) && complanar(l1, l3));
+  static_assert(parallel(l1, l2) && !parallel(l1, l3));
+  static_assert(!complanar_intersection(l1, l2).has_value());
+  // Lines cross far away at (2^40 + 1, 2^40 + 1, 1), but they do cross
+  constexpr auto crossing = complanar_intersection(l1, l3);
+  static_assert(crossing.has_value());
+  static_assert(n(*crossing - Point{0x1p40, 0x1p40, 1.0}) < 0x1p40 * 1e-9);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "geometry/primitives.hpp"
+#include "geometry/triangle.hpp"
+
+// Random triangles shared by unit tests
+
+namespace cpp_contests::testing {
+
+// Centers of triangles are uniform in [lo, hi)^3, vertices are uniform within
+// size of the center along every axis. Coordinates are snapped to multiples
+// of grid unless it is zero, so that many triangles share vertices.
+// Triangles with the doubled area up to min_area after rounding to T are
+// rejected, so float ones pass the triangle inequality check too.
+struct TriangleOptions {
+  double lo = -1.0;
+  double hi = 1.0;
+  double size = 1.0;
+  double grid = 0.0;
+  double min_area = 1e-3;
+};
+
+template <GeometryScalar T = double>
+std::vector<BasicTriangle<T>>
+random_triangles(std::size_t count, std::mt19937 &gen,
+                 TriangleOptions const &options = {}) {
+  auto center = std::uniform_real_distribution<double>{options.lo, options.hi};
+  auto offset =
+      std::uniform_real_distribution<double>{-options.size, options.size};
+  auto coord = [&](double c) {
+    auto x = c + offset(gen);
+    return options.grid == 0.0 ? x
+                               : std::round(x / options.grid) * options.grid;
+  };
+  auto triangles = std::vector<BasicTriangle<T>>{};
+  triangles.reserve(count);
+  while (triangles.size() < count) {
+    auto c = Point{center(gen), center(gen), center(gen)};
+    auto vertex = [&] {
+      return BasicPoint<T>(Point{coord(c[0]), coord(c[1]), coord(c[2])});
+    };
+    auto p1 = vertex();
+    auto p2 = vertex();
+    auto p3 = vertex();
+    if (!(n(cross(Point(p2) - Point(p1), Point(p3) - Point(p1))) >
+          options.min_area))
+      continue;
+    triangles.emplace_back(p1, p2, p3);
+  }
+  return triangles;
+}
+
+} // namespace cpp_contests::testing
@@ -0,0 +1,237 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Ray   // NOLINT
+#define _CRT_SECURE_NO_WARNINGS // NOLINT
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/bvh.hpp"
+#include "geometry/ray.hpp"
+#include "geometry/triangle_bvh.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+// Triangles of the scene, which is the cube [0, 10)^3
+constexpr auto scene = testing::TriangleOptions{
+    .lo = 0.0, .hi = 10.0, .size = 0.5, .min_area = 1e-2};
+
+// Rays from around the scene through its inside, half of them segments, a
+// quarter of which lie behind the origin
+template <typename T>
+std::vector<BasicRay<T>> random_rays(std::size_t count, std::mt19937 &gen) {
+  auto coord = std::uniform_real_distribution<T>{-2.0, 12.0};
+  auto rays = std::vector<BasicRay<T>>{};
+  rays.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    auto from = BasicPoint<T>{coord(gen), coord(gen), coord(gen)};
+    auto to = BasicPoint<T>{coord(gen), coord(gen), coord(gen)};
+    auto ray = BasicRay<T>{from, to - from};
+    if (i % 2 == 0)
+      ray.tmax = T{1};
+    if (i % 8 == 0) {
+      ray.tmin = T{-1};
+      ray.tmax = T{0};
+    }
+    rays.push_back(ray);
+  }
+  return rays;
+}
+
+template <typename T>
+std::optional<BasicRayHit<T>>
+brute_force_hit(BasicRay<T> const &ray,
+                std::vector<BasicTriangle<T>> const &ts) {
+  auto best = std::optional<BasicRayHit<T>>{};
+  for (std::size_t i = 0; i < ts.size(); ++i) {
+    auto hit = intersection(ray, ts[i]);
+    if (hit && (!best || hit->t < best->t)) {
+      best = hit;
+      best->triangle = i;
+    }
+  }
+  return best;
+}
+
+template <typename T> void bvh_check(ThreadPool &pool) {
+  auto gen = std::mt19937{0};
+  auto ts = testing::random_triangles<T>(2000, gen, scene);
+  auto rays = random_rays<T>(1000, gen);
+  auto bvh = BasicTriangleBvh<T>(std::span<BasicTriangle<T> const>{ts});
+  BOOST_TEST(bvh.size() == ts.size());
+
+  // The vector kernel may round differently, so closest hits are compared
+  // by their params
+  constexpr auto eps = std::is_same_v<T, float> ? T{1e-4} : T{1e-12};
+  auto mismatches = std::size_t{0};
+  auto hits = std::size_t{0};
+  for (auto const &ray : rays) {
+    auto expected = brute_force_hit(ray, ts);
+    auto found = bvh.closest_hit(ray);
+    hits += expected.has_value();
+    if (expected.has_value() != found.has_value() ||
+        bvh.any_hit(ray) != found.has_value()) {
+      ++mismatches;
+      continue;
+    }
+    if (found && std::abs(found->t - expected->t) > eps) {
+      ++mismatches;
+      continue;
+    }
+    if (found) {
+      auto point = ray.point(found->t);
+      auto const &t = ts[found->triangle];
+      auto on = t[0] + found->u * (t[1] - t[0]) + found->v * (t[2] - t[0]);
+      if (n(point - on) > eps * 100)
+        ++mismatches;
+    }
+  }
+  BOOST_TEST(hits > rays.size() / 4);
+  BOOST_TEST(mismatches == 0U);
+
+  auto span = std::span<BasicRay<T> const>{rays};
+  auto closest = std::vector<std::optional<BasicRayHit<T>>>(rays.size());
+  bvh.closest_hits(span, std::span<std::optional<BasicRayHit<T>>>{closest},
+                   pool);
+  auto any = std::vector<std::uint8_t>(rays.size());
+  bvh.any_hits(span, std::span<std::uint8_t>{any}, pool);
+  auto batch_mismatches = std::size_t{0};
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    auto single = bvh.closest_hit(rays[i]);
+    if (single.has_value() != closest[i].has_value() ||
+        (single && single->triangle != closest[i]->triangle) ||
+        (any[i] != 0) != single.has_value())
+      ++batch_mismatches;
+  }
+  BOOST_TEST(batch_mismatches == 0U);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ray_triangle_test) {
+  constexpr Triangle t(Point{0.0, 0.0, 0.0}, Point{4.0, 0.0, 0.0},
+                       Point{0.0, 4.0, 0.0});
+  constexpr auto down = Ray{Point{1.0, 2.0, 2.0}, Point{0.0, 0.0, -0.5}};
+  constexpr auto hit = intersection(down, t);
+  static_assert(hit.has_value());
+  static_assert(hit->t == 4.0 && hit->u == 0.25 && hit->v == 0.5);
+  // Both sides are hit
+  constexpr auto up = Ray{Point{1.0, 2.0, -2.0}, Point{0.0, 0.0, 1.0}};
+  static_assert(intersection(up, t).has_value());
+  // Params out of range, hits behind the origin and misses
+  static_assert(!intersection(Ray{down.origin, down.direction, 0.0, 3.9}, t));
+  static_assert(!intersection(Ray{down.origin, -down.direction}, t));
+  static_assert(
+      !intersection(Ray{Point{3.0, 3.0, 1.0}, Point{0.0, 0.0, -1.0}}, t));
+  // Rays in the plane miss
+  static_assert(
+      !intersection(Ray{Point{-1.0, 1.0, 0.0}, Point{1.0, 0.0, 0.0}}, t));
+  // Segment ending exactly on the triangle
+  static_assert(
+      intersection(Ray{Point{1.0, 1.0, 1.0}, Point{0.0, 0.0, -1.0}, 0.0, 1.0},
+                   t)
+          .has_value());
+}
+
+BOOST_AUTO_TEST_CASE(ray_packet_test) {
+  auto gen = std::mt19937{1};
+  auto ts = testing::random_triangles<double>(37, gen, scene);
+  auto fs = std::vector<BasicTriangle<float>>{};
+  for (auto const &t : ts)
+    fs.emplace_back(t);
+  auto batch = TriangleBatch<double>(std::span<Triangle const>{ts});
+  auto fbatch = TriangleBatch<float>(std::span<BasicTriangle<float> const>{fs});
+  auto mismatches = std::size_t{0};
+  auto hits = std::size_t{0};
+  for (auto const &ray : random_rays<double>(300, gen)) {
+    auto fray = BasicRay<float>{BasicPoint<float>(ray.origin),
+                                BasicPoint<float>(ray.direction),
+                                static_cast<float>(ray.tmin),
+                                static_cast<float>(ray.tmax)};
+    auto check = [&](auto const &r, auto const &triangles, auto bits,
+                     std::size_t first, std::size_t width) {
+      for (std::size_t i = 0; i < width && first + i < triangles.size(); ++i) {
+        auto expected = intersection(r, triangles[first + i]).has_value();
+        hits += expected;
+        mismatches += expected != (((bits >> i) & 1U) != 0);
+      }
+    };
+    for (std::size_t first = 0; first < ts.size(); first += 4) {
+      check(ray, ts, intersects<double, 4>(ray, batch, first), first, 4);
+    }
+    for (std::size_t first = 0; first < ts.size(); first += 8) {
+      check(fray, fs, intersects<float, 8>(fray, fbatch, first), first, 8);
+      check(ray, ts, intersects<double, 8>(ray, batch, first), first, 8);
+    }
+  }
+  BOOST_TEST(hits > 0U);
+  BOOST_TEST(mismatches == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(bvh_test) {
+  auto gen = std::mt19937{2};
+  auto ts = testing::random_triangles<double>(1000, gen, scene);
+  auto boxes = std::vector<Box>{};
+  for (auto const &t : ts)
+    boxes.push_back(bounding_box(t));
+  auto bvh = Bvh(std::span<Box const>{boxes}, 4);
+
+  // Every box is in exactly one leaf, which is inside all its ancestors
+  auto seen = std::vector<int>(boxes.size());
+  auto nodes = bvh.nodes();
+  auto inside = [](Box const &inner, Box const &outer) {
+    for (std::size_t c = 0; c < 3; ++c) {
+      if (inner.min[c] < outer.min[c] || inner.max[c] > outer.max[c])
+        return false;
+    }
+    return true;
+  };
+  auto ok = true;
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    auto const &node = nodes[i];
+    if (node.leaf()) {
+      ok = ok && node.count <= 4;
+      for (auto k = node.first; k < node.first + node.count; ++k) {
+        auto index = bvh.indices()[k];
+        ++seen[index];
+        ok = ok && inside(boxes[index], node.box);
+      }
+    } else {
+      ok = ok && node.first > i + 1 && node.first < nodes.size() &&
+           inside(nodes[i + 1].box, node.box) &&
+           inside(nodes[node.first].box, node.box);
+    }
+  }
+  BOOST_TEST(ok);
+  BOOST_TEST(std::ranges::all_of(seen, [](int s) { return s == 1; }));
+
+  // Equal boxes can not be split by the heuristic
+  auto same = std::vector<Box>(100, boxes.front());
+  auto degenerate = Bvh(std::span<Box const>{same}, 4);
+  BOOST_TEST(degenerate.nodes().size() < 100U);
+  BOOST_TEST(Bvh(std::span<Box const>{}).empty());
+}
+
+BOOST_AUTO_TEST_CASE(triangle_bvh_test) {
+  auto pool = ThreadPool{4};
+  bvh_check<double>(pool);
+  bvh_check<float>(pool);
+
+  auto empty = TriangleBvh{};
+  BOOST_TEST(!empty.closest_hit(Ray{Point{0.0, 0.0, 0.0},
+                                    Point{1.0, 0.0, 0.0}}));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
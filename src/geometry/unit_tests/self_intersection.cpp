@@ -0,0 +1,168 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE SelfIntersection // NOLINT
+#define _CRT_SECURE_NO_WARNINGS            // NOLINT
+
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/self_intersection.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+template <typename T>
+std::vector<SelfIntersection>
+collect(std::vector<BasicTriangle<T>> const &ts, ThreadPool &pool) {
+  auto span = std::span<BasicTriangle<T> const>{ts};
+  auto result = std::vector<SelfIntersection>{};
+  self_intersections(
+      span, MeshAdjacency(span),
+      [&](SelfIntersection const &found) { result.push_back(found); }, pool);
+  return result;
+}
+
+std::vector<IndexPair> pairs(std::vector<SelfIntersection> const &found) {
+  auto result = std::vector<IndexPair>{};
+  for (auto const &f : found)
+    result.emplace_back(f.first, f.second);
+  std::ranges::sort(result);
+  return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(adjacency_test) {
+  auto ts = std::vector<Triangle>{
+      Triangle(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
+               Point{0.0, 1.0, 0.0}),
+      Triangle(Point{1.0, 0.0, 0.0}, Point{1.0, 1.0, 0.0},
+               Point{0.0, 1.0, 0.0}),
+      Triangle(Point{1.0, 1.0, 0.0}, Point{2.0, 1.0, 0.0},
+               Point{1.0, 2.0, 0.0}),
+      Triangle(Point{5.0, 5.0, 5.0}, Point{6.0, 5.0, 5.0},
+               Point{5.0, 6.0, 5.0})};
+  auto adjacency = MeshAdjacency(std::span<Triangle const>{ts});
+  BOOST_TEST(adjacency.size() == 4U);
+  BOOST_TEST(adjacency[0][1] == adjacency[1][0]);
+  BOOST_TEST(adjacency[0][2] == adjacency[1][2]);
+  BOOST_TEST(adjacency[1][1] == adjacency[2][0]);
+  BOOST_TEST(adjacency.adjacent(0, 1));
+  BOOST_TEST(adjacency.adjacent(1, 2));
+  BOOST_TEST(!adjacency.adjacent(0, 2));
+  BOOST_TEST(!adjacency.adjacent(0, 3));
+
+  auto faces = std::vector<MeshAdjacency::Face>{{0, 1, 2}, {2, 3, 4}};
+  auto explicit_adjacency = MeshAdjacency(std::move(faces));
+  BOOST_TEST(explicit_adjacency.adjacent(0, 1));
+}
+
+BOOST_AUTO_TEST_CASE(self_intersection_test) {
+  auto pool = ThreadPool{4};
+  // A fan around the origin: neighbours share edges, the folded last
+  // triangle crosses the first one, which it does not touch otherwise
+  auto ts = std::vector<Triangle>{
+      Triangle(Point{0.0, 0.0, 0.0}, Point{2.0, 0.0, 0.0},
+               Point{0.0, 2.0, 0.0}),
+      Triangle(Point{0.0, 0.0, 0.0}, Point{0.0, 2.0, 0.0},
+               Point{-2.0, 0.0, 0.0}),
+      Triangle(Point{0.0, 0.0, 0.0}, Point{-2.0, 0.0, 0.0},
+               Point{0.0, -2.0, 0.0}),
+      Triangle(Point{0.5, 0.5, -1.0}, Point{0.5, 0.5, 1.0},
+               Point{3.0, 3.0, 0.0})};
+  auto found = collect(ts, pool);
+  BOOST_TEST_REQUIRE(found.size() == 1U);
+  BOOST_TEST(found.front().first == 0U);
+  BOOST_TEST(found.front().second == 3U);
+  BOOST_TEST_REQUIRE(found.front().segment.has_value());
+  auto const &segment = *found.front().segment;
+  // The triangle meets the plane z = 0 on the segment from (0.5, 0.5, 0)
+  // to (3, 3, 0), which is cut by the hypotenuse x + y = 2
+  auto expected_s = Point{0.5, 0.5, 0.0};
+  auto expected_e = Point{1.0, 1.0, 0.0};
+  auto ends_match = (n(segment.s - expected_s) < 1e-12 &&
+                     n(segment.e - expected_e) < 1e-12) ||
+                    (n(segment.s - expected_e) < 1e-12 &&
+                     n(segment.e - expected_s) < 1e-12);
+  BOOST_TEST(ends_match);
+
+  // Complanar overlap is reported without a segment
+  ts.emplace_back(Point{-0.5, -0.5, 0.0}, Point{-1.5, -0.5, 0.0},
+                  Point{-0.5, -1.5, 0.0});
+  found = collect(ts, pool);
+  BOOST_TEST_REQUIRE(found.size() == 2U);
+  auto complanar = std::ranges::find_if(
+      found, [](auto const &f) { return f.second == 4U; });
+  BOOST_TEST_REQUIRE((complanar != found.end()));
+  BOOST_TEST(complanar->first == 2U);
+  BOOST_TEST(!complanar->segment.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(soup_test) {
+  auto pool = ThreadPool{4};
+  auto gen = std::mt19937{0};
+  // Small triangles on a coarse lattice: many of them share vertices
+  auto ts = testing::random_triangles(
+      2000, gen, {.lo = 0.0, .hi = 3.0, .size = 0.75, .grid = 0.25});
+  auto span = std::span<Triangle const>{ts};
+  auto adjacency = MeshAdjacency(span);
+
+  auto expected = std::vector<IndexPair>{};
+  for (std::size_t i = 0; i < ts.size(); ++i) {
+    for (std::size_t j = i + 1; j < ts.size(); ++j) {
+      if (!adjacency.adjacent(i, j) && intersects(ts[i], ts[j]))
+        expected.emplace_back(i, j);
+    }
+  }
+  BOOST_TEST(!expected.empty());
+
+  auto found = collect(ts, pool);
+  BOOST_TEST((pairs(found) == expected));
+  for (auto const &f : found) {
+    if (!f.segment)
+      continue;
+    auto const &t1 = ts[f.first];
+    auto const &t2 = ts[f.second];
+    // Segment ends lie on both triangles
+    for (auto const &p : {f.segment->s, f.segment->e}) {
+      auto scale = 1.0 + n(p);
+      BOOST_TEST(std::abs(dot(p - t1[0], cross(t1[1] - t1[0],
+                                               t1[2] - t1[0]))) <
+                 1e-9 * scale);
+      BOOST_TEST(std::abs(dot(p - t2[0], cross(t2[1] - t2[0],
+                                               t2[2] - t2[0]))) <
+                 1e-9 * scale);
+    }
+  }
+
+  // Float meshes find the same pairs, lattice coordinates are exact in float
+  auto floats = std::vector<BasicTriangle<float>>{};
+  for (auto const &t : ts) {
+    auto point = [](Point const &p) {
+      return BasicPoint<float>{static_cast<float>(p[0]),
+                               static_cast<float>(p[1]),
+                               static_cast<float>(p[2])};
+    };
+    floats.emplace_back(point(t[0]), point(t[1]), point(t[2]));
+  }
+  BOOST_TEST((pairs(collect(floats, pool)) == expected));
+
+  // Blocks keep the order of the sweep whatever the pool does
+  auto single = ThreadPool{1};
+  auto sequential = collect(ts, single);
+  BOOST_TEST_REQUIRE(sequential.size() == found.size());
+  for (std::size_t k = 0; k < found.size(); ++k) {
+    BOOST_TEST(sequential[k].first == found[k].first);
+    BOOST_TEST(sequential[k].second == found[k].second);
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
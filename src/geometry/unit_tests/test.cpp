@@ -4,9 +4,12 @@
 #define BOOST_TEST_MODULE Matrix // NOLINT
 #define _CRT_SECURE_NO_WARNINGS  // NOLINT
 
+#include <algorithm>
+
 #include <boost/test/included/unit_test.hpp>
 
 #include "geometry/matrix.hpp"
+#include "geometry/matrix_view.hpp"
 #include "geometry/primitives.hpp"
 
 using namespace cpp_contests;
@@ -126,6 +129,66 @@ BOOST_AUTO_TEST_CASE(matrix_ops_test) {
   BOOST_TEST(m == (Matrix<X, Y, int>{1, 2, 3, 4, 5, 6}));
 }
 
+BOOST_AUTO_TEST_CASE(matrix_expression_test) {
+  constexpr Matrix<2, 2, int> a{{1, 2}, {3, 4}};
+  constexpr Matrix<2, 2, int> b{{5, 6}, {7, 8}};
+  // Expressions are evaluated when converted to Matrix
+  constexpr Matrix<2, 2, int> c = 2 * a - b + 1;
+  static_assert(c == Matrix<2, 2, int>{{-2, -1}, {0, 1}});
+  static_assert(-(a - b) == Matrix<2, 2, int>{{4, 4}, {4, 4}});
+  static_assert((a + b) % 5 == Matrix<2, 2, int>{{1, 3}, {0, 2}});
+  static_assert(dot(a + b, a - b) == -144);
+  static_assert((a + b) * (a - b) == eval(a + b) * eval(a - b));
+  static_assert(t(a - b) == -t(b - a));
+
+  // Expression over the assigned matrix itself
+  auto m = Matrix<2, 2, int>{a};
+  m = m * 2 + b;
+  BOOST_TEST(m == (Matrix<2, 2, int>{{7, 10}, {13, 16}}));
+  m -= a + b;
+  BOOST_TEST(m == (Matrix<2, 2, int>{{1, 2}, {3, 4}}));
+
+  // Temporaries are stored in expressions by value
+  auto e = Point{1.0, 2.0, 3.0} - Point{1.0, 0.0, 0.0};
+  BOOST_TEST(n(e) == std::sqrt(13.0));
+  BOOST_TEST(n(cross(e, Point{0.0, 0.0, 1.0}) / 2.0) == 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(matrix_view_test) {
+  // Static, so that its address is a constant expression
+  static constexpr Matrix<3, 4, int> c{
+      {1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}};
+  constexpr auto v = view(c);
+  static_assert(v == c);
+  static_assert(v.transposed() == t(c));
+  static_assert(v.row(1) == c.row(1));
+  static_assert(v.col(2) == c.col(2));
+  static_assert(v.block<2, 2>(1, 2) == Matrix<2, 2, int>{{8, 9}, {11, 12}});
+  static_assert(v.strided<2, 2, 2, 3>(0, 0) ==
+                Matrix<2, 2, int>{{1, 3}, {10, 12}});
+  static_assert(v.strided<2, 2>(0, 0, 2, 3) == v.strided<2, 2, 2, 3>(0, 0));
+  // Compile-time strides are not stored
+  static_assert(sizeof(v) == sizeof(int const *));
+  static_assert(sizeof(v.strided<2, 2>(0, 0, 2, 3)) == 3 * sizeof(int *));
+
+  // Views take part in arithmetic and products without copies
+  static_assert(v.row(0) + v.row(3) == Matrix<3, 1, int>{11, 13, 15});
+  static_assert(transpose_view(c) * c == t(c) * c);
+  static_assert(v.block<3, 3>(0, 0) * v.col(0).block<1, 3>(0, 0) ==
+                Matrix<1, 3, int>{30, 66, 102});
+
+  // Writes go to the matrix
+  auto m = c;
+  view(m).row(0) = c.row(3);
+  view(m).col(1) *= 2;
+  transpose_view(m).block<2, 1>(0, 2) -= Matrix<2, 1, int>{12, 6};
+  BOOST_TEST((m == Matrix<3, 4, int>{
+                       {10, 22, 0}, {4, 10, 0}, {7, 16, 9}, {10, 22, 12}}));
+  auto row = view(m).row(2);
+  row = row * 2 + 1;
+  BOOST_TEST((m.row(2) == Matrix<3, 1, int>{15, 33, 19}));
+}
+
 BOOST_AUTO_TEST_CASE(matrix_mult_test) {
   constexpr double small = 0.00001;
 
@@ -147,6 +210,48 @@ BOOST_AUTO_TEST_CASE(matrix_mult_test) {
   // clang-format on
 }
 
+namespace {
+
+// Compares runtime product with the reference triple loop. Elements are small
+// integers, so all sums are exact in any order.
+template <std::size_t X, std::size_t Y, std::size_t Z, typename T>
+bool check_product() {
+  Matrix<X, Y, T> a{};
+  Matrix<Z, X, T> b{};
+  for (std::size_t i = 0; i < X * Y; ++i)
+    a[i] = static_cast<T>(static_cast<int>(i * 7 % 13) - 6);
+  for (std::size_t i = 0; i < Z * X; ++i)
+    b[i] = static_cast<T>(static_cast<int>(i * 5 % 11) - 5);
+  auto c = a * b;
+  for (std::size_t y = 0; y < Y; ++y) {
+    for (std::size_t z = 0; z < Z; ++z) {
+      T ref{};
+      for (std::size_t k = 0; k < X; ++k)
+        ref += a[k, y] * b[z, k];
+      if (c[z, y] != ref)
+        return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(matrix_mult_kernel_test) {
+  BOOST_TEST((check_product<4, 4, 4, double>()));
+  BOOST_TEST((check_product<16, 16, 16, double>()));
+  BOOST_TEST((check_product<3, 5, 7, double>()));
+  BOOST_TEST((check_product<7, 3, 9, double>()));
+  BOOST_TEST((check_product<5, 6, 1, double>()));
+  BOOST_TEST((check_product<1, 4, 13, double>()));
+  BOOST_TEST((check_product<9, 9, 21, double>()));
+  BOOST_TEST((check_product<4, 4, 4, float>()));
+  BOOST_TEST((check_product<16, 16, 16, float>()));
+  BOOST_TEST((check_product<9, 7, 37, float>()));
+  BOOST_TEST((check_product<4, 4, 4, int>()));
+  BOOST_TEST((check_product<6, 5, 3, int>()));
+}
+
 BOOST_AUTO_TEST_CASE(matrix_transform_test) {
   // clang-format off
   constexpr Matrix<4, 3, int> m1{
@@ -270,6 +375,94 @@ BOOST_AUTO_TEST_CASE(matrix_inv) {
   static_assert(n(m6 * res6 - eye<6, 6, double>()) < eps);
 }
 
+BOOST_AUTO_TEST_CASE(matrix_lu) {
+  constexpr double eps = 1e-9;
+  // clang-format off
+  constexpr Matrix<4, 4, double> m4{
+    {0, 0, 1, 0},
+    {1, 3, 1, 1},
+    {1, 2, 1, 3},
+    {1, 2, 6, 1},
+  };
+  // clang-format on
+  constexpr auto d = lu(m4);
+  static_assert(!d.singular);
+  constexpr auto l = [&]() {
+    auto m = eye<4, 4, double>();
+    for (std::size_t y = 0; y < 4; ++y) {
+      for (std::size_t x = 0; x < y; ++x)
+        m[x, y] = d.lu[x, y];
+    }
+    return m;
+  }();
+  constexpr auto u = [&]() {
+    auto m = Matrix<4, 4, double>{};
+    for (std::size_t y = 0; y < 4; ++y) {
+      for (std::size_t x = y; x < 4; ++x)
+        m[x, y] = d.lu[x, y];
+    }
+    return m;
+  }();
+  static_assert(n(l * u - m4[iota<4>(), d.perm]) < eps);
+  static_assert(std::abs(det(m4) - 2.0) < eps);
+
+  constexpr auto b = Vector<4, double>{1, 2, 3, 4};
+  constexpr auto x = solve(m4, b);
+  static_assert(n(m4 * x - b) < eps);
+  constexpr auto rhs = Matrix<2, 4, double>{{1, 0}, {2, 1}, {3, 0}, {4, 1}};
+  static_assert(n(m4 * solve(m4, rhs) - rhs) < eps);
+
+  // clang-format off
+  constexpr Matrix<3, 3, double> singular{
+    {1, 2, 3},
+    {2, 4, 6},
+    {1, 0, 1},
+  };
+  // clang-format on
+  static_assert(lu(singular).singular);
+  static_assert(det(singular) == 0.0);
+  static_assert(!invertible(singular));
+
+  // Sizes far beyond what cofactor expansion can handle
+  constexpr std::size_t N = 12;
+  auto m = Matrix<N, N, double>{};
+  auto h = Matrix<N, N, long long>{};
+  for (std::size_t y = 0; y < N; ++y) {
+    for (std::size_t x = 0; x < N; ++x) {
+      m[x, y] = 1.0 / static_cast<double>(x + y + 1) + (x == y ? 1.0 : 0.0);
+      h[x, y] = (x == y ? 2 : 0) + (x + 1 == y ? -1 : 0) + (y + 1 == x ? -1 : 0);
+    }
+  }
+  BOOST_TEST(n(m * inv(m) - eye<N, N, double>()) < eps);
+  BOOST_TEST(std::abs(det(m) * det(inv(m)) - 1.0) < eps);
+  // Determinant of tridiagonal [-1, 2, -1] matrix is N + 1
+  BOOST_TEST(det(h) == static_cast<long long>(N + 1));
+}
+
+BOOST_AUTO_TEST_CASE(small_kernels_test) {
+  // Unrolled kernels add terms in the same order as the generic loop
+  constexpr auto loop_dot = [](auto const &a, auto const &b) {
+    auto sum = expression_value_t<decltype(a)>{};
+    for (std::size_t i = 0; i < a.size(); ++i)
+      sum += a[i] * b[i];
+    return sum;
+  };
+  constexpr auto v2 = Vector<2, double>{0.1, 0.7};
+  constexpr auto v3 = Vector<3, double>{0.1, 0.7, 1.3};
+  constexpr auto v4 = Vector<4, double>{0.1, 0.7, 1.3, -2.9};
+  constexpr auto v5 = Vector<5, double>{0.1, 0.7, 1.3, -2.9, 3.7};
+  static_assert(dot(v2, v2 * 3.0) == loop_dot(v2, v2 * 3.0));
+  static_assert(dot(v3, v3 * 3.0) == loop_dot(v3, v3 * 3.0));
+  static_assert(dot(v4, v4 * 3.0) == loop_dot(v4, v4 * 3.0));
+  static_assert(dot(v5, v5 * 3.0) == loop_dot(v5, v5 * 3.0));
+  static_assert(n(v4) == cpp_contests::sqrt(loop_dot(v4, v4)));
+  static_assert(n(t(v3)) == n(v3));
+  static_assert(t(t(v3))[2] == v3[2] && t(v4)[3] == v4[3]);
+  constexpr auto row = t(v3);
+  static_assert(std::equal(row.tbegin(), row.tend(), v3.begin()));
+  static_assert(std::equal(v3.tbegin(), v3.tend(), row.begin()));
+}
+
 BOOST_AUTO_TEST_CASE(plane_test) {
   constexpr double eps = 1e-9;
   constexpr Plane p1(1, 0, 0, -1);
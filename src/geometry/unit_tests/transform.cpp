@@ -0,0 +1,150 @@
+// NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+#define BOOST_TEST_MODULE Matrix // NOLINT
+#define _CRT_SECURE_NO_WARNINGS  // NOLINT
+
+#include <numbers>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "geometry/transform.hpp"
+
+#include "random_triangles.hpp"
+
+using namespace cpp_contests;
+
+namespace {
+
+Point random_point(std::mt19937 &gen) {
+  auto coord = std::uniform_real_distribution<double>{-1.0, 1.0};
+  return Point{coord(gen), coord(gen), coord(gen)};
+}
+
+RigidTransform random_rigid(std::mt19937 &gen) {
+  auto angle = std::uniform_real_distribution<double>{-3.0, 3.0};
+  return RigidTransform{Quaternion::rotation(random_point(gen), angle(gen)),
+                        random_point(gen)};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(quaternion_test) {
+  auto q = Quaternion::rotation(Point{0.0, 0.0, 2.0}, std::numbers::pi / 2);
+  BOOST_TEST(n(q.rotate(Point{1.0, 0.0, 0.0}) - Point{0.0, 1.0, 0.0}) < 1e-15);
+  BOOST_TEST(n(q.matrix() * Point{1.0, 0.0, 0.0} - Point{0.0, 1.0, 0.0}) <
+             1e-15);
+  BOOST_TEST(n((q * q).rotate(Point{1.0, 0.0, 0.0}) -
+               Point{-1.0, 0.0, 0.0}) < 1e-15);
+  BOOST_TEST(std::abs(norm(normalized(Quaternion{1.0, 2.0, 3.0, 4.0})) -
+                      1.0) < 1e-15);
+
+  auto gen = std::mt19937{0};
+  for (int i = 0; i < 100; ++i) {
+    auto a = random_rigid(gen);
+    auto b = random_rigid(gen);
+    auto p = random_point(gen);
+    BOOST_TEST(n(a.linear() * p - a.rotation().rotate(p)) < 1e-14);
+    BOOST_TEST(n((a * b)(p) - a(b(p))) < 1e-14);
+    BOOST_TEST(n(inv(a)(a(p)) - p) < 1e-14);
+    auto affine = AffineTransform{a} * AffineTransform{b};
+    BOOST_TEST(n(affine(p) - (a * b)(p)) < 1e-14);
+    BOOST_TEST(n(inv(affine)(affine(p)) - p) < 1e-14);
+  }
+
+  // Long chains of compositions keep the rotation a unit quaternion
+  auto chain = RigidTransform{};
+  for (int i = 0; i < 100000; ++i)
+    chain = random_rigid(gen) * chain;
+  BOOST_TEST(std::abs(norm(chain.rotation()) - 1.0) < 1e-15);
+}
+
+BOOST_AUTO_TEST_CASE(transform_primitives_test) {
+  auto gen = std::mt19937{1};
+  auto affine = AffineTransform{
+      Matrix<3, 3, double>{{2.0, 0.5, 0.0}, {0.0, 1.0, 0.3}, {0.1, 0.0, 3.0}},
+      Point{1.0, -2.0, 0.5}};
+  auto rigid = random_rigid(gen);
+  for (int i = 0; i < 100; ++i) {
+    auto p1 = random_point(gen);
+    auto p2 = random_point(gen);
+    auto p3 = random_point(gen);
+    auto check = [&](auto const &f) {
+      // Transformed points stay on transformed primitives
+      auto plane = Plane{p1, p2, p3};
+      apply(f, plane);
+      for (auto const &p : {p1, p2, p3})
+        BOOST_TEST(std::abs(dot(plane.normal(), f(p)) - plane.dist()) < 1e-12);
+
+      auto line = Line{p1, p2 - p1};
+      apply(f, line);
+      BOOST_TEST(n(cross(f(p2) - line.R0(), line.R())) < 1e-12);
+
+      auto t = Triangle{p1, p2, p3};
+      apply(f, t);
+      auto expected = Triangle{f(p1), f(p2), f(p3)};
+      BOOST_TEST(n(t.plane().normal() - expected.plane().normal()) < 1e-9);
+      BOOST_TEST(std::abs(t.plane().dist() - expected.plane().dist()) < 1e-9);
+      BOOST_TEST(n(t[2] - f(p3)) == 0.0);
+    };
+    check(rigid);
+    check(affine);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(transform_batch_test) {
+  auto gen = std::mt19937{2};
+  auto pool = ThreadPool{4};
+  auto f = AffineTransform{random_rigid(gen)} *
+           AffineTransform{Matrix<3, 3, double>{
+               {1.0, 0.2, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.5}}};
+  for (std::size_t size : {1U, 13U, 70001U}) {
+    auto points = std::vector<Point>{};
+    for (std::size_t i = 0; i < size; ++i)
+      points.push_back(random_point(gen));
+    auto expected = std::vector<Point>{};
+    for (auto const &p : points)
+      expected.push_back(f(p));
+
+    auto x = std::vector<double>{};
+    auto y = std::vector<double>{};
+    auto z = std::vector<double>{};
+    for (auto const &p : points) {
+      x.push_back(p[0]);
+      y.push_back(p[1]);
+      z.push_back(p[2]);
+    }
+    apply(f, std::span<double>{x}, std::span<double>{y},
+          std::span<double>{z}, pool);
+    apply(f, std::span<Point>{points}, pool);
+    auto diff = 0.0;
+    for (std::size_t i = 0; i < size; ++i) {
+      diff = std::max({diff, n(points[i] - expected[i]),
+                       n(Point{x[i], y[i], z[i]} - expected[i])});
+    }
+    BOOST_TEST(diff < 1e-14);
+  }
+
+  auto triangles = testing::random_triangles<float>(21, gen);
+  auto batch = TriangleBatch<float>(
+      std::span<BasicTriangle<float> const>{triangles});
+  auto g = BasicRigidTransform<float>{
+      BasicQuaternion<float>::rotation(BasicPoint<float>{1.0F, 2.0F, 3.0F},
+                                       1.0F),
+      BasicPoint<float>{0.5F, 0.0F, -1.0F}};
+  apply(g, batch, pool);
+  auto diff = 0.0F;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    for (std::size_t v = 0; v < 3; ++v)
+      diff = std::max(diff, n(batch.triangle(i)[v] - g(triangles[i][v])));
+  }
+  BOOST_TEST(diff < 1e-6F);
+  for (std::size_t i = batch.size(); i < TriangleBatch<float>::padding; ++i)
+    BOOST_TEST(batch.coord(0, 0)[i] == 0.0F);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+// NOLINTEND(cppcoreguidelines-pro-type-vararg)
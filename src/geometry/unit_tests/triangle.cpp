@@ -4,11 +4,22 @@
 #define BOOST_TEST_MODULE Matrix // NOLINT
 #define _CRT_SECURE_NO_WARNINGS  // NOLINT
 
+#include <array>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
 #include <boost/test/included/unit_test.hpp>
 
+#include "geometry/prepared_triangle.hpp"
 #include "geometry/triangle.hpp"
+#include "geometry/triangle_batch.hpp"
+
+#include "random_triangles.hpp"
 
 using namespace cpp_contests;
+using cpp_contests::testing::random_triangles;
 
 BOOST_AUTO_TEST_CASE(triangle_test) {
   constexpr Triangle t1(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
@@ -33,8 +44,349 @@ BOOST_AUTO_TEST_CASE(triangle_test) {
   static_assert(intersects(t1, t4));
   static_assert(!intersects(t1, t5));
 
+  // Complanar triangles away from the origin with opposite windings, so
+  // their planes have opposite normals and distances
+  constexpr Triangle t6(Point{0.0, 0.0, 1.0}, Point{1.0, 0.0, 1.0},
+                        Point{0.0, 1.0, 1.0});
+  constexpr Triangle t7(Point{0.2, 0.2, 1.0}, Point{0.2, -0.5, 1.0},
+                        Point{-0.5, 0.2, 1.0});
+  static_assert(intersects(t6, t7) && intersects(t7, t6));
+
   // static_assert(intersect(t1, t1));
 }
 
+BOOST_AUTO_TEST_CASE(touching_test) {
+  constexpr Triangle t1(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
+                        Point{0.0, 1.0, 0.0});
+  // Common vertex only
+  constexpr Triangle t2(Point{0.0, 0.0, 0.0}, Point{-1.0, 0.0, 1.0},
+                        Point{0.0, -1.0, 1.0});
+  // Vertex inside of the other triangle
+  constexpr Triangle t3(Point{0.2, 0.2, 0.0}, Point{0.2, 0.3, 1.0},
+                        Point{1.0, 1.0, 1.0});
+  // The same, but the vertex is slightly above
+  constexpr Triangle t4(Point{0.2, 0.2, 1e-300}, Point{0.2, 0.3, 1.0},
+                        Point{1.0, 1.0, 1.0});
+  // Edge of one triangle touches edge of the other
+  constexpr Triangle t5(Point{0.5, 0.5, -1.0}, Point{0.5, 0.5, 1.0},
+                        Point{1.0, 1.0, 0.0});
+
+  static_assert(intersects(t1, t2) && intersects(t2, t1));
+  static_assert(intersects(t1, t3) && intersects(t3, t1));
+  static_assert(!intersects(t1, t4) && !intersects(t4, t1));
+  static_assert(intersects(t1, t5) && intersects(t5, t1));
+  static_assert(!intersection(t1, t4));
+}
+
+namespace {
+
+// Triangles close to the plane z = 0 at various distances, a third of them
+// slivers with the last vertex next to the line of the other two, and
+// everything rounded to T
+template <typename T>
+std::vector<Triangle> near_plane_triangles(std::size_t count,
+                                           std::mt19937 &gen) {
+  auto coord = std::uniform_real_distribution<double>{-1.0, 1.0};
+  auto scales = std::array{0.0, 1e-5, 1e-9, 1e-14, 1e-20};
+  auto scale = std::uniform_int_distribution<std::size_t>{0, scales.size() - 1};
+  auto point = [&] {
+    return Point{coord(gen), coord(gen), scales[scale(gen)] * coord(gen)};
+  };
+  auto triangles = std::vector<Triangle>{};
+  triangles.reserve(count);
+  while (triangles.size() < count) {
+    auto p1 = point();
+    auto p2 = point();
+    auto p3 = point();
+    if (triangles.size() % 3 == 0) {
+      auto offset = Point{scales[scale(gen)] * coord(gen),
+                          scales[scale(gen)] * coord(gen),
+                          scales[scale(gen)] * coord(gen)};
+      p3 = p1 + (p2 - p1) * coord(gen) + offset;
+    }
+    auto ps = std::array{BasicPoint<T>(p1), BasicPoint<T>(p2),
+                         BasicPoint<T>(p3)};
+    // Triangles, which are degenerate in T or in double, are not allowed
+    auto valid = [&](auto const &a, auto const &b, auto const &c) {
+      auto d1 = dist(a, b);
+      auto d2 = dist(b, c);
+      auto d3 = dist(c, a);
+      return d1 + d2 > d3 && d2 + d3 > d1 && d3 + d1 > d2 &&
+             n(cross(a - c, b - c)) > EPSMIN;
+    };
+    if (!valid(ps[0], ps[1], ps[2]) ||
+        !valid(Point(ps[0]), Point(ps[1]), Point(ps[2])))
+      continue;
+    triangles.emplace_back(Point(ps[0]), Point(ps[1]), Point(ps[2]));
+  }
+  return triangles;
+}
+
+// Lanes of the batch kernel, which disagree with scalar intersects, and
+// intersecting pairs
+template <typename T, std::size_t W>
+std::pair<std::size_t, std::size_t>
+batch_mismatches(std::span<Triangle const> queries,
+                 TriangleBatch<T> const &batch) {
+  std::size_t mismatches = 0;
+  std::size_t hits = 0;
+  for (auto const &t : queries) {
+    for (std::size_t first = 0; first < batch.size(); first += W) {
+      auto bits = intersects<T, W>(t, batch, first);
+      for (std::size_t lane = 0; lane < W; ++lane) {
+        auto i = first + lane;
+        auto bit = ((bits >> lane) & 1U) != 0;
+        auto expected = i < batch.size() && intersects(t, batch[i]);
+        mismatches += bit != expected ? 1 : 0;
+        hits += expected ? 1 : 0;
+      }
+    }
+  }
+  return {mismatches, hits};
+}
+
+template <typename T, std::size_t W> void batch_check() {
+  auto gen = std::mt19937{0};
+  auto triangles = random_triangles(203, gen);
+  // Queries are representable in T, so they take the SIMD path, except for
+  // the last two
+  auto queries = std::vector<Triangle>{};
+  for (auto const &t : random_triangles(40, gen))
+    queries.emplace_back(BasicTriangle<T>(t));
+  // Touching and coplanar cases, which go to the scalar path
+  triangles.emplace_back(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
+                         Point{0.0, 1.0, 0.0});
+  triangles.emplace_back(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
+                         Point{0.0, 0.0, 1.0});
+  queries.emplace_back(Point{0.5, 0.0, 0.0}, Point{1.5, 0.0, 0.0},
+                       Point{0.5, 1.0, 0.0});
+  queries.emplace_back(Point{0.2, 0.2, 0.0}, Point{0.5, 0.2, 0.0},
+                       Point{0.2, 0.5, 0.0});
+  auto batch = TriangleBatch<T>(triangles);
+  BOOST_TEST(batch.size() == triangles.size());
+
+  auto [mismatches, hits] =
+      batch_mismatches<T, W>(std::span<Triangle const>{queries}, batch);
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(hits > queries.size());
+
+  auto found = std::vector<std::size_t>{};
+  for_each_intersecting(queries.back(), batch,
+                        [&](std::size_t i) { found.push_back(i); });
+  auto expected = std::vector<std::size_t>{};
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    if (intersects(queries.back(), batch[i]))
+      expected.push_back(i);
+  }
+  BOOST_TEST(!expected.empty());
+  BOOST_TEST((found == expected));
+}
+
+// Nearly complanar triangles and slivers, where rounded plane normals are far
+// from the exact ones
+template <typename T, std::size_t W> void batch_near_plane_check() {
+  auto gen = std::mt19937{4};
+  auto triangles = near_plane_triangles<T>(301, gen);
+  auto queries = near_plane_triangles<T>(60, gen);
+  auto batch = TriangleBatch<T>(triangles);
+  auto [mismatches, hits] =
+      batch_mismatches<T, W>(std::span<Triangle const>{queries}, batch);
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(hits > queries.size());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(orientation_engine_test) {
+  auto gen = std::mt19937{1};
+  auto triangles = random_triangles(300, gen);
+  std::size_t hits = 0;
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    for (std::size_t j = i + 1; j < triangles.size(); ++j) {
+      auto expected = intersection(triangles[i], triangles[j]).has_value();
+      mismatches += intersects(triangles[i], triangles[j]) != expected;
+      mismatches += intersects(triangles[j], triangles[i]) != expected;
+      hits += expected ? 1 : 0;
+    }
+  }
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(hits > triangles.size());
+}
+
+BOOST_AUTO_TEST_CASE(prepared_triangle_test) {
+  constexpr Triangle t1(Point{0.0, 0.0, 0.0}, Point{1.0, 0.0, 0.0},
+                        Point{0.0, 1.0, 0.0});
+  constexpr Triangle t2(Point{0.2, 0.2, 0.0}, Point{0.2, 0.3, 1.0},
+                        Point{1.0, 1.0, 1.0});
+  constexpr Triangle t3(Point{0.2, 0.2, 0.1}, Point{0.2, 0.3, 1.0},
+                        Point{1.0, 1.0, 1.0});
+  static_assert(PreparedTriangle{t1}.axis() == 2);
+  static_assert(intersects(PreparedTriangle{t1}, PreparedTriangle{t2}));
+  static_assert(!intersects(PreparedTriangle{t1}, PreparedTriangle{t3}));
+  // Touching at a vertex gives a degenerate segment
+  constexpr auto touch =
+      intersection(PreparedTriangle{t1}, PreparedTriangle{t2});
+  static_assert(touch && n(touch->s - t2[0]) == 0.0 &&
+                n(touch->e - t2[0]) == 0.0);
+
+  auto gen = std::mt19937{3};
+  auto triangles = random_triangles(300, gen);
+  auto prepared = std::vector<PreparedTriangle>{};
+  for (auto const &t : triangles)
+    prepared.emplace_back(t);
+  std::size_t mismatches = 0;
+  auto diff = 0.0;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    for (std::size_t j = i + 1; j < triangles.size(); ++j) {
+      auto expected = intersection(triangles[i], triangles[j]);
+      auto actual = intersection(prepared[i], prepared[j]);
+      mismatches += intersects(prepared[i], prepared[j]) !=
+                    intersects(triangles[i], triangles[j]);
+      mismatches += expected.has_value() != actual.has_value();
+      if (!expected || !actual)
+        continue;
+      // Ends may come in any order
+      auto [s, e] = *actual;
+      if (n(s - expected->s) > n(e - expected->s))
+        std::swap(s, e);
+      diff = std::max({diff, n(s - expected->s), n(e - expected->e)});
+    }
+  }
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(diff < 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(complanar_test) {
+  // Triangles of the plane z = x
+  constexpr Triangle big(Point{0.0, 0.0, 0.0}, Point{4.0, 0.0, 4.0},
+                         Point{0.0, 4.0, 0.0});
+  constexpr Triangle inside(Point{1.0, 1.0, 1.0}, Point{2.0, 1.0, 2.0},
+                            Point{1.0, 2.0, 1.0});
+  // Bounding boxes overlap, triangles do not
+  constexpr Triangle outside(Point{2.5, 2.5, 2.5}, Point{3.0, 2.5, 3.0},
+                             Point{2.5, 3.0, 2.5});
+  // Shares a part of the hypotenuse of big from the other side
+  constexpr Triangle edge(Point{3.0, 1.0, 3.0}, Point{1.0, 3.0, 1.0},
+                          Point{4.0, 4.0, 4.0});
+  static_assert(intersects(big, inside) && intersects(inside, big));
+  static_assert(!intersects(big, outside) && !intersects(outside, big));
+  static_assert(intersects(big, edge) && intersects(edge, big));
+  static_assert(!intersects(inside, edge));
+  static_assert(intersects(PreparedTriangle{inside}, PreparedTriangle{big}));
+  static_assert(
+      !intersects(PreparedTriangle{outside}, PreparedTriangle{big}));
+
+  auto gen = std::mt19937{4};
+  std::size_t mismatches = 0;
+  for (auto const &t : random_triangles(300, gen)) {
+    mismatches += !intersects(t, t);
+    mismatches += !intersects(PreparedTriangle{t}, PreparedTriangle{t});
+    auto f = BasicTriangle<float>(t);
+    mismatches += !intersects(f, f);
+  }
+  BOOST_TEST(mismatches == 0U);
+
+  // Separating axes agree with edge tests and containment on small integer
+  // coordinates, which give plenty of touching and degenerate triangles
+  using details_::Triangle2d;
+  auto reference = [](Triangle2d const &t1, Triangle2d const &t2) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      for (std::size_t j = 0; j < 3; ++j) {
+        if (details_::segments_intersect(t1[i], t1[(i + 1) % 3], t2[j],
+                                         t2[(j + 1) % 3]))
+          return true;
+      }
+    }
+    auto s1 = orient2d(t1[0], t1[1], t1[2]);
+    auto s2 = orient2d(t2[0], t2[1], t2[2]);
+    return (s1 != 0 && details_::contains(t1, s1, t2[0])) ||
+           (s2 != 0 && details_::contains(t2, s2, t1[0]));
+  };
+  auto coord = std::uniform_int_distribution<int>{0, 4};
+  auto point = [&] {
+    return Point2d{static_cast<double>(coord(gen)),
+                   static_cast<double>(coord(gen))};
+  };
+  std::size_t hits = 0;
+  for (std::size_t i = 0; i < 20000; ++i) {
+    auto t1 = Triangle2d{point(), point(), point()};
+    auto t2 = Triangle2d{point(), point(), point()};
+    auto expected = reference(t1, t2);
+    mismatches += details_::triangles_overlap(t1, t2) != expected;
+    hits += expected ? 1 : 0;
+  }
+  BOOST_TEST(mismatches == 0U);
+  BOOST_TEST(hits > 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(float_triangle_test) {
+  using TriangleF = BasicTriangle<float>;
+  static_assert(sizeof(TriangleF) * 2 == sizeof(Triangle));
+  constexpr TriangleF t1(BasicPoint<float>{0.0F, 0.0F, 0.0F},
+                         BasicPoint<float>{1.0F, 0.0F, 0.0F},
+                         BasicPoint<float>{0.0F, 1.0F, 0.0F});
+  // The first vertex of t2 lies inside t1, so they touch. Its distance to
+  // the plane of t1 is not certified in float, and the pair is decided by
+  // exact predicates
+  constexpr TriangleF t2(BasicPoint<float>{0.1F, 0.1F, 0.0F},
+                         BasicPoint<float>{0.1F, 0.3F, 1.0F},
+                         BasicPoint<float>{1.0F, 1.0F, 1.0F});
+  static_assert(intersects(t1, t2) && intersects(t2, t1));
+  static_assert(intersection(t1, t2).has_value());
+
+  // Float triangles give exactly the same answers as double triangles with
+  // the same coordinates
+  auto gen = std::mt19937{2};
+  auto triangles = random_triangles(200, gen);
+  auto floats = std::vector<TriangleF>{};
+  auto doubles = std::vector<Triangle>{};
+  for (auto const &t : triangles) {
+    floats.emplace_back(t);
+    doubles.emplace_back(floats.back());
+  }
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < floats.size(); ++i) {
+    for (std::size_t j = i + 1; j < floats.size(); ++j)
+      mismatches += intersects(floats[i], floats[j]) !=
+                    intersects(doubles[i], doubles[j]);
+  }
+  BOOST_TEST(mismatches == 0U);
+  // The same for nearly complanar triangles and slivers, which the float
+  // filter mostly leaves to double
+  auto near = near_plane_triangles<float>(200, gen);
+  for (std::size_t i = 0; i < near.size(); ++i) {
+    for (std::size_t j = i + 1; j < near.size(); ++j)
+      mismatches += intersects(TriangleF(near[i]), TriangleF(near[j])) !=
+                    intersects(near[i], near[j]);
+  }
+  BOOST_TEST(mismatches == 0U);
+
+  auto batch = TriangleBatch<float>(std::span<TriangleF const>{floats});
+  auto found = std::vector<std::size_t>{};
+  for_each_intersecting(floats.front(), batch,
+                        [&](std::size_t i) { found.push_back(i); });
+  auto expected = std::vector<std::size_t>{};
+  for (std::size_t i = 0; i < doubles.size(); ++i) {
+    if (intersects(doubles.front(), doubles[i]))
+      expected.push_back(i);
+  }
+  BOOST_TEST((found == expected));
+}
+
+BOOST_AUTO_TEST_CASE(triangle_batch_test) {
+  batch_check<double, 4>();
+  batch_check<double, simd::native_width<double>>();
+  batch_check<float, 8>();
+  batch_check<float, simd::native_width<float>>();
+}
+
+BOOST_AUTO_TEST_CASE(triangle_batch_near_plane_test) {
+  batch_near_plane_check<double, 4>();
+  batch_near_plane_check<double, simd::native_width<double>>();
+  batch_near_plane_check<float, 8>();
+  batch_near_plane_check<float, simd::native_width<float>>();
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 // NOLINTEND(cppcoreguidelines-pro-type-vararg)
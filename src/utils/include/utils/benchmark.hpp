@@ -0,0 +1,413 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_contests {
+
+// Micro-benchmarking. A benchmark is calibrated to run long enough to be
+// timed precisely, warmed up, then timed in several samples, which give the
+// median time with its confidence interval and percentiles. Results of the
+// benchmarked function are kept from the optimizer by do_not_optimize().
+
+namespace details_ {
+inline void const volatile *benchmark_sink = nullptr; // NOLINT
+} // namespace details_
+
+// Makes the compiler assume the value is read, so computing it is not dropped
+template <typename T> void do_not_optimize(T const &value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  details_::benchmark_sink = &value;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Makes the compiler assume all memory is read and written here, so stores
+// before it are not dropped and loads after it are not hoisted
+inline void clobber() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#else
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Hardware counters of the calling thread and of threads it starts after
+// the counters are made, by Linux perf_event_open. Threads started before,
+// such as workers of a pool used earlier, are not counted. Events, which the
+// kernel or the machine do not provide, stay unavailable, as do all of them
+// on other systems.
+class PerfCounters final {
+public:
+  static constexpr std::size_t count = 4;
+  static constexpr std::array<std::string_view, count> names = {
+      "cycles", "instructions", "cache_misses", "branch_misses"};
+  using Values = std::array<std::optional<double>, count>;
+
+private:
+  std::array<int, count> fds_ = {-1, -1, -1, -1};
+
+public:
+  PerfCounters() {
+#if defined(__linux__)
+    constexpr std::array<std::uint64_t, count> events = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (std::size_t i = 0; i < count; ++i) {
+      auto attr = perf_event_attr{};
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = events[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.inherit = 1;
+      // Counters multiplexed with others are scaled by times they ran
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+      fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                         -1, 0UL));
+    }
+#endif
+  }
+  PerfCounters(PerfCounters const &) = delete;
+  PerfCounters(PerfCounters &&) = delete;
+  PerfCounters &operator=(PerfCounters const &) = delete;
+  PerfCounters &operator=(PerfCounters &&) = delete;
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (auto fd : fds_) {
+      if (fd >= 0)
+        close(fd);
+    }
+#endif
+  }
+
+  [[nodiscard]] bool available() const noexcept {
+    return std::ranges::any_of(fds_, [](int fd) { return fd >= 0; });
+  }
+
+  // Resets and enables counters
+  void start() noexcept {
+#if defined(__linux__)
+    for (auto fd : fds_) {
+      if (fd >= 0) {
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-vararg)
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        // NOLINTEND(cppcoreguidelines-pro-type-vararg)
+      }
+    }
+#endif
+  }
+
+  // Disables counters and reads events counted since start()
+  Values stop() noexcept {
+    auto values = Values{};
+#if defined(__linux__)
+    for (auto fd : fds_) {
+      if (fd >= 0)
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); // NOLINT
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      // Value, time enabled and time running
+      auto data = std::array<std::uint64_t, 3>{};
+      if (fds_[i] < 0 ||
+          read(fds_[i], data.data(), sizeof(data)) !=
+              static_cast<ssize_t>(sizeof(data)) ||
+          data[2] == 0)
+        continue;
+      values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) /
+                  static_cast<double>(data[2]);
+    }
+#endif
+    return values;
+  }
+};
+
+struct BenchmarkOptions {
+  // Iterations of a sample are calibrated to take at least this long
+  std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{10};
+  std::size_t samples = 20;
+  // Time the benchmark is run before samples, at least once
+  std::chrono::nanoseconds warmup = std::chrono::milliseconds{50};
+  // Samples stop early, when the benchmark takes longer than this. A first
+  // run longer than the budget is the only sample.
+  std::chrono::nanoseconds budget = std::chrono::seconds{2};
+  bool counters = false;
+};
+
+// Times are per iteration in nanoseconds. The median is bracketed by its
+// 95% confidence interval, taken from order statistics of samples, so it
+// needs no assumptions about their distribution. The minimum is the least
+// noisy estimate of the cost, when the variance comes from interruptions.
+struct BenchmarkResult {
+  std::string name;
+  // Items processed by one iteration, for throughput
+  std::size_t items = 1;
+  std::size_t iterations = 0;
+  std::vector<double> samples;
+  double min = 0;
+  double median = 0;
+  double median_low = 0;
+  double median_high = 0;
+  double mean = 0;
+  double stddev = 0;
+  double p10 = 0;
+  double p90 = 0;
+  double p99 = 0;
+  // Events per iteration
+  PerfCounters::Values counters;
+};
+
+namespace details_ {
+
+// Percentile of sorted values interpolated linearly between closest ranks
+inline double percentile(std::vector<double> const &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  auto rank = p / 100 * static_cast<double>(sorted.size() - 1);
+  auto low = static_cast<std::size_t>(rank);
+  auto high = std::min(low + 1, sorted.size() - 1);
+  auto fraction = rank - static_cast<double>(low);
+  return sorted[low] + fraction * (sorted[high] - sorted[low]);
+}
+
+inline void compute_statistics(BenchmarkResult &result) {
+  auto sorted = result.samples;
+  std::ranges::sort(sorted);
+  auto n = sorted.size();
+  if (n == 0)
+    return;
+  result.min = sorted.front();
+  result.median = percentile(sorted, 50);
+  result.p10 = percentile(sorted, 10);
+  result.p90 = percentile(sorted, 90);
+  result.p99 = percentile(sorted, 99);
+  auto sum = 0.0;
+  for (auto x : sorted)
+    sum += x;
+  result.mean = sum / static_cast<double>(n);
+  auto squares = 0.0;
+  for (auto x : sorted)
+    squares += (x - result.mean) * (x - result.mean);
+  result.stddev = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0;
+  // One-based ranks n/2 - 1.96 sqrt(n)/2 and 1 + n/2 + 1.96 sqrt(n)/2 from
+  // the normal approximation to the binomial distribution of the number of
+  // samples below the true median
+  constexpr auto z = 1.96;
+  auto half = z * std::sqrt(static_cast<double>(n)) / 2;
+  auto middle = static_cast<double>(n) / 2;
+  auto low = static_cast<std::size_t>(std::max(1.0, std::floor(middle - half)));
+  auto high = std::min(
+      n, static_cast<std::size_t>(std::ceil(1 + middle + half)));
+  result.median_low = sorted[low - 1];
+  result.median_high = sorted[high - 1];
+}
+
+inline std::string json_escape(std::string_view text) {
+  auto result = std::string{};
+  for (auto c : text) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      result += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+} // namespace details_
+
+// Runs benchmarks and collects their results
+class Benchmarker final {
+  BenchmarkOptions options_;
+  std::optional<PerfCounters> counters_;
+  std::vector<BenchmarkResult> results_;
+
+public:
+  explicit Benchmarker(BenchmarkOptions options = {}) : options_{options} {
+    if (options_.counters)
+      counters_.emplace();
+    options_.samples = std::max(options_.samples, std::size_t{1});
+  }
+
+  [[nodiscard]] BenchmarkOptions const &options() const noexcept {
+    return options_;
+  }
+  [[nodiscard]] std::vector<BenchmarkResult> const &results() const noexcept {
+    return results_;
+  }
+  [[nodiscard]] bool counters_available() const noexcept {
+    return counters_ && counters_->available();
+  }
+
+  // Times f(), which may return a value to be kept from the optimizer
+  template <std::invocable F>
+  BenchmarkResult const &run(std::string name, std::size_t items, F &&f) {
+    using Clock = std::chrono::steady_clock;
+    using Ns = std::chrono::duration<double, std::nano>;
+    auto iterate = [&](std::size_t iterations) {
+      auto start = Clock::now();
+      for (std::size_t i = 0; i < iterations; ++i) {
+        if constexpr (std::is_void_v<std::invoke_result_t<F &>>)
+          std::invoke(f);
+        else
+          do_not_optimize(std::invoke(f));
+      }
+      clobber();
+      return Ns{Clock::now() - start}.count();
+    };
+
+    auto result = BenchmarkResult{};
+    result.name = std::move(name);
+    result.items = items;
+    auto begin = Clock::now();
+    auto elapsed = [&] { return Clock::now() - begin; };
+    auto budget = Ns{options_.budget}.count();
+
+    // Warm-up estimates time of an iteration for calibration
+    auto warmup_runs = std::size_t{1};
+    auto warmup_time = iterate(1);
+    if (warmup_time >= budget) {
+      result.iterations = 1;
+      result.samples.push_back(warmup_time);
+      details_::compute_statistics(result);
+      return results_.emplace_back(std::move(result));
+    }
+    while (elapsed() < options_.warmup) {
+      warmup_time += iterate(warmup_runs);
+      warmup_runs *= 2;
+    }
+    // Runs of 1, 1, 2, 4 and so on iterations make warmup_runs in total
+    auto per_iteration = warmup_time / static_cast<double>(warmup_runs);
+    auto target = Ns{options_.min_sample_time}.count();
+    result.iterations = std::max(
+        std::size_t{1}, static_cast<std::size_t>(std::ceil(
+                            target / std::max(per_iteration, 1.0))));
+
+    auto totals = std::array<double, PerfCounters::count>{};
+    auto counted = std::array<std::size_t, PerfCounters::count>{};
+    auto start = Clock::now();
+    for (std::size_t s = 0; s < options_.samples; ++s) {
+      if (s != 0 && Clock::now() - start > options_.budget)
+        break;
+      if (counters_)
+        counters_->start();
+      auto time = iterate(result.iterations);
+      if (counters_) {
+        auto values = counters_->stop();
+        for (std::size_t c = 0; c < values.size(); ++c) {
+          if (values[c]) {
+            totals[c] += *values[c];
+            ++counted[c];
+          }
+        }
+      }
+      result.samples.push_back(time / static_cast<double>(result.iterations));
+    }
+    for (std::size_t c = 0; c < totals.size(); ++c) {
+      if (counted[c] != 0)
+        result.counters[c] =
+            totals[c] / static_cast<double>(counted[c] * result.iterations);
+    }
+    details_::compute_statistics(result);
+    return results_.emplace_back(std::move(result));
+  }
+  template <std::invocable F>
+  BenchmarkResult const &run(std::string name, F &&f) {
+    return run(std::move(name), 1, std::forward<F>(f));
+  }
+
+  // Writes results with a description of the build, so results of different
+  // builds and machines can be told apart when compared
+  void write_json(std::ostream &out) const {
+    out << "{\n  \"build\": {";
+#ifdef __VERSION__
+    out << "\"compiler\": \"" << details_::json_escape(__VERSION__) << "\", ";
+#endif
+#ifdef NDEBUG
+    out << "\"assertions\": false";
+#else
+    out << "\"assertions\": true";
+#endif
+    out << "},\n";
+    out << fmt::format(
+        "  \"options\": {{\"min_sample_time_ns\": {}, \"samples\": {}, "
+        "\"warmup_ns\": {}, \"budget_ns\": {}, \"counters\": {}}},\n",
+        options_.min_sample_time.count(), options_.samples,
+        options_.warmup.count(), options_.budget.count(),
+        counters_available());
+    out << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+      auto const &r = results_[i];
+      out << (i == 0 ? "\n" : ",\n")
+          << fmt::format(
+                 "    {{\"name\": \"{}\", \"items\": {}, \"iterations\": {}, "
+                 "\"samples\": {}, \"min_ns\": {}, \"median_ns\": {}, "
+                 "\"median_ci_ns\": [{}, {}], \"mean_ns\": {}, "
+                 "\"stddev_ns\": {}, \"p10_ns\": {}, \"p90_ns\": {}, "
+                 "\"p99_ns\": {}, \"items_per_s\": {}",
+                 details_::json_escape(r.name), r.items, r.iterations,
+                 r.samples.size(), r.min, r.median, r.median_low,
+                 r.median_high, r.mean, r.stddev, r.p10, r.p90, r.p99,
+                 r.median > 0 ? static_cast<double>(r.items) * 1e9 / r.median
+                              : 0.0);
+      for (std::size_t c = 0; c < PerfCounters::count; ++c) {
+        if (r.counters[c])
+          out << fmt::format(", \"{}\": {}", PerfCounters::names[c],
+                             *r.counters[c]);
+      }
+      out << "}";
+    }
+    out << "\n  ]\n}\n";
+  }
+};
+
+// Mean time of NRuns back to back calls, for quick checks. Prefer
+// Benchmarker for numbers to be trusted.
+template <std::size_t NRuns = 1, typename FG, typename... Args>
+  requires std::invocable<FG const &, Args &...>
+std::chrono::nanoseconds benchmark(FG const &Func, Args &&...args) {
+  auto start = std::chrono::steady_clock::now();
+  for (auto i = std::size_t{0}; i != NRuns; ++i) {
+    if constexpr (std::is_void_v<std::invoke_result_t<FG const &, Args &...>>)
+      Func(args...);
+    else
+      do_not_optimize(Func(args...));
+  }
+  clobber();
+  auto end = std::chrono::steady_clock::now();
+  return (end - start) / NRuns;
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+// Applying permutations: afterwards v[i] holds what was v[Index(perm[i])],
+// which is how sort permutations are applied.
+//
+// permute() rotates every cycle of the permutation once starting from its
+// first element, moving each element exactly once and taking no O(n)
+// buffer. Visited elements are marked in the top bit of unsigned indices
+// when that bit is spare, otherwise a bit per element is allocated. perm is
+// left as it was.
+//
+// permute_into() writes the result to another container. Reads of v are
+// random either way, but cycle walks wait for one cache miss after another,
+// while here reads do not depend on each other: blocks of the output are
+// gathered with reads prefetched ahead, so misses overlap. On large arrays it
+// is an order of magnitude faster, prefer it when there is memory for a copy.
+
+namespace details_ {
+
+template <typename Vector>
+using PermutedType =
+    std::remove_cvref_t<decltype(std::declval<Vector &>()[0])>;
+
+template <typename Vector>
+void prefetch(Vector const &v, std::size_t i) noexcept {
+  if constexpr (std::is_lvalue_reference_v<decltype(v[i])>) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(std::addressof(v[i]));
+#endif
+  }
+}
+
+// Elements of a permutation, which has the top bit of its unsigned indices
+// spare, are marked there
+template <typename Indexer, typename IndexFunction>
+constexpr bool marks_in_indices_v =
+    std::unsigned_integral<Indexer> &&
+    std::is_same_v<IndexFunction, std::identity>;
+
+template <typename VectorIndexers, typename IndexFunction>
+class PermutationMarks final {
+  using Indexer = typename VectorIndexers::value_type;
+  static constexpr bool in_indices_ =
+      marks_in_indices_v<Indexer, IndexFunction>;
+  static constexpr auto mark_ = [] {
+    if constexpr (in_indices_)
+      return Indexer{1} << (std::numeric_limits<Indexer>::digits - 1);
+    else
+      return std::size_t{0};
+  }();
+
+  VectorIndexers &perm_;
+  IndexFunction const &index_;
+  std::vector<bool> marks_;
+
+public:
+  PermutationMarks(VectorIndexers &perm, IndexFunction const &index)
+      : perm_{perm}, index_{index} {
+    if (!in_indices())
+      marks_.resize(perm_.size());
+  }
+  PermutationMarks(PermutationMarks const &) = delete;
+  PermutationMarks(PermutationMarks &&) = delete;
+  PermutationMarks &operator=(PermutationMarks const &) = delete;
+  PermutationMarks &operator=(PermutationMarks &&) = delete;
+  ~PermutationMarks() = default;
+
+  [[nodiscard]] bool in_indices() const noexcept {
+    if constexpr (in_indices_)
+      return perm_.size() <= mark_;
+    else
+      return false;
+  }
+
+  [[nodiscard]] std::size_t operator()(std::size_t i) const noexcept {
+    if constexpr (in_indices_) {
+      if (in_indices())
+        return static_cast<std::size_t>(perm_[i] & ~mark_);
+    }
+    return static_cast<std::size_t>(index_(perm_[i]));
+  }
+
+  [[nodiscard]] bool marked(std::size_t i) const noexcept {
+    if constexpr (in_indices_) {
+      if (in_indices())
+        return (perm_[i] & mark_) != 0;
+    }
+    return marks_[i];
+  }
+
+  void mark(std::size_t i) noexcept {
+    if constexpr (in_indices_) {
+      if (in_indices()) {
+        perm_[i] |= mark_;
+        return;
+      }
+    }
+    marks_[i] = true;
+  }
+
+  // Restores indices in [begin, end)
+  void clear(std::size_t begin, std::size_t end) noexcept {
+    if constexpr (in_indices_) {
+      if (in_indices()) {
+        for (auto i = begin; i < end; ++i)
+          perm_[i] &= ~mark_;
+      }
+    }
+  }
+};
+
+// Moves v[j] = v[index(j)] along the cycle, which leader is on, calling
+// visit(j) for all of its other elements
+template <typename Vector, typename IndexOf, typename Visit>
+void rotate_cycle(Vector &v, std::size_t leader, IndexOf const &index,
+                  Visit const &visit) {
+  auto first = std::move(v[leader]);
+  auto j = leader;
+  for (auto k = index(j); k != leader; k = index(j)) {
+    visit(k);
+    v[j] = std::move(v[k]);
+    j = k;
+  }
+  v[j] = std::move(first);
+}
+
+template <typename Vector, typename VectorIndexers, typename IndexFunction>
+void check_permutation([[maybe_unused]] Vector const &v,
+                       [[maybe_unused]] VectorIndexers const &perm,
+                       [[maybe_unused]] IndexFunction const &Index) {
+  using T = PermutedType<Vector>;
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+  static_assert(std::is_nothrow_move_assignable_v<T>);
+  static_assert(std::is_nothrow_invocable_v<
+                IndexFunction, typename VectorIndexers::value_type const &>);
+  assert(v.size() == perm.size());
+#ifndef NDEBUG
+  auto seen = std::vector<bool>(perm.size());
+  for (auto const &indexer : perm) {
+    auto i = static_cast<std::size_t>(Index(indexer));
+    assert(i < perm.size() && !seen[i]);
+    seen[i] = true;
+  }
+#endif // !NDEBUG
+}
+
+} // namespace details_
+
+template <typename Vector, typename VectorIndexers, typename IndexFunction>
+  requires std::invocable<IndexFunction const &,
+                          typename VectorIndexers::value_type const &>
+void permute(Vector &v, VectorIndexers &perm, IndexFunction const &Index) {
+  details_::check_permutation(v, perm, Index);
+  if constexpr (std::is_same_v<Vector, VectorIndexers>)
+    assert(&v != &perm);
+  auto n = v.size();
+  auto marks = details_::PermutationMarks<VectorIndexers, IndexFunction>{
+      perm, Index};
+  // Cycles of the elements before i are done, so the first element of a
+  // cycle met is its leader and the rest of the cycle lies after it
+  for (std::size_t i = 0; i < n; ++i) {
+    if (marks.marked(i) || marks(i) == i)
+      continue;
+    details_::rotate_cycle(v, i, marks,
+                           [&](std::size_t j) { marks.mark(j); });
+  }
+  marks.clear(0, n);
+}
+
+template <typename Vector, typename VectorIndexers>
+void permute(Vector &v, VectorIndexers &perm) {
+  permute(v, perm, std::identity{});
+}
+
+// The same by threads of the pool. Leaders of cycles are found by one
+// thread walking indices only, then cycles are rotated in parallel. Cycles
+// are the unit of work, so a random permutation, most of which is usually
+// one cycle, is not sped up much.
+template <typename Vector, typename VectorIndexers, typename IndexFunction>
+  requires std::invocable<IndexFunction const &,
+                          typename VectorIndexers::value_type const &>
+void permute(Vector &v, VectorIndexers &perm, IndexFunction const &Index,
+             ThreadPool &pool) {
+  details_::check_permutation(v, perm, Index);
+  if constexpr (std::is_same_v<Vector, VectorIndexers>)
+    assert(&v != &perm);
+  auto n = v.size();
+  auto marks = details_::PermutationMarks<VectorIndexers, IndexFunction>{
+      perm, Index};
+  auto leaders = std::vector<std::size_t>{};
+  for (std::size_t i = 0; i < n; ++i) {
+    if (marks.marked(i) || marks(i) == i)
+      continue;
+    leaders.push_back(i);
+    for (auto j = marks(i); j != i; j = marks(j))
+      marks.mark(j);
+  }
+  constexpr std::size_t chunks_per_worker = 8;
+  auto grain = leaders.size() / (pool.size() * chunks_per_worker);
+  pool.parallel_for(leaders.size(), grain,
+                    [&](std::size_t begin, std::size_t end,
+                        std::size_t /*worker*/) {
+                      for (auto l = begin; l < end; ++l)
+                        details_::rotate_cycle(v, leaders[l], marks,
+                                               [](std::size_t) {});
+                    });
+  grain = (n + pool.size() - 1) / pool.size();
+  pool.parallel_for(
+      n, grain,
+      [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+        marks.clear(begin, end);
+      });
+}
+
+template <typename Vector, typename VectorIndexers>
+void permute(Vector &v, VectorIndexers &perm, ThreadPool &pool) {
+  permute(v, perm, std::identity{}, pool);
+}
+
+namespace details_ {
+
+// Output is gathered in blocks, which are also the unit of parallel work
+constexpr std::size_t permute_block = 4096;
+// Reads are prefetched this many elements before they are done
+constexpr std::size_t permute_prefetch_distance = 16;
+
+template <typename Vector, typename VectorIndexers, typename Output,
+          typename IndexFunction>
+void permute_block_into(Vector const &v, VectorIndexers const &perm,
+                        Output &out, IndexFunction const &Index,
+                        std::size_t begin, std::size_t end) {
+  auto ahead = std::min(end, begin + permute_prefetch_distance);
+  for (auto i = begin; i < ahead; ++i)
+    prefetch(v, static_cast<std::size_t>(Index(perm[i])));
+  for (auto i = begin; i < end; ++i) {
+    if (i + permute_prefetch_distance < end)
+      prefetch(v, static_cast<std::size_t>(
+                      Index(perm[i + permute_prefetch_distance])));
+    out[i] = v[static_cast<std::size_t>(Index(perm[i]))];
+  }
+}
+
+} // namespace details_
+
+template <typename Vector, typename VectorIndexers, typename Output,
+          typename IndexFunction>
+  requires std::invocable<IndexFunction const &,
+                          typename VectorIndexers::value_type const &>
+void permute_into(Vector const &v, VectorIndexers const &perm, Output &out,
+                  IndexFunction const &Index) {
+  details_::check_permutation(v, perm, Index);
+  assert(out.size() == v.size());
+  for (std::size_t begin = 0; begin < v.size();
+       begin += details_::permute_block)
+    details_::permute_block_into(
+        v, perm, out, Index, begin,
+        std::min(v.size(), begin + details_::permute_block));
+}
+
+template <typename Vector, typename VectorIndexers, typename Output>
+void permute_into(Vector const &v, VectorIndexers const &perm, Output &out) {
+  permute_into(v, perm, out, std::identity{});
+}
+
+template <typename Vector, typename VectorIndexers, typename Output,
+          typename IndexFunction>
+  requires std::invocable<IndexFunction const &,
+                          typename VectorIndexers::value_type const &>
+void permute_into(Vector const &v, VectorIndexers const &perm, Output &out,
+                  IndexFunction const &Index, ThreadPool &pool) {
+  details_::check_permutation(v, perm, Index);
+  assert(out.size() == v.size());
+  pool.parallel_for(
+      v.size(), details_::permute_block,
+      [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+        details_::permute_block_into(v, perm, out, Index, begin, end);
+      });
+}
+
+template <typename Vector, typename VectorIndexers, typename Output>
+void permute_into(Vector const &v, VectorIndexers const &perm, Output &out,
+                  ThreadPool &pool) {
+  permute_into(v, perm, out, std::identity{}, pool);
+}
+
+} // namespace cpp_contests
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utils/thread_pool.hpp"
+
+namespace cpp_contests {
+
+// Keys ordered by their bits once mapped by radix_bits()
+template <typename T>
+concept RadixSortable =
+    (std::integral<T> && !std::is_same_v<T, bool>) ||
+    (std::floating_point<T> && std::numeric_limits<T>::is_iec559 &&
+     (sizeof(T) == 4 || sizeof(T) == 8));
+
+namespace details_ {
+
+template <std::size_t Size> struct UnsignedOfSize;
+template <> struct UnsignedOfSize<1> {
+  using Type = std::uint8_t;
+};
+template <> struct UnsignedOfSize<2> {
+  using Type = std::uint16_t;
+};
+template <> struct UnsignedOfSize<4> {
+  using Type = std::uint32_t;
+};
+template <> struct UnsignedOfSize<8> {
+  using Type = std::uint64_t;
+};
+
+template <RadixSortable T>
+using RadixBits = typename UnsignedOfSize<sizeof(T)>::Type;
+
+// Unsigned image of the key, which compares as the key does. Signed integers
+// get the sign bit flipped. Negative floats get all bits flipped and positive
+// ones the sign bit only, so -0 goes right before +0 and NaNs go to the ends.
+template <RadixSortable T>
+constexpr RadixBits<T> radix_bits(T key) noexcept {
+  using U = RadixBits<T>;
+  constexpr auto sign = U{1} << (std::numeric_limits<U>::digits - 1);
+  if constexpr (std::unsigned_integral<T>) {
+    return key;
+  } else if constexpr (std::integral<T>) {
+    return static_cast<U>(static_cast<U>(key) ^ sign);
+  } else {
+    auto bits = std::bit_cast<U>(key);
+    return bits & sign ? static_cast<U>(~bits) : bits | sign;
+  }
+}
+
+// Key and index sorted together, so that the permutation is built without
+// any indirect access to keys
+template <typename U, typename Index> struct RadixItem {
+  U key;
+  Index index;
+};
+
+constexpr std::size_t radix_digit_bits = 8;
+constexpr std::size_t radix_buckets = std::size_t{1} << radix_digit_bits;
+using RadixCounts = std::array<std::size_t, radix_buckets>;
+
+template <typename U>
+constexpr std::size_t radix_digit(U key, std::size_t d) noexcept {
+  return static_cast<std::size_t>(key >> (d * radix_digit_bits)) &
+         (radix_buckets - 1);
+}
+
+// Stable LSD sort of items by key_of(item), 8 bits per pass. All digit
+// counts are taken in one read, and digits equal in all items take no pass.
+// Passes ping-pong between items and buffer, result ends up in items.
+template <typename Item, typename KeyOf>
+void radix_sort(std::span<Item> items, std::span<Item> buffer,
+                KeyOf const &key_of) {
+  using U = std::invoke_result_t<KeyOf const &, Item const &>;
+  constexpr auto digits = sizeof(U) * 8 / radix_digit_bits;
+  assert(buffer.size() >= items.size());
+  auto counts = std::array<RadixCounts, digits>{};
+  for (auto const &item : items) {
+    auto key = key_of(item);
+    for (std::size_t d = 0; d < digits; ++d)
+      ++counts[d][radix_digit(key, d)];
+  }
+  auto from = items;
+  auto to = buffer.first(items.size());
+  for (std::size_t d = 0; d < digits; ++d) {
+    auto &count = counts[d];
+    if (std::ranges::find(count, items.size()) != count.end())
+      continue;
+    auto sum = std::size_t{0};
+    for (auto &c : count)
+      sum += std::exchange(c, sum);
+    for (auto const &item : from)
+      to[count[radix_digit(key_of(item), d)]++] = item;
+    std::swap(from, to);
+  }
+  if (from.data() != items.data())
+    std::ranges::copy(from, items.begin());
+}
+
+// Smaller inputs are sorted faster by one thread
+constexpr std::size_t parallel_radix_threshold = std::size_t{1} << 16U;
+
+// The same by threads of the pool. Items are split into one chunk per
+// worker. Each pass counts digits of every chunk, lays buckets out in digit
+// then chunk order, which keeps the sort stable, and scatters chunks to
+// their slots of buckets in parallel.
+template <typename Item, typename KeyOf>
+void radix_sort(std::span<Item> items, std::span<Item> buffer,
+                KeyOf const &key_of, ThreadPool &pool) {
+  using U = std::invoke_result_t<KeyOf const &, Item const &>;
+  constexpr auto digits = sizeof(U) * 8 / radix_digit_bits;
+  auto n = items.size();
+  if (n < parallel_radix_threshold || pool.size() == 1) {
+    radix_sort(items, buffer, key_of);
+    return;
+  }
+  assert(buffer.size() >= n);
+  auto grain = (n + pool.size() - 1) / pool.size();
+  auto nchunks = (n + grain - 1) / grain;
+
+  // Bits differing from the first key tell digits worth a pass
+  auto first = key_of(items.front());
+  auto differs = std::vector<U>(nchunks);
+  pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end,
+                                  std::size_t /*worker*/) {
+    auto bits = U{0};
+    for (auto i = begin; i < end; ++i)
+      bits |= static_cast<U>(key_of(items[i]) ^ first);
+    differs[begin / grain] = bits;
+  });
+  auto differ = U{0};
+  for (auto bits : differs)
+    differ |= bits;
+
+  auto counts = std::vector<RadixCounts>(nchunks);
+  auto from = items;
+  auto to = buffer.first(n);
+  for (std::size_t d = 0; d < digits; ++d) {
+    if (radix_digit(differ, d) == 0)
+      continue;
+    pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end,
+                                    std::size_t /*worker*/) {
+      auto &count = counts[begin / grain];
+      count.fill(0);
+      for (auto i = begin; i < end; ++i)
+        ++count[radix_digit(key_of(from[i]), d)];
+    });
+    auto sum = std::size_t{0};
+    for (std::size_t b = 0; b < radix_buckets; ++b) {
+      for (auto &count : counts)
+        sum += std::exchange(count[b], sum);
+    }
+    pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end,
+                                    std::size_t /*worker*/) {
+      auto &count = counts[begin / grain];
+      for (auto i = begin; i < end; ++i)
+        to[count[radix_digit(key_of(from[i]), d)]++] = from[i];
+    });
+    std::swap(from, to);
+  }
+  if (from.data() != items.data()) {
+    pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end,
+                                    std::size_t /*worker*/) {
+      std::copy(from.begin() + static_cast<std::ptrdiff_t>(begin),
+                from.begin() + static_cast<std::ptrdiff_t>(end),
+                items.begin() + static_cast<std::ptrdiff_t>(begin));
+    });
+  }
+}
+
+// Calls f(begin, end) over chunks of [0, n), by threads of the pool if any
+template <typename F>
+void radix_for(std::size_t n, F const &f, ThreadPool *pool) {
+  if (pool == nullptr || n < parallel_radix_threshold) {
+    f(std::size_t{0}, n);
+    return;
+  }
+  pool->parallel_for(
+      n, (n + pool->size() - 1) / pool->size(),
+      [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+        f(begin, end);
+      });
+}
+
+template <std::unsigned_integral Index, RadixSortable T>
+std::vector<Index> radix_sort_permutation(std::span<T const> keys,
+                                          ThreadPool *pool) {
+  using Item = RadixItem<RadixBits<T>, Index>;
+  assert(keys.empty() ||
+         keys.size() - 1 <= std::size_t{std::numeric_limits<Index>::max()});
+  auto n = keys.size();
+  auto items = std::vector<Item>(n);
+  radix_for(
+      n,
+      [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+          items[i] = {radix_bits(keys[i]), static_cast<Index>(i)};
+      },
+      pool);
+  {
+    auto buffer = std::vector<Item>(n);
+    auto key_of = [](Item const &item) { return item.key; };
+    if (pool != nullptr)
+      radix_sort(std::span<Item>{items}, std::span<Item>{buffer}, key_of,
+                 *pool);
+    else
+      radix_sort(std::span<Item>{items}, std::span<Item>{buffer}, key_of);
+  }
+  auto permutation = std::vector<Index>(n);
+  radix_for(
+      n,
+      [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+          permutation[i] = items[i].index;
+      },
+      pool);
+  return permutation;
+}
+
+} // namespace details_
+
+// Stable sort of integer or floating point keys in O(n) passes over them
+template <RadixSortable T> void radix_sort(std::span<T> keys) {
+  auto buffer = std::vector<T>(keys.size());
+  details_::radix_sort(keys, std::span<T>{buffer}, &details_::radix_bits<T>);
+}
+template <RadixSortable T>
+void radix_sort(std::span<T> keys, ThreadPool &pool) {
+  auto buffer = std::vector<T>(keys.size());
+  details_::radix_sort(keys, std::span<T>{buffer}, &details_::radix_bits<T>,
+                       pool);
+}
+
+// Stable sort permutation of keys: keys[p[0]], keys[p[1]], ... go in
+// ascending order. Keys and indices are sorted together, so no key is read
+// by index. Index type narrower than size_t makes sorting traffic smaller.
+template <std::unsigned_integral Index = std::size_t, RadixSortable T>
+std::vector<Index> radix_sort_permutation(std::span<T const> keys) {
+  return details_::radix_sort_permutation<Index>(keys, nullptr);
+}
+template <std::unsigned_integral Index = std::size_t, RadixSortable T>
+std::vector<Index> radix_sort_permutation(std::span<T const> keys,
+                                          ThreadPool &pool) {
+  return details_::radix_sort_permutation<Index>(keys, &pool);
+}
+
+} // namespace cpp_contests
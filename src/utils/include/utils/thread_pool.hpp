@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace cpp_contests {
+
+// Pool of threads with work stealing.
+// Every worker owns a queue of tasks. Owner takes tasks from the front of its
+// queue, while idle workers steal from the back of other queues. Thus
+// contiguous pieces of work stay on the same thread unless someone is idle.
+class ThreadPool final {
+public:
+  // Task receives index of the worker, which runs it
+  using Task = std::function<void(std::size_t)>;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t pending_ = 0;
+  bool stop_ = false;
+  std::atomic<std::size_t> next_queue_ = 0;
+  std::vector<std::jthread> workers_;
+
+public:
+  explicit ThreadPool(std::size_t nthreads = default_size()) {
+    nthreads = std::max(nthreads, std::size_t{1});
+    queues_.reserve(nthreads);
+    for (std::size_t i = 0; i < nthreads; ++i)
+      queues_.push_back(std::make_unique<Queue>());
+    workers_.reserve(nthreads);
+    for (std::size_t i = 0; i < nthreads; ++i)
+      workers_.emplace_back([this, i]() { work_(i); });
+  }
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+  ~ThreadPool() {
+    {
+      auto lock = std::scoped_lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    workers_.clear();
+  }
+
+  [[nodiscard]] static std::size_t default_size() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return queues_.size(); }
+
+  // Enqueues task to the given worker, or to the next one in round robin
+  void submit(Task task, std::optional<std::size_t> worker = std::nullopt) {
+    auto i = worker.value_or(next_queue_++) % size();
+    {
+      auto lock = std::scoped_lock(queues_[i]->mutex);
+      queues_[i]->tasks.push_back(std::move(task));
+    }
+    {
+      auto lock = std::scoped_lock(mutex_);
+      ++pending_;
+    }
+    cv_.notify_one();
+  }
+
+  // Calls f(begin, end, worker) for chunks of [0, n) and waits for all of
+  // them. Chunks are dealt to workers in contiguous blocks. First exception
+  // thrown by f is rethrown here. If queuing a chunk throws, chunks queued
+  // before it are finished and the exception is rethrown.
+  // Must not be called from a task of the same pool.
+  template <std::invocable<std::size_t, std::size_t, std::size_t> F>
+  void parallel_for(std::size_t n, std::size_t grain, F const &f) {
+    if (n == 0)
+      return;
+    grain = std::max(grain, std::size_t{1});
+    auto nchunks = (n + grain - 1) / grain;
+    auto done = std::latch(static_cast<std::ptrdiff_t>(nchunks));
+    auto exception = std::exception_ptr{};
+    auto exception_mutex = std::mutex{};
+    for (std::size_t chunk = 0; chunk < nchunks; ++chunk) {
+      auto begin = chunk * grain;
+      auto end = std::min(begin + grain, n);
+      auto owner = chunk * size() / nchunks;
+      auto task = [&, begin, end](std::size_t worker) {
+        try {
+          f(begin, end, worker);
+        } catch (...) {
+          auto lock = std::scoped_lock(exception_mutex);
+          if (!exception)
+            exception = std::current_exception();
+        }
+        done.count_down();
+      };
+      try {
+        submit(task, owner);
+      } catch (...) {
+        // Chunks already queued refer to locals, so they are waited for
+        done.count_down(static_cast<std::ptrdiff_t>(nchunks - chunk));
+        done.wait();
+        throw;
+      }
+    }
+    done.wait();
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+
+private:
+  std::optional<Task> pop_(std::size_t worker) {
+    {
+      auto &own = *queues_[worker];
+      auto lock = std::scoped_lock(own.mutex);
+      if (!own.tasks.empty()) {
+        auto task = std::move(own.tasks.front());
+        own.tasks.pop_front();
+        return task;
+      }
+    }
+    for (std::size_t i = 1; i < size(); ++i) {
+      auto &other = *queues_[(worker + i) % size()];
+      auto lock = std::scoped_lock(other.mutex);
+      if (!other.tasks.empty()) {
+        auto task = std::move(other.tasks.back());
+        other.tasks.pop_back();
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void work_(std::size_t worker) {
+    while (true) {
+      {
+        auto lock = std::unique_lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ || pending_ != 0; });
+        if (pending_ == 0)
+          return;
+        --pending_;
+      }
+      // Task is guaranteed to be somewhere, since we reserved it in pending_
+      auto task = std::optional<Task>{};
+      while (!(task = pop_(worker)))
+        std::this_thread::yield();
+      (*task)(worker);
+    }
+  }
+};
+
+inline ThreadPool &default_thread_pool() {
+  static auto pool = ThreadPool{};
+  return pool;
+}
+
+} // namespace cpp_contests
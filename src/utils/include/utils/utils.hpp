@@ -4,16 +4,20 @@
 #include <array>
 #include <atomic>
 #include <cassert>
-#include <chrono>
 #include <exception>
 #include <numeric>
 #include <random>
+#include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include <fmt/core.h>
 
+#include "utils/benchmark.hpp"
+#include "utils/permutation.hpp"
+#include "utils/radix_sort.hpp"
 #include "utils/type_traits.hpp"
 
 namespace cpp_contests {
@@ -51,55 +55,10 @@ template <std::size_t N> inline std::array<size_t, N> get_indices() {
   return indices;
 }
 
-template <typename Vector, typename VectorIndexers, typename IndexFunction>
-void permute(Vector &v, VectorIndexers &perm, IndexFunction const &Index) {
-  using T = typename Vector::value_type;
-  using Indexer = typename VectorIndexers::value_type;
-  static_assert(std::is_nothrow_swappable_v<T>);
-  static_assert(std::is_nothrow_swappable_v<Indexer>);
-  static_assert(std::is_nothrow_invocable_v<IndexFunction, Indexer>);
-  using std::swap;
-  assert(v.size() == perm.size());
-  if (v.size() == 0)
-    return;
-#ifndef NDEBUG
-  assert(std::unique(perm.begin(), perm.end(),
-                     [&](Indexer const &lhs, Indexer const &rhs) {
-                       return Index(lhs) == Index(rhs);
-                     }) == perm.end());
-  assert(Index(*std::min_element(perm.begin(), perm.end(),
-                                 [&](Indexer const &lhs, Indexer const &rhs) {
-                                   return lhs < rhs;
-                                 })) == 0);
-  assert(Index(*std::max_element(perm.begin(), perm.end(),
-                                 [&](Indexer const &lhs, Indexer const &rhs) {
-                                   return lhs < rhs;
-                                 })) == perm.size() - 1);
-  if constexpr (std::is_same_v<T, Indexer>) {
-    assert(&v != &perm);
-  }
-#endif // !NDEBUG
-
-  auto &&control = std::vector<size_t>(v.size());
-  std::iota(control.begin(), control.end(), size_t{0});
-  for (auto i = size_t{0}, e = v.size(); i != e; ++i) {
-    while (Index(perm[i]) != i) {
-      swap(control[i], control[Index(perm[i])]);
-      swap(perm[i], perm[Index(perm[i])]);
-    }
-  }
-  for (auto i = size_t{0}, e = v.size(); i != e; ++i) {
-    while (control[i] != i) {
-      swap(v[i], v[control[i]]);
-      swap(perm[i], perm[control[i]]);
-      swap(control[i], control[control[i]]);
-    }
-  }
-}
-
-template <typename Vector, typename VectorIndexers>
-void permute(Vector &v, VectorIndexers &perm) {
-  permute(v, perm, std::identity{});
+inline std::vector<size_t> get_indices(size_t n) {
+  auto indices = std::vector<size_t>(n);
+  std::iota(indices.begin(), indices.end(), size_t{0});
+  return indices;
 }
 
 template <typename Vector, typename Comparator>
@@ -112,9 +71,14 @@ std::vector<size_t> get_sort_permutation(Vector const &v,
   return permutation;
 }
 
+// Contiguous integers and floats are radix sorted, which is also stable
 template <typename Vector>
 std::vector<size_t> get_sort_permutation(Vector const &v) {
-  return get_sort_permutation(v, std::less<>{});
+  using T = std::ranges::range_value_t<Vector>;
+  if constexpr (RadixSortable<T> && std::ranges::contiguous_range<Vector>)
+    return radix_sort_permutation(std::span<T const>{v});
+  else
+    return get_sort_permutation(v, std::less<>{});
 }
 
 template <typename Generator = std::mt19937, unsigned seed = 0>
@@ -123,16 +87,6 @@ Generator &get_random_generator() {
   return generator;
 }
 
-template <size_t NRuns = 1, typename FG, typename... Args>
-std::chrono::nanoseconds benchmark(FG const &Func, Args &&...args) {
-  static_assert(CallableTraits<FG>::nArguments == sizeof...(args));
-  auto start = std::chrono::steady_clock::now();
-  for (auto i = size_t{0}; i != NRuns; ++i)
-    Func(std::forward<Args>(args)...);
-  auto end = std::chrono::steady_clock::now();
-  return (end - start) / NRuns;
-}
-
 template <typename T> class SaveRestore final {
   static_assert(std::is_nothrow_move_assignable_v<T>);
   static_assert(!std::is_reference_v<T>);
@@ -2,12 +2,25 @@
 // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
 
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #define BOOST_TEST_MODULE Test  // NOLINT
 #define _CRT_SECURE_NO_WARNINGS // NOLINT
 
 #include <boost/test/included/unit_test.hpp>
 
+#include "utils/benchmark.hpp"
 #include "utils/math.hpp"
+#include "utils/permutation.hpp"
+#include "utils/radix_sort.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/utils.hpp"
 
 using namespace cpp_contests;
@@ -53,5 +66,254 @@ constexpr bool sqrt_check() {
 
 BOOST_AUTO_TEST_CASE(sqrt_test) { static_assert(sqrt_check()); }
 
+BOOST_AUTO_TEST_CASE(thread_pool_test) {
+  constexpr std::size_t N = 100000;
+  constexpr std::size_t grain = 1000;
+  auto pool = ThreadPool{4};
+  BOOST_TEST(pool.size() == 4);
+
+  auto visits = std::vector<std::atomic<std::size_t>>(N);
+  auto workers = std::vector<std::atomic<std::size_t>>(pool.size());
+  pool.parallel_for(N, grain,
+                    [&](std::size_t begin, std::size_t end, std::size_t w) {
+                      for (auto i = begin; i < end; ++i)
+                        ++visits[i];
+                      ++workers[w];
+                    });
+  BOOST_TEST(std::all_of(visits.begin(), visits.end(),
+                         [](auto const &v) { return v == 1; }));
+  auto chunks = std::size_t{0};
+  for (auto const &w : workers)
+    chunks += w;
+  BOOST_TEST(chunks == N / grain);
+
+  BOOST_CHECK_THROW(
+      pool.parallel_for(N, grain,
+                        [](std::size_t begin, std::size_t, std::size_t) {
+                          if (begin == 0)
+                            throw std::runtime_error("test");
+                        }),
+      std::runtime_error);
+}
+
+namespace {
+
+template <typename T> std::vector<T> random_keys(std::size_t n) {
+  auto &gen = get_random_generator<std::mt19937_64>();
+  auto keys = std::vector<T>(n);
+  for (auto &key : keys) {
+    if constexpr (std::is_floating_point_v<T>)
+      key = std::uniform_real_distribution<T>{-1e3, 1e3}(gen);
+    else
+      key = static_cast<T>(gen());
+    // Many equal keys check stability
+    if (gen() % 4 == 0)
+      key = keys.front();
+  }
+  return keys;
+}
+
+template <typename T> void radix_sort_check(ThreadPool &pool) {
+  // Sizes below and above the threshold of the parallel sort
+  for (auto n : {std::size_t{0}, std::size_t{1}, std::size_t{1000},
+                 std::size_t{100000}}) {
+    auto keys = random_keys<T>(n);
+    auto expected = get_indices(n);
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&](auto i, auto j) { return keys[i] < keys[j]; });
+    auto span = std::span<T const>{keys};
+    BOOST_TEST(radix_sort_permutation(span) == expected);
+    BOOST_TEST(radix_sort_permutation(span, pool) == expected);
+    BOOST_TEST(get_sort_permutation(keys) == expected);
+    auto narrow = radix_sort_permutation<std::uint32_t>(span, pool);
+    BOOST_TEST(std::equal(narrow.begin(), narrow.end(), expected.begin(),
+                          expected.end()));
+
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    auto sequential = keys;
+    radix_sort(std::span<T>{sequential});
+    BOOST_TEST(sequential == sorted);
+    auto parallel = keys;
+    radix_sort(std::span<T>{parallel}, pool);
+    BOOST_TEST(parallel == sorted);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(radix_sort_test) {
+  auto pool = ThreadPool{4};
+  radix_sort_check<std::uint64_t>(pool);
+  radix_sort_check<std::int32_t>(pool);
+  radix_sort_check<std::int8_t>(pool);
+  radix_sort_check<float>(pool);
+  radix_sort_check<double>(pool);
+
+  // Extreme values and signed zeros
+  auto keys = std::vector<double>{
+      0.0, -0.0, std::numeric_limits<double>::infinity(), -1.0,
+      std::numeric_limits<double>::lowest(),
+      std::numeric_limits<double>::denorm_min(),
+      -std::numeric_limits<double>::infinity()};
+  radix_sort(std::span<double>{keys});
+  BOOST_TEST(std::is_sorted(keys.begin(), keys.end()));
+  BOOST_TEST(std::signbit(keys[3]));
+  BOOST_TEST(!std::signbit(keys[4]));
+  auto ints = std::vector<std::int64_t>{
+      5, std::numeric_limits<std::int64_t>::min(), -5, 0,
+      std::numeric_limits<std::int64_t>::max()};
+  radix_sort(std::span<std::int64_t>{ints});
+  BOOST_TEST(std::is_sorted(ints.begin(), ints.end()));
+}
+
+BOOST_AUTO_TEST_CASE(sort_permutation_test) {
+  BOOST_TEST(get_indices(0).empty());
+  BOOST_TEST((get_indices(3) == std::vector<std::size_t>{0, 1, 2}));
+  auto strings = std::vector<std::string>{"b", "c", "a"};
+  BOOST_TEST((get_sort_permutation(strings) ==
+              std::vector<std::size_t>{2, 0, 1}));
+  BOOST_TEST((get_sort_permutation(strings, std::greater<>{}) ==
+              std::vector<std::size_t>{1, 0, 2}));
+}
+
+namespace {
+
+template <typename Index>
+std::vector<Index> random_permutation(std::size_t n, std::size_t cycle) {
+  // Shuffled cycles of the given length, or one random permutation
+  auto perm = std::vector<Index>(n);
+  auto &gen = get_random_generator<std::mt19937_64>();
+  auto order = get_indices(n);
+  std::shuffle(order.begin(), order.end(), gen);
+  if (cycle == 0) {
+    std::copy(order.begin(), order.end(), perm.begin());
+    return perm;
+  }
+  for (std::size_t begin = 0; begin < n; begin += cycle) {
+    auto end = std::min(n, begin + cycle);
+    for (auto i = begin; i < end; ++i)
+      perm[order[i]] = static_cast<Index>(order[i + 1 == end ? begin : i + 1]);
+  }
+  return perm;
+}
+
+template <typename Index> void permute_check(ThreadPool &pool) {
+  // Sizes and lengths of cycles
+  using Case = std::pair<std::size_t, std::size_t>;
+  for (auto [n, cycle] : {Case{0, 0}, Case{1, 0}, Case{7, 1}, Case{200, 0},
+                          Case{1000, 0}, Case{100000, 0}, Case{100000, 3}}) {
+    if (n > std::size_t{std::numeric_limits<Index>::max()} + 1)
+      continue;
+    auto perm = random_permutation<Index>(n, cycle);
+    auto const original = perm;
+    auto values = std::vector<std::string>{};
+    for (std::size_t i = 0; i < perm.size(); ++i)
+      values.push_back(std::to_string(i) + std::string(20, 'x'));
+    auto expected = std::vector<std::string>(values.size());
+    for (std::size_t i = 0; i < perm.size(); ++i)
+      expected[i] = values[perm[i]];
+
+    auto sequential = values;
+    permute(sequential, perm);
+    BOOST_TEST((sequential == expected));
+    BOOST_TEST((perm == original));
+    auto parallel = values;
+    permute(parallel, perm, pool);
+    BOOST_TEST((parallel == expected));
+    BOOST_TEST((perm == original));
+    auto copy = std::vector<std::string>(values.size());
+    permute_into(values, perm, copy);
+    BOOST_TEST((copy == expected));
+    std::fill(copy.begin(), copy.end(), std::string{});
+    permute_into(values, perm, copy, pool);
+    BOOST_TEST((copy == expected));
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(permute_test) {
+  auto pool = ThreadPool{4};
+  permute_check<std::size_t>(pool);
+  permute_check<std::uint32_t>(pool);
+  // Indices of 200 elements take the top bit of std::uint8_t
+  permute_check<std::uint8_t>(pool);
+
+  // Indices inside of other data
+  auto keys = std::vector<int>{30, 10, 20};
+  auto perm = std::vector<std::pair<std::size_t, int>>{};
+  for (auto i : get_sort_permutation(keys))
+    perm.emplace_back(i, keys[i]);
+  auto index = [](auto const &p) noexcept { return p.first; };
+  permute(keys, perm, index);
+  BOOST_TEST((keys == std::vector<int>{10, 20, 30}));
+  permute(keys, perm, index, pool);
+  BOOST_TEST((keys == std::vector<int>{20, 30, 10}));
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_statistics_test) {
+  auto result = BenchmarkResult{};
+  for (int i = 20; i > 0; --i)
+    result.samples.push_back(i);
+  details_::compute_statistics(result);
+  BOOST_TEST(result.min == 1.0);
+  BOOST_TEST(result.median == 10.5);
+  BOOST_TEST(result.mean == 10.5);
+  auto const tol = boost::test_tools::tolerance(1e-12);
+  BOOST_TEST(result.p10 == 2.9, tol);
+  BOOST_TEST(result.p90 == 18.1, tol);
+  // Ranks 5 and 16 of 20
+  BOOST_TEST(result.median_low == 5.0);
+  BOOST_TEST(result.median_high == 16.0);
+
+  result.samples = {7.0};
+  details_::compute_statistics(result);
+  BOOST_TEST(result.median_low == 7.0);
+  BOOST_TEST(result.median_high == 7.0);
+  BOOST_TEST(result.stddev == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(benchmarker_test) {
+  using std::chrono::microseconds;
+  auto benchmarker = Benchmarker{BenchmarkOptions{
+      .min_sample_time = microseconds{200},
+      .samples = 5,
+      .warmup = microseconds{100},
+      .counters = true,
+  }};
+  auto data = std::vector<double>(1000, 1.0);
+  auto const &sum = benchmarker.run("sum", data.size(), [&] {
+    auto s = 0.0;
+    for (auto x : data)
+      s += x;
+    return s;
+  });
+  BOOST_TEST(sum.samples.size() == 5U);
+  BOOST_TEST(sum.iterations > 1U);
+  BOOST_TEST(sum.min > 0.0);
+  BOOST_TEST(sum.median_low <= sum.median);
+  BOOST_TEST(sum.median <= sum.median_high);
+
+  // Work longer than the budget is run once
+  auto slow = Benchmarker{BenchmarkOptions{.budget = microseconds{1}}};
+  auto const &once = slow.run(
+      "once", [] { std::this_thread::sleep_for(microseconds{10}); });
+  BOOST_TEST(once.iterations == 1U);
+  BOOST_TEST(once.samples.size() == 1U);
+
+  auto out = std::ostringstream{};
+  benchmarker.write_json(out);
+  BOOST_TEST(out.str().find("\"name\": \"sum\", \"items\": 1000") !=
+             std::string::npos);
+  BOOST_TEST(details_::json_escape("a\"\\\n\x01") ==
+             "a\\\"\\\\\\u000a\\u0001");
+
+  // Generic callables are accepted
+  auto mean = benchmark<3>([](auto const &v) { return v.size(); }, data);
+  BOOST_TEST(mean.count() >= 0);
+  do_not_optimize(data);
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 // NOLINTEND(cppcoreguidelines-pro-type-vararg)